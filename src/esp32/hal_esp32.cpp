@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include <driver/gpio.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+#include <soc/soc_caps.h>
+#include <sys/time.h>
+
+#include "relay/hal.h"
+
+namespace relay_controller {
+namespace hal {
+
+uint64_t now_us() { return esp_timer_get_time(); }
+
+uint64_t wall_time_us() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  // Until SNTP has run the clock counts from 1970.
+  if (tv.tv_sec < 1600000000) {
+    return 0;
+  }
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+void configure_output(int pin) { pinMode(pin, OUTPUT); }
+
+void configure_input_pullup(int pin) { pinMode(pin, INPUT_PULLUP); }
+
+void configure_open_drain(int pin) {
+  pinMode(pin, OUTPUT_OPEN_DRAIN);
+  digitalWrite(pin, HIGH);
+}
+
+void write_pin(int pin, bool level) { digitalWrite(pin, level); }
+
+bool read_pin(int pin) { return digitalRead(pin); }
+
+void read_inputs(uint64_t* words) {
+  uint64_t level = REG_READ(GPIO_IN_REG);
+#if SOC_GPIO_PIN_COUNT > 32
+  level |= static_cast<uint64_t>(REG_READ(GPIO_IN1_REG)) << 32;
+#endif
+  words[0] = level;
+}
+
+void write_outputs(const uint64_t* set, const uint64_t* clear) {
+  // Pins in the same register switch on the same clock edge; the second
+  // register follows one store later.
+  uint32_t set_low = static_cast<uint32_t>(set[0]);
+  uint32_t clear_low = static_cast<uint32_t>(clear[0]);
+  if (set_low != 0) {
+    REG_WRITE(GPIO_OUT_W1TS_REG, set_low);
+  }
+  if (clear_low != 0) {
+    REG_WRITE(GPIO_OUT_W1TC_REG, clear_low);
+  }
+#if SOC_GPIO_PIN_COUNT > 32
+  uint32_t set_high = static_cast<uint32_t>(set[0] >> 32);
+  uint32_t clear_high = static_cast<uint32_t>(clear[0] >> 32);
+  if (set_high != 0) {
+    REG_WRITE(GPIO_OUT1_W1TS_REG, set_high);
+  }
+  if (clear_high != 0) {
+    REG_WRITE(GPIO_OUT1_W1TC_REG, clear_high);
+  }
+#endif
+}
+
+void attach_edge_interrupt(int pin, IsrHandler handler, void* arg) {
+  // Ask for an IRAM interrupt so that edges are still stamped while the
+  // flash cache is off. If Arduino or SensESP installed the service first,
+  // this fails harmlessly and their flags apply.
+  gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+  auto gpio = static_cast<gpio_num_t>(pin);
+  gpio_set_intr_type(gpio, GPIO_INTR_ANYEDGE);
+  gpio_isr_handler_add(gpio, handler, arg);
+  gpio_intr_enable(gpio);
+}
+
+uint64_t IRAM_ATTR isr_now_us() { return esp_timer_get_time(); }
+
+bool IRAM_ATTR isr_read_pin(int pin) {
+  // gpio_get_level() may live in flash, so read the input register directly.
+#if SOC_GPIO_PIN_COUNT > 32
+  if (pin >= 32) {
+    return (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
+  }
+#endif
+  return (REG_READ(GPIO_IN_REG) >> pin) & 1;
+}
+
+HeapStats heap_stats() {
+  return {heap_caps_get_free_size(MALLOC_CAP_8BIT),
+          heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+          heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT)};
+}
+
+}  // namespace hal
+}  // namespace relay_controller
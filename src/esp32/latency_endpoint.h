@@ -0,0 +1,67 @@
+#ifndef RELAY_CONTROLLER_ESP32_LATENCY_ENDPOINT_H_
+#define RELAY_CONTROLLER_ESP32_LATENCY_ENDPOINT_H_
+
+// GET /api/relays/latency on the SensESP web server: the full latency
+// histograms of the whole bank and of every tracked channel, in
+// microseconds.
+//
+// The response is streamed one histogram per chunk from a static buffer, so
+// serving it does not allocate however many samples have been recorded.
+
+#include <memory>
+
+#include "relay/bump_arena.h"
+#include "relay/json_writer.h"
+#include "relay/latency_monitor.h"
+#include "sensesp/net/http_server.h"
+#include "sensesp_app.h"
+
+namespace relay_controller {
+
+template <size_t N, size_t BufferSize, size_t Tracked>
+void add_latency_endpoint(LatencyMonitor<N, BufferSize, Tracked>* monitor,
+                          BumpArena* arena) {
+  auto handler = std::allocate_shared<sensesp::HTTPRequestHandler>(
+      ArenaAllocator<sensesp::HTTPRequestHandler>(arena), 1 << HTTP_GET,
+      "/api/relays/latency", [monitor](httpd_req_t* req) {
+        // Room for every bucket of one histogram.
+        static char chunk[LatencyHistogram::kBuckets * 24 + 64];
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr_chunk(req, "{\"unit\":\"us\",\"all\":{");
+        for (size_t leg = 0; leg < kLatencyLegs; leg++) {
+          auto l = static_cast<LatencyLeg>(leg);
+          JsonWriter writer(chunk, sizeof(chunk));
+          writer.raw(leg == 0 ? "\"" : ",\"")
+              .raw(latency_leg_name(l))
+              .raw("\":");
+          monitor->write_histogram(&writer, monitor->bank_histogram(l));
+          httpd_resp_send_chunk(req, writer.c_str(), writer.length());
+        }
+        httpd_resp_sendstr_chunk(req, "},\"channels\":[");
+        for (size_t slot = 0; slot < monitor->tracked(); slot++) {
+          size_t channel = monitor->tracked_channel(slot);
+          for (size_t leg = 0; leg < kLatencyLegs; leg++) {
+            auto l = static_cast<LatencyLeg>(leg);
+            JsonWriter writer(chunk, sizeof(chunk));
+            if (leg == 0) {
+              writer.raw(slot == 0 ? "{\"relay\":" : ",{\"relay\":")
+                  .unsigned_integer(channel + 1);
+            }
+            writer.raw(",\"").raw(latency_leg_name(l)).raw("\":");
+            monitor->write_histogram(&writer, *monitor->histogram(channel, l));
+            if (leg + 1 == kLatencyLegs) {
+              writer.raw("}");
+            }
+            httpd_resp_send_chunk(req, writer.c_str(), writer.length());
+          }
+        }
+        httpd_resp_sendstr_chunk(req, "]}");
+        httpd_resp_sendstr_chunk(req, nullptr);
+        return ESP_OK;
+      });
+  sensesp::sensesp_app->get_http_server()->add_handler(handler);
+}
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_LATENCY_ENDPOINT_H_
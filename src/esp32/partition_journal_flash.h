@@ -0,0 +1,50 @@
+#ifndef RELAY_CONTROLLER_ESP32_PARTITION_JOURNAL_FLASH_H_
+#define RELAY_CONTROLLER_ESP32_PARTITION_JOURNAL_FLASH_H_
+
+// JournalFlash on a data partition of the SPI flash, "relaylog" in
+// partitions_relay.csv. Writes go straight to the partition, below NVS and
+// its page cache, so a change costs one 4-byte program.
+
+#include <esp_partition.h>
+#include <spi_flash_mmap.h>
+
+#include "relay/journal_flash.h"
+
+namespace relay_controller {
+
+class PartitionJournalFlash : public JournalFlash {
+ public:
+  explicit PartitionJournalFlash(const char* label) : label_(label) {}
+
+  // Look up the partition. Returns false if the partition table has none,
+  // e.g. on a device last flashed over the air with an older table.
+  bool begin() {
+    partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                          ESP_PARTITION_SUBTYPE_ANY, label_);
+    return partition_ != nullptr;
+  }
+
+  size_t sector_size() const override { return SPI_FLASH_SEC_SIZE; }
+  size_t sector_count() const override {
+    return partition_ == nullptr ? 0 : partition_->size / SPI_FLASH_SEC_SIZE;
+  }
+
+  bool read(size_t offset, void* data, size_t length) override {
+    return esp_partition_read(partition_, offset, data, length) == ESP_OK;
+  }
+  bool write(size_t offset, const void* data, size_t length) override {
+    return esp_partition_write(partition_, offset, data, length) == ESP_OK;
+  }
+  bool erase_sector(size_t sector) override {
+    return esp_partition_erase_range(partition_, sector * SPI_FLASH_SEC_SIZE,
+                                     SPI_FLASH_SEC_SIZE) == ESP_OK;
+  }
+
+ private:
+  const char* label_;
+  const esp_partition_t* partition_ = nullptr;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_PARTITION_JOURNAL_FLASH_H_
@@ -0,0 +1,100 @@
+#ifndef RELAY_CONTROLLER_ESP32_RELAY_API_ENDPOINT_H_
+#define RELAY_CONTROLLER_ESP32_RELAY_API_ENDPOINT_H_
+
+// /api/relays/states on the SensESP web server, see RelayApi for the
+// documents.
+//
+//   GET   every relay's state.
+//   POST  a request; answered with the states once the event loop has
+//         applied it, 400 if the body is malformed, or 503 if the event
+//         loop has not got round to it, or to the one before, in time.
+//
+// Requests and documents go through static buffers, so serving them does
+// not allocate.
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <memory>
+
+#include "relay/bump_arena.h"
+#include "relay/hal.h"
+#include "relay/json_writer.h"
+#include "relay/relay_api.h"
+#include "sensesp/net/http_server.h"
+#include "sensesp_app.h"
+
+namespace relay_controller {
+
+// How long a POST waits for the event loop.
+constexpr uint32_t kRelayApiTimeoutMs = 250;
+
+template <size_t N>
+void add_relay_api_endpoint(RelayApi<N>* api, BumpArena* arena) {
+  auto handler = std::allocate_shared<sensesp::HTTPRequestHandler>(
+      ArenaAllocator<sensesp::HTTPRequestHandler>(arena),
+      (1 << HTTP_GET) | (1 << HTTP_POST), "/api/relays/states",
+      [api](httpd_req_t* req) {
+        static char body[RelayApi<N>::kMaxBodyLength];
+        static char document[RelayApi<N>::kMaxDocumentLength];
+        JsonWriter writer(document, sizeof(document));
+        if (req->method == HTTP_GET) {
+          if (!api->write_states(&writer)) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                                "states changing too fast to read");
+            return ESP_FAIL;
+          }
+          httpd_resp_set_type(req, "application/json");
+          return httpd_resp_send(req, writer.c_str(), writer.length());
+        }
+
+        if (req->content_len > sizeof(body)) {
+          httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "body too long");
+          return ESP_FAIL;
+        }
+        size_t received = 0;
+        while (received < req->content_len) {
+          int length = httpd_req_recv(req, body + received,
+                                      req->content_len - received);
+          if (length == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+          }
+          if (length <= 0) {
+            return ESP_FAIL;
+          }
+          received += length;
+        }
+        typename RelayApi<N>::Request request;
+        if (!RelayApi<N>::parse(body, received, &request)) {
+          httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                              "expected {\"on\":\"<hex>\"[,\"mask\":"
+                              "\"<hex>\"]} or {\"set\":\"<n>=on|off,...\"}");
+          return ESP_FAIL;
+        }
+        request.received_us = hal::now_us();
+        bool submitted = api->submit(request);
+        for (uint32_t waited = 0;
+             submitted && api->busy() && waited < kRelayApiTimeoutMs;
+             waited++) {
+          vTaskDelay(pdMS_TO_TICKS(1));
+        }
+        // A request that timed out is still applied, just not reported.
+        if (!submitted || api->busy()) {
+          httpd_resp_set_status(req, "503 Service Unavailable");
+          httpd_resp_set_hdr(req, "Retry-After", "1");
+          return httpd_resp_sendstr(req, "event loop busy");
+        }
+        if (!api->write_result(&writer)) {
+          httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                              "states changing too fast to read");
+          return ESP_FAIL;
+        }
+        httpd_resp_set_type(req, "application/json");
+        return httpd_resp_send(req, writer.c_str(), writer.length());
+      });
+  sensesp::sensesp_app->get_http_server()->add_handler(handler);
+}
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_RELAY_API_ENDPOINT_H_
@@ -0,0 +1,125 @@
+#ifndef RELAY_CONTROLLER_ESP32_SCENE_CONTROL_H_
+#define RELAY_CONTROLLER_ESP32_SCENE_CONTROL_H_
+
+// A RelayScene that is configured in the web UI and applied by one Signal K
+// PUT.
+//
+// PUT true on the scene's path switches its relays to the scene's states,
+// PUT false switches them all off. Either way the relays change with one
+// commit and their new states go out through the bank's observers, so the
+// DeltaBatcher answers with a single delta instead of one per relay.
+
+#include "relay/bump_arena.h"
+#include "relay/hal.h"
+#include "relay/json_writer.h"
+#include "relay/relay_bank.h"
+#include "relay/relay_scene.h"
+#include "relay/trace.h"
+#include "sensesp.h"
+#include "sensesp/signalk/signalk_put_request_listener.h"
+#include "sensesp/system/lambda_consumer.h"
+#include "sensesp/system/saveable.h"
+#include "sensesp/ui/config_item.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class SceneControl : public sensesp::FileSystemSaveable {
+ public:
+  SceneControl(RelayBank<N>* bank, const String& config_path,
+               const String& name, const String& sk_path, const String& spec)
+      : sensesp::FileSystemSaveable(config_path),
+        bank_(bank),
+        name_(name),
+        sk_path_(sk_path),
+        spec_(spec) {}
+
+  // Load the saved configuration, listen for PUTs and add the scene to the
+  // web UI. The listener and its consumer are created in arena.
+  void begin(BumpArena* arena, int sort_order) {
+    using namespace sensesp;
+
+    static uint16_t scenes = 0;
+    number_ = ++scenes;
+    load();
+    if (!scene_.parse(spec_.c_str())) {
+      debugW("Scene %s: cannot parse \"%s\"", name_.c_str(), spec_.c_str());
+    }
+
+    // A changed path takes effect after the restart the web UI does.
+    auto* put_listener = arena->make<SKPutRequestListener<bool>>(sk_path_);
+    put_listener->connect_to(
+        arena->make<LambdaConsumer<bool>>([this](bool on) {
+          size_t changed =
+              scene_.apply(bank_, on, ChangeSource::kRemote, hal::now_us());
+          RELAY_TRACE(kScene, number_, on, changed);
+        }));
+
+    String title = "Scene: " + name_;
+    ConfigItem(this)
+        ->set_title(title)
+        ->set_description(
+            "Relays switched together by a PUT to the scene's Signal K "
+            "path, e.g. 1=on,2=on,4=off.")
+        ->set_sort_order(sort_order);
+  }
+
+  bool to_json(JsonObject& root) override {
+    root["name"] = name_;
+    root["sk_path"] = sk_path_;
+    // Write the parsed scene back so that the UI shows what is applied.
+    char spec[kSpecSize];
+    JsonWriter writer(spec, sizeof(spec));
+    root["spec"] = scene_.format(&writer) ? String(writer.c_str()) : spec_;
+    return true;
+  }
+
+  bool from_json(const JsonObject& config) override {
+    if (config["spec"].is<String>()) {
+      String spec = config["spec"].as<String>();
+      // Keep the current scene rather than store one that cannot be applied.
+      if (!scene_.parse(spec.c_str())) {
+        return false;
+      }
+      spec_ = spec;
+    }
+    if (config["name"].is<String>()) {
+      name_ = config["name"].as<String>();
+    }
+    if (config["sk_path"].is<String>()) {
+      sk_path_ = config["sk_path"].as<String>();
+    }
+    return true;
+  }
+
+ private:
+  // "nnn=off," for every channel.
+  static constexpr size_t kSpecSize = N * 8 + 1;
+
+  RelayBank<N>* bank_;
+  // 1, 2, ... in the order scenes were begun; identifies them in traces.
+  uint16_t number_ = 0;
+  String name_;
+  String sk_path_;
+  String spec_;
+  RelayScene<N> scene_;
+};
+
+template <size_t N>
+const String ConfigSchema(const SceneControl<N>& obj) {
+  return R"({"type":"object","properties":{)"
+         R"("name":{"title":"Name","type":"string"},)"
+         R"("sk_path":{"title":"Signal K path","type":"string"},)"
+         R"("spec":{"title":"Relays","type":"string",)"
+         R"("description":"Comma separated relay=on|off pairs"}}})";
+}
+
+template <size_t N>
+bool ConfigRequiresRestart(const SceneControl<N>& obj) {
+  // The PUT listener is bound to the path it was created with.
+  return true;
+}
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_SCENE_CONTROL_H_
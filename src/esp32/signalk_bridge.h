@@ -0,0 +1,101 @@
+#ifndef RELAY_CONTROLLER_ESP32_SIGNALK_BRIDGE_H_
+#define RELAY_CONTROLLER_ESP32_SIGNALK_BRIDGE_H_
+
+// Connects a RelayBank to Signal K configuration and remote control.
+//
+// Each channel gets an SKOutput, which keeps its Signal K path configurable
+// in the web UI and announces its metadata. The relay states themselves are
+// published by a DeltaBatcher on the configured paths. These SensESP objects
+// are created once in begin(), in the arena it is given.
+//
+// Each channel also gets a PutListener, which knows its channel and switches
+// the relay directly. SensESP finds the listener for a PUT by comparing the
+// path with every listener's in turn, and only by exact path, so that scan
+// still grows with the number of channels; the listener adds nothing to it.
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+#include "relay/bump_arena.h"
+#include "relay/channel_table.h"
+#include "relay/hal.h"
+#include "relay/relay_bank.h"
+#include "relay/trace.h"
+#include "sensesp.h"
+#include "sensesp/signalk/signalk_output.h"
+#include "sensesp/signalk/signalk_put_request_listener.h"
+#include "sensesp/ui/config_item.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class SignalKBridge {
+ public:
+  explicit SignalKBridge(RelayBank<N>* bank) : bank_(bank) {}
+
+  // Arena bytes begin() takes per channel: the metadata with the control
+  // block allocate_shared() puts in front of it, the SKOutput and the
+  // PutListener, each with room to be aligned.
+  static constexpr size_t arena_bytes_per_channel() {
+    return sizeof(sensesp::SKMetadata) + 4 * sizeof(void*) +
+           sizeof(sensesp::SKOutput<bool>) + sizeof(PutListener) +
+           3 * alignof(std::max_align_t);
+  }
+
+  void begin(BumpArena* arena) {
+    using namespace sensesp;
+
+    for (size_t i = 0; i < N; i++) {
+      const RelayChannel& channel = bank_->channel(i);
+      auto metadata = std::allocate_shared<SKMetadata>(
+          ArenaAllocator<SKMetadata>(arena), "",
+          kNames.metadata_title[i].c_str());
+
+      sk_outputs_[i] = arena->make<SKOutput<bool>>(
+          channel.sk_path(), kNames.config_path[i].c_str(), metadata);
+      ConfigItem(sk_outputs_[i])
+          ->set_title(kNames.title[i].c_str())
+          ->set_description(
+              "The Signal K path to publish the state of this relay.")
+          ->set_sort_order(100 + i);
+      // A changed path takes effect after the restart the web UI does.
+      sk_paths_[i] = sk_outputs_[i]->get_sk_path();
+
+      arena->make<PutListener>(channel.sk_path(), bank_, i);
+    }
+  }
+
+  // The configured Signal K path of channel, valid after begin().
+  const char* sk_path(size_t channel) const {
+    return sk_paths_[channel].c_str();
+  }
+
+ private:
+  class PutListener : public sensesp::SKPutListener {
+   public:
+    PutListener(const String& sk_path, RelayBank<N>* bank, size_t channel)
+        : sensesp::SKPutListener(sk_path), bank_(bank), channel_(channel) {}
+
+    void parse_value(const JsonObject& put) override {
+      bool on = put["value"].as<bool>();
+      RELAY_TRACE(kPut, channel_, on);
+      bank_->set(channel_, on, ChangeSource::kRemote, hal::now_us());
+    }
+
+   private:
+    RelayBank<N>* bank_;
+    size_t channel_;
+  };
+
+  // Config paths and titles, built by the compiler.
+  static constexpr ChannelNames<N> kNames = make_channel_names<N>();
+
+  RelayBank<N>* bank_;
+  std::array<sensesp::SKOutput<bool>*, N> sk_outputs_{};
+  std::array<String, N> sk_paths_;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_SIGNALK_BRIDGE_H_
@@ -0,0 +1,115 @@
+#ifndef RELAY_CONTROLLER_ESP32_SPI_SHIFT_REGISTER_BUS_H_
+#define RELAY_CONTROLLER_ESP32_SPI_SHIFT_REGISTER_BUS_H_
+
+// ShiftRegisterBus on an ESP32 SPI host with DMA. The 74HC595 latch (RCLK)
+// is wired to the SPI chip select: it goes low for the transfer and its
+// rising edge at the end latches the frame, so shifting and latching the
+// whole chain is one queued transaction and needs no CPU until the next.
+//
+// The output enable pin is held high, outputs off, until the first frame
+// has been latched, so the relays never see the registers' power-up state.
+
+#include <Arduino.h>
+#include <driver/spi_master.h>
+#include <esp_heap_caps.h>
+
+#include <cstring>
+
+#include "relay/shift_register_output.h"
+
+namespace relay_controller {
+
+class SpiShiftRegisterBus : public ShiftRegisterBus {
+ public:
+  SpiShiftRegisterBus(spi_host_device_t host, int data_pin, int clock_pin,
+                      int latch_pin, int enable_pin,
+                      int clock_hz = 10000000)
+      : host_(host),
+        data_pin_(data_pin),
+        clock_pin_(clock_pin),
+        latch_pin_(latch_pin),
+        enable_pin_(enable_pin),
+        clock_hz_(clock_hz) {}
+
+  // Set up the bus for frames of up to max_length bytes. Returns false if
+  // the SPI driver or the DMA buffer could not be set up.
+  bool begin(size_t max_length) {
+    pinMode(enable_pin_, OUTPUT);
+    digitalWrite(enable_pin_, HIGH);
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = data_pin_;
+    bus.miso_io_num = -1;
+    bus.sclk_io_num = clock_pin_;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = max_length;
+    if (spi_bus_initialize(host_, &bus, SPI_DMA_CH_AUTO) != ESP_OK) {
+      return false;
+    }
+    spi_device_interface_config_t device = {};
+    device.mode = 0;
+    device.clock_speed_hz = clock_hz_;
+    device.spics_io_num = latch_pin_;
+    device.queue_size = 1;
+    if (spi_bus_add_device(host_, &device, &device_) != ESP_OK) {
+      return false;
+    }
+    buffer_ = static_cast<uint8_t*>(heap_caps_malloc(max_length,
+                                                     MALLOC_CAP_DMA));
+    max_length_ = max_length;
+    return buffer_ != nullptr;
+  }
+
+  bool transfer(const uint8_t* data, size_t length) override {
+    if (buffer_ == nullptr || length > max_length_) {
+      return false;
+    }
+    // The DMA engine may still be reading the buffer.
+    if (!wait()) {
+      return false;
+    }
+    memcpy(buffer_, data, length);
+    transaction_ = {};
+    transaction_.length = length * 8;
+    transaction_.tx_buffer = buffer_;
+    if (spi_device_queue_trans(device_, &transaction_, portMAX_DELAY) !=
+        ESP_OK) {
+      return false;
+    }
+    queued_ = true;
+    if (!enabled_) {
+      wait();
+      digitalWrite(enable_pin_, LOW);
+      enabled_ = true;
+    }
+    return true;
+  }
+
+ private:
+  bool wait() {
+    if (!queued_) {
+      return true;
+    }
+    spi_transaction_t* done;
+    queued_ = false;
+    return spi_device_get_trans_result(device_, &done, portMAX_DELAY) ==
+           ESP_OK;
+  }
+
+  spi_host_device_t host_;
+  int data_pin_;
+  int clock_pin_;
+  int latch_pin_;
+  int enable_pin_;
+  int clock_hz_;
+  spi_device_handle_t device_ = nullptr;
+  spi_transaction_t transaction_ = {};
+  uint8_t* buffer_ = nullptr;
+  size_t max_length_ = 0;
+  bool queued_ = false;
+  bool enabled_ = false;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_SPI_SHIFT_REGISTER_BUS_H_
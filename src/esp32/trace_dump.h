@@ -0,0 +1,97 @@
+#ifndef RELAY_CONTROLLER_ESP32_TRACE_DUMP_H_
+#define RELAY_CONTROLLER_ESP32_TRACE_DUMP_H_
+
+// Getting the trace ring off the device.
+//
+//   HTTP    GET /api/relays/trace returns the binary dump: a TraceDumpHeader
+//           followed by the records, as tools/trace_decode.py reads it.
+//   Serial  Send "t" on the console and the same bytes come back as
+//           "@trace <hex>" lines, which the decoder picks out of a log.
+//
+// Both take a snapshot into one static buffer, so they share a mutex.
+
+#include <Arduino.h>
+
+#include <memory>
+#include <mutex>
+
+#include "relay/bump_arena.h"
+#include "relay/trace.h"
+#include "sensesp/net/http_server.h"
+#include "sensesp_app.h"
+
+namespace relay_controller {
+
+namespace trace_dump_detail {
+
+struct Snapshot {
+  TraceDumpHeader header;
+  TraceRecord records[TraceRing::kCapacity];
+};
+
+inline std::mutex& snapshot_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+inline Snapshot& snapshot_buffer() {
+  static Snapshot snapshot;
+  return snapshot;
+}
+
+// Print length bytes as one "@trace <hex>" line.
+inline void print_hex_line(const void* data, size_t length) {
+  static const char kDigits[] = "0123456789abcdef";
+  char line[8 + 2 * sizeof(TraceRecord) + 1] = "@trace ";
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < length; i++) {
+    line[7 + 2 * i] = kDigits[bytes[i] >> 4];
+    line[8 + 2 * i] = kDigits[bytes[i] & 0xf];
+  }
+  line[7 + 2 * length] = '\0';
+  Serial.println(line);
+}
+
+}  // namespace trace_dump_detail
+
+inline void add_trace_endpoint(BumpArena* arena) {
+  auto handler = std::allocate_shared<sensesp::HTTPRequestHandler>(
+      ArenaAllocator<sensesp::HTTPRequestHandler>(arena), 1 << HTTP_GET,
+      "/api/relays/trace", [](httpd_req_t* req) {
+        using namespace trace_dump_detail;
+        std::lock_guard<std::mutex> lock(snapshot_mutex());
+        Snapshot& snapshot = snapshot_buffer();
+        size_t count = trace_ring().snapshot(
+            &snapshot.header, snapshot.records, TraceRing::kCapacity);
+        httpd_resp_set_type(req, "application/octet-stream");
+        httpd_resp_send(req, reinterpret_cast<const char*>(&snapshot),
+                        sizeof(TraceDumpHeader) + count * sizeof(TraceRecord));
+        return ESP_OK;
+      });
+  sensesp::sensesp_app->get_http_server()->add_handler(handler);
+}
+
+// Print a dump if "t" has arrived on the serial console. Call periodically
+// from the event loop.
+inline void poll_trace_serial() {
+  using namespace trace_dump_detail;
+  bool requested = false;
+  while (Serial.available() > 0) {
+    requested |= Serial.read() == 't';
+  }
+  if (!requested) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(snapshot_mutex());
+  Snapshot& snapshot = snapshot_buffer();
+  size_t count = trace_ring().snapshot(&snapshot.header, snapshot.records,
+                                       TraceRing::kCapacity);
+  print_hex_line(&snapshot.header, sizeof(snapshot.header));
+  for (size_t i = 0; i < count; i++) {
+    print_hex_line(&snapshot.records[i], sizeof(TraceRecord));
+  }
+}
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_TRACE_DUMP_H_
@@ -0,0 +1,78 @@
+#ifndef RELAY_CONTROLLER_ESP32_TWAI_CAN_BUS_H_
+#define RELAY_CONTROLLER_ESP32_TWAI_CAN_BUS_H_
+
+#include <driver/twai.h>
+
+#include <cstring>
+
+#include "relay/can_bus.h"
+
+namespace relay_controller {
+
+// CanBus on the ESP32's TWAI controller at 250 kbit/s, through a
+// transceiver on tx_pin and rx_pin.
+class TwaiCanBus : public CanBus {
+ public:
+  TwaiCanBus(int tx_pin, int rx_pin) : tx_pin_(tx_pin), rx_pin_(rx_pin) {}
+
+  bool begin() {
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(
+        static_cast<gpio_num_t>(tx_pin_), static_cast<gpio_num_t>(rx_pin_),
+        TWAI_MODE_NORMAL);
+    general.rx_queue_len = 32;
+    general.tx_queue_len = 16;
+    twai_timing_config_t timing = TWAI_TIMING_CONFIG_250KBITS();
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    return twai_driver_install(&general, &timing, &filter) == ESP_OK &&
+           twai_start() == ESP_OK;
+  }
+
+  bool send(const CanFrame& frame) override {
+    twai_message_t message = {};
+    message.extd = 1;
+    message.identifier = frame.id;
+    message.data_length_code = frame.length;
+    memcpy(message.data, frame.data, frame.length);
+    if (twai_transmit(&message, 0) == ESP_OK) {
+      return true;
+    }
+    recover();
+    return false;
+  }
+
+  bool receive(CanFrame* frame) override {
+    twai_message_t message;
+    while (twai_receive(&message, 0) == ESP_OK) {
+      if (!message.extd || message.rtr || message.data_length_code > 8) {
+        continue;
+      }
+      frame->id = message.identifier;
+      frame->length = message.data_length_code;
+      memcpy(frame->data, message.data, frame->length);
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  // After too many errors the controller leaves the bus. Bring it back:
+  // recovery takes 128 idle periods, then it has to be started again.
+  void recover() {
+    twai_status_info_t status;
+    if (twai_get_status_info(&status) != ESP_OK) {
+      return;
+    }
+    if (status.state == TWAI_STATE_BUS_OFF) {
+      twai_initiate_recovery();
+    } else if (status.state == TWAI_STATE_STOPPED) {
+      twai_start();
+    }
+  }
+
+  int tx_pin_;
+  int rx_pin_;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_TWAI_CAN_BUS_H_
@@ -0,0 +1,41 @@
+#ifndef RELAY_CONTROLLER_ESP32_WEBSOCKET_DELTA_SINK_H_
+#define RELAY_CONTROLLER_ESP32_WEBSOCKET_DELTA_SINK_H_
+
+#include <Arduino.h>
+
+#include "relay/delta_batcher.h"
+#include "sensesp_app.h"
+
+namespace relay_controller {
+
+// Sends ready-made deltas over the SensESP Signal K websocket.
+class WebsocketDeltaSink : public DeltaSink {
+ public:
+  // Reserve the payload once so that sending does not allocate.
+  void begin(size_t capacity) { payload_.reserve(capacity); }
+
+  bool send_delta(const char* json, size_t length) override {
+    if (!connected()) {
+      return false;
+    }
+    auto ws_client = sensesp::sensesp_app->get_ws_client();
+    // The client only takes a String; copy by length, as a delta need not
+    // end at a terminator.
+    payload_ = "";
+    payload_.concat(json, length);
+    ws_client->sendTXT(payload_);
+    return true;
+  }
+
+  bool connected() override {
+    auto ws_client = sensesp::sensesp_app->get_ws_client();
+    return ws_client && ws_client->is_connected();
+  }
+
+ private:
+  String payload_;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_WEBSOCKET_DELTA_SINK_H_
@@ -0,0 +1,45 @@
+#ifndef RELAY_CONTROLLER_ESP32_WIRE_I2C_BUS_H_
+#define RELAY_CONTROLLER_ESP32_WIRE_I2C_BUS_H_
+
+#include <Wire.h>
+
+#include "relay/i2c_bus.h"
+
+namespace relay_controller {
+
+// I2cBus on an Arduino TwoWire, which the caller has begun.
+class WireI2cBus : public I2cBus {
+ public:
+  explicit WireI2cBus(TwoWire* wire) : wire_(wire) {}
+
+  bool write(uint8_t address, const uint8_t* data, size_t length) override {
+    wire_->beginTransmission(address);
+    wire_->write(data, length);
+    return wire_->endTransmission() == 0;
+  }
+
+  bool write_read(uint8_t address, const uint8_t* out, size_t out_length,
+                  uint8_t* in, size_t in_length) override {
+    if (out_length > 0) {
+      wire_->beginTransmission(address);
+      wire_->write(out, out_length);
+      if (wire_->endTransmission(false) != 0) {
+        return false;
+      }
+    }
+    if (wire_->requestFrom(address, in_length) != in_length) {
+      return false;
+    }
+    for (size_t i = 0; i < in_length; i++) {
+      in[i] = static_cast<uint8_t>(wire_->read());
+    }
+    return true;
+  }
+
+ private:
+  TwoWire* wire_;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_ESP32_WIRE_I2C_BUS_H_
@@ -1,34 +1,373 @@
 // Signal K application template file.
 //
-// This application demonstrates core SensESP concepts using four individual
-// switches. Each pushbutton toggles its corresponding relay, publishes its
-// state to a unique SignalK path, and also drives a dedicated status LED.
+// This application demonstrates core SensESP concepts using individual
+// switches, four by default. Each pushbutton toggles its corresponding
+// relay, publishes its state to a unique SignalK path, and also drives a
+// dedicated status LED where the board has one.
 
+#include <WiFi.h>
 #include <Wire.h>
 
 #include <memory>
 
 #include "sensesp.h"
-#include "sensesp/sensors/digital_input.h"
-#include "sensesp/sensors/digital_output.h"
-#include "sensesp/signalk/signalk_output.h"
-#include "sensesp/signalk/signalk_put_request_listener.h"
-#include "sensesp/system/lambda_consumer.h"
-#include "sensesp/transforms/press_repeater.h"
-#include "sensesp/transforms/repeat_report.h"
-#include "sensesp/ui/config_item.h"
+#include "sensesp/ui/ui_controls.h"
 #include "sensesp_app_builder.h"
 
-// I2C pins (if needed for other sensors)
+#include "esp32/latency_endpoint.h"
+#include "esp32/partition_journal_flash.h"
+#include "esp32/relay_api_endpoint.h"
+#include "esp32/spi_shift_register_bus.h"
+#include "esp32/scene_control.h"
+#include "esp32/signalk_bridge.h"
+#include "esp32/trace_dump.h"
+#include "esp32/twai_can_bus.h"
+#include "esp32/websocket_delta_sink.h"
+#include "esp32/wire_i2c_bus.h"
+#include "relay/bank_debouncer.h"
+#include "relay/boot_timeline.h"
+#include "relay/bump_arena.h"
+#include "relay/button_matrix.h"
+#include "relay/channel_table.h"
+#include "relay/delta_batcher.h"
+#include "relay/edge_capture.h"
+#include "relay/expander_buttons.h"
+#include "relay/heartbeat_wheel.h"
+#include "relay/i2c_expander.h"
+#include "relay/latency_monitor.h"
+#include "relay/matrix_buttons.h"
+#include "relay/memory_report.h"
+#include "relay/n2k.h"
+#include "relay/n2k_switch_bank.h"
+#include "relay/publish_limiter.h"
+#include "relay/relay_api.h"
+#include "relay/relay_bank.h"
+#include "relay/shift_register_output.h"
+#include "relay/state_journal.h"
+#include "relay/tick_profiler.h"
+#include "relay/trace.h"
+
+// I2C pins, for the relay expanders and other sensors
 #define I2C_SDA 21
 #define I2C_SCL 22
 
+// Build with -D RELAY_EXPANDER_CHIPS=<1-8> to run eight channels on each of
+// that many MCP23017s at 0x20, 0x21, ... instead of on the GPIOs. Their INT
+// outputs are wired together to this pin, with a pull-up.
+#ifndef EXPANDER_INT_PIN
+#define EXPANDER_INT_PIN 27
+#endif
+
+// Build with -D RELAY_SHIFT_REGISTERS=<1-16> to drive eight relays from
+// each of a chain of that many 74HC595s on these pins instead of from the
+// GPIOs. The register latch (RCLK) is the SPI chip select.
+#ifndef SHIFT_DATA_PIN
+#define SHIFT_DATA_PIN 23
+#endif
+#ifndef SHIFT_CLOCK_PIN
+#define SHIFT_CLOCK_PIN 27
+#endif
+#ifndef SHIFT_LATCH_PIN
+#define SHIFT_LATCH_PIN 5
+#endif
+#ifndef SHIFT_ENABLE_PIN
+#define SHIFT_ENABLE_PIN 4
+#endif
+
+// Add -D RELAY_BUTTON_MATRIX to read the buttons of the shift register
+// channels from an 8 x 8 matrix, kMatrixWiring below, scanned every this
+// many microseconds.
+#ifndef MATRIX_SCAN_PERIOD_US
+#define MATRIX_SCAN_PERIOD_US 2000
+#endif
+#if defined(RELAY_BUTTON_MATRIX) && !defined(RELAY_SHIFT_REGISTERS)
+#error "RELAY_BUTTON_MATRIX needs the relays on RELAY_SHIFT_REGISTERS"
+#endif
+
+// Build with -D RELAY_N2K_SWITCH_BANK to offer the relays to NMEA 2000
+// switch panels as binary switch banks N2K_SWITCH_INSTANCE, +1, ..., 28
+// relays each, through a CAN transceiver on these pins, as on HALMET.
+#ifndef N2K_CAN_TX_PIN
+#define N2K_CAN_TX_PIN 19
+#endif
+#ifndef N2K_CAN_RX_PIN
+#define N2K_CAN_RX_PIN 18
+#endif
+#ifndef N2K_SWITCH_INSTANCE
+#define N2K_SWITCH_INSTANCE 0
+#endif
+
 using namespace sensesp;
 using namespace reactesp;
+using namespace relay_controller;
+
+// Every channel's button, status LED and relay pin and its default Signal K
+// path. Config paths, titles and everything else about a channel are
+// derived from this table; add a line to add a channel.
+#if defined(RELAY_EXPANDER_CHIPS)
+// Relays on port A and buttons on port B of each expander, published as
+// electrical.switches.relay<n>.state.
+constexpr size_t kExpanderChannels = RELAY_EXPANDER_CHIPS * 8;
+constexpr NumberedPaths<kExpanderChannels> kExpanderPaths =
+    make_numbered_paths<kExpanderChannels>("electrical.switches.relay",
+                                           ".state");
+constexpr ChannelTable<kExpanderChannels> kExpanderTable =
+    make_expander_table(kExpanderPaths);
+constexpr const ChannelSpec (&kChannelTable)[kExpanderChannels] =
+    kExpanderTable.specs;
+#elif defined(RELAY_SHIFT_REGISTERS)
+// Relay n on output n of the chain, published as
+// electrical.switches.relay<n>.state. The first four keep the GPIO buttons
+// of the default board; the status LEDs give way to the registers.
+constexpr size_t kShiftChannels = RELAY_SHIFT_REGISTERS * 8;
+constexpr NumberedPaths<kShiftChannels> kShiftPaths =
+    make_numbered_paths<kShiftChannels>("electrical.switches.relay",
+                                        ".state");
+#if defined(RELAY_BUTTON_MATRIX)
+// Rows on open-drain outputs, columns on inputs; GPIO 34-39 have no
+// pull-ups of their own, so fit external ones to every column but 12 and
+// 15. GPIO 12 is a strapping pin and must only get the internal pull-up,
+// which is off during reset. Key n, row n / 8 and column n % 8, is the
+// button of relay n + 1.
+constexpr MatrixWiring kMatrixWiring = {{13, 14, 16, 17, 18, 19, 25, 26},
+                                        {32, 33, 34, 35, 36, 39, 15, 12},
+                                        8,
+                                        8,
+                                        true,
+                                        5};
+constexpr ChannelTable<kShiftChannels> kShiftTable =
+    make_shift_register_matrix_table(kShiftPaths);
+#else
+constexpr uint16_t kShiftButtons[] = {16, 17, 18, 19};
+constexpr ChannelTable<kShiftChannels> kShiftTable =
+    make_shift_register_table(kShiftPaths, kShiftButtons);
+#endif
+constexpr const ChannelSpec (&kChannelTable)[kShiftChannels] =
+    kShiftTable.specs;
+#elif defined(CONFIG_IDF_TARGET_ESP32C3)
+// The C3 has no GPIO 25-33, and after the USB, strapping and flash pins too
+// few are left for status LEDs; the relay board's own LEDs show the state.
+constexpr ChannelSpec kChannelTable[] = {
+    {{0, kNoPin, 4}, "electrical.switches.light.cabin.state"},
+    {{1, kNoPin, 5}, "electrical.switches.light.port.state"},
+    {{3, kNoPin, 6}, "electrical.switches.light.starboard.state"},
+    {{10, kNoPin, 7}, "electrical.switches.light.engine.state"},
+};
+#else
+constexpr ChannelSpec kChannelTable[] = {
+    // {{button, status LED, relay}, Signal K path}
+    {{16, 12, 32}, "electrical.switches.light.cabin.state"},
+    {{17, 13, 33}, "electrical.switches.light.port.state"},
+    {{18, 14, 25}, "electrical.switches.light.starboard.state"},
+    {{19, 15, 26}, "electrical.switches.light.engine.state"},
+};
+#endif
+
+#if defined(RELAY_EXPANDER_CHIPS)
+static_assert(RELAY_EXPANDER_CHIPS >= 1 &&
+                  RELAY_EXPANDER_CHIPS <= I2cExpanderBank::kMaxChips,
+              "RELAY_EXPANDER_CHIPS: one bus takes 1 to 8 expanders");
+static_assert(expander_pins_valid(kChannelTable, RELAY_EXPANDER_CHIPS),
+              "kChannelTable: a pin is not on one of the expanders");
+static_assert(pins_unique(kChannelTable),
+              "kChannelTable: a pin is used more than once");
+#elif defined(RELAY_SHIFT_REGISTERS)
+static_assert(RELAY_SHIFT_REGISTERS >= 1 &&
+                  RELAY_SHIFT_REGISTERS <= ShiftRegisterOutput::kMaxRegisters,
+              "RELAY_SHIFT_REGISTERS: the chain takes 1 to 16 registers");
+#if defined(RELAY_BUTTON_MATRIX)
+static_assert(RELAY_SHIFT_REGISTERS <= 8,
+              "RELAY_BUTTON_MATRIX: the matrix has 64 keys");
+static_assert(matrix_wiring_valid(kMatrixWiring),
+              "kMatrixWiring: a line does not exist, cannot drive a row or "
+              "is used twice");
+static_assert(matrix_keys_valid(kChannelTable, kMatrixWiring),
+              "kChannelTable: a button is not a key of the matrix");
+#else
+static_assert(buttons_valid(kChannelTable),
+              "kChannelTable: a button pin does not exist on this board");
+#endif
+// Relay pins are register outputs, so they may share numbers with GPIOs.
+static_assert(shift_register_pins_valid(kChannelTable,
+                                        RELAY_SHIFT_REGISTERS),
+              "kChannelTable: a relay is not on the chain, is used twice or "
+              "has an LED, or a button is used twice");
+#else
+static_assert(buttons_valid(kChannelTable),
+              "kChannelTable: a button pin does not exist on this board");
+static_assert(outputs_valid(kChannelTable),
+              "kChannelTable: a relay or LED pin does not exist on this board "
+              "or cannot drive an output");
+static_assert(pins_unique(kChannelTable),
+              "kChannelTable: a pin is used more than once");
+#endif
+static_assert(sk_paths_unique(kChannelTable),
+              "kChannelTable: a Signal K path is used more than once");
+#if defined(RELAY_N2K_SWITCH_BANK)
+static_assert(board::pin_can_output(N2K_CAN_TX_PIN) &&
+                  board::pin_exists(N2K_CAN_RX_PIN) &&
+                  N2K_CAN_TX_PIN != N2K_CAN_RX_PIN,
+              "N2K_CAN_TX_PIN, N2K_CAN_RX_PIN: not usable for CAN");
+#if defined(RELAY_EXPANDER_CHIPS)
+constexpr uint16_t kBusPins[] = {I2C_SDA, I2C_SCL, EXPANDER_INT_PIN};
+constexpr bool kCanPinsFree = pin_unused(kBusPins, N2K_CAN_TX_PIN) &&
+                              pin_unused(kBusPins, N2K_CAN_RX_PIN);
+#elif defined(RELAY_SHIFT_REGISTERS)
+constexpr uint16_t kBusPins[] = {I2C_SDA,         I2C_SCL,
+                                 SHIFT_DATA_PIN,  SHIFT_CLOCK_PIN,
+                                 SHIFT_LATCH_PIN, SHIFT_ENABLE_PIN};
+#if defined(RELAY_BUTTON_MATRIX)
+constexpr bool kCanPinsFree =
+    pin_unused(kBusPins, N2K_CAN_TX_PIN) &&
+    pin_unused(kBusPins, N2K_CAN_RX_PIN) &&
+    matrix_pin_unused(kMatrixWiring, N2K_CAN_TX_PIN) &&
+    matrix_pin_unused(kMatrixWiring, N2K_CAN_RX_PIN);
+#else
+constexpr bool kCanPinsFree =
+    pin_unused(kBusPins, N2K_CAN_TX_PIN) &&
+    pin_unused(kBusPins, N2K_CAN_RX_PIN) &&
+    pin_unused(kChannelTable, N2K_CAN_TX_PIN, false) &&
+    pin_unused(kChannelTable, N2K_CAN_RX_PIN, false);
+#endif
+#else
+constexpr uint16_t kBusPins[] = {I2C_SDA, I2C_SCL};
+constexpr bool kCanPinsFree = pin_unused(kBusPins, N2K_CAN_TX_PIN) &&
+                              pin_unused(kBusPins, N2K_CAN_RX_PIN) &&
+                              pin_unused(kChannelTable, N2K_CAN_TX_PIN) &&
+                              pin_unused(kChannelTable, N2K_CAN_RX_PIN);
+#endif
+static_assert(kCanPinsFree,
+              "N2K_CAN_TX_PIN, N2K_CAN_RX_PIN: a pin is already in use");
+#endif
+
+// Define the number of remote channels.
+constexpr size_t num_relays = sizeof(kChannelTable) / sizeof(kChannelTable[0]);
+
+// The SensESP objects built in setup() live here rather than in the general
+// heap, away from the WiFi and websocket buffers that come and go. The
+// bridge's objects grow with the channels; the fixed part covers the
+// scenes, config items and HTTP handlers. setup() logs an error if anything
+// still ends up on the heap.
+constexpr size_t kArenaFixedBytes = 7168;
+constexpr size_t kArenaBytes =
+    kArenaFixedBytes +
+    num_relays * SignalKBridge<num_relays>::arena_bytes_per_channel();
+alignas(max_align_t) static uint8_t arena_storage[kArenaBytes];
+static BumpArena arena(arena_storage, kArenaBytes);
+
+// All per-channel state lives in these statics; nothing is allocated for the
+// channels once setup() has returned.
+static RelayBank<num_relays> relay_bank;
+#if defined(RELAY_EXPANDER_CHIPS)
+static WireI2cBus i2c_bus(&Wire);
+static I2cExpanderBank expander(&i2c_bus, I2cExpanderBank::Model::kMcp23017,
+                                0x20, RELAY_EXPANDER_CHIPS);
+static ExpanderButtons<num_relays> expander_buttons;
+#else
+#if defined(RELAY_SHIFT_REGISTERS)
+static SpiShiftRegisterBus shift_bus(SPI3_HOST, SHIFT_DATA_PIN,
+                                     SHIFT_CLOCK_PIN, SHIFT_LATCH_PIN,
+                                     SHIFT_ENABLE_PIN);
+static ShiftRegisterOutput shift_output(&shift_bus, RELAY_SHIFT_REGISTERS);
+#endif
+#if defined(RELAY_BUTTON_MATRIX)
+static ButtonMatrix button_matrix;
+static MatrixButtons<num_relays> matrix_buttons;
+#else
+static EdgeCapture<num_relays> edge_capture;
+static BankDebouncer<num_relays> debouncer;
+#endif
+#endif
+static SignalKBridge<num_relays> signalk_bridge(&relay_bank);
+static HeartbeatWheel<num_relays> heartbeat(&relay_bank);
+
+// All relay states go out in one delta, at most 10 ms after the first change.
+static WebsocketDeltaSink delta_sink;
+static DeltaBatcher<num_relays> delta_batcher(&relay_bank, &delta_sink,
+                                              10000);
+// A relay that keeps flipping is published at a limited rate, its final
+// state included, and flagged on notifications.<path>.
+static PublishLimiter<num_relays> publish_limiter(&relay_bank);
+
+// Edge, PUT and delta latency of the bank and of its first eight channels,
+// published once a minute and served in full on /api/relays/latency.
+static LatencyMonitor<num_relays> latency(&relay_bank);
+
+// GET and POST /api/relays/states, for panels on the local network.
+static RelayApi<num_relays> relay_api(&relay_bank);
+
+#if defined(RELAY_N2K_SWITCH_BANK)
+static TwaiCanBus can_bus(N2K_CAN_TX_PIN, N2K_CAN_RX_PIN);
+static N2kSwitchBank<num_relays> n2k_switch_bank(&relay_bank, &can_bus);
+#endif
+
+// Relay states survive a power cut in the "relaylog" flash partition.
+static PartitionJournalFlash journal_flash("relaylog");
+static StateJournal<num_relays> journal;
+
+// Duration of every event loop tick and of the reactions registered below.
+static TickProfiler tick_profiler;
+
+// Reset to valid outputs, WiFi and the first delta, published once all
+// three have happened. The build time tells firmware versions apart.
+static BootTimeline boot_timeline;
+constexpr char kFirmwareBuild[] = __DATE__ " " __TIME__;
+
+// Runs on the WiFi event task, so it only stores the time; the event loop
+// traces it.
+static void on_wifi_got_ip(arduino_event_id_t event) {
+  boot_timeline.stamp(BootStage::kWifiUp);
+}
 
 void setup() {
+  // Drive the relays and LEDs before anything else: building the app brings
+  // up the filesystem and WiFi, which takes hundreds of milliseconds during
+  // which the pins would float. Relays come back the way they were before
+  // the reset; without a saved state, e.g. on first boot, they start
+  // switched on, as before.
+  bool journal_partition = journal_flash.begin();
+  journal.begin(&journal_flash, true);
+#if defined(RELAY_EXPANDER_CHIPS)
+  Wire.begin(I2C_SDA, I2C_SCL);
+  Wire.setClock(400000);
+  bool expanders_found = expander.begin();
+  relay_bank.set_output_stages(&expander, &expander);
+  relay_bank.set_input_stage(&expander);
+  relay_bank.begin(kChannelTable, journal.states());
+  expander.flush();
+#elif defined(RELAY_SHIFT_REGISTERS)
+  // The outputs stay disabled until this first frame has been latched.
+  bool shift_bus_ready = shift_bus.begin(RELAY_SHIFT_REGISTERS);
+  relay_bank.set_output_stages(&shift_output, &shift_output);
+#if defined(RELAY_BUTTON_MATRIX)
+  button_matrix.begin(kMatrixWiring);
+  relay_bank.set_input_stage(&button_matrix);
+#endif
+  relay_bank.begin(kChannelTable, journal.states());
+  shift_output.flush();
+#else
+  relay_bank.begin(kChannelTable, journal.states());
+#endif
+  boot_timeline.mark(BootStage::kOutputsValid);
+
   SetupLogging(ESP_LOG_DEBUG);
+  if (!journal_partition) {
+    debugW("No relaylog partition; relay states will not survive a reset");
+  }
+#if defined(RELAY_EXPANDER_CHIPS)
+  if (!expanders_found) {
+    debugE("Not all %d relay expanders answer on I2C",
+           RELAY_EXPANDER_CHIPS);
+  }
+#else
+#if defined(RELAY_SHIFT_REGISTERS)
+  if (!shift_bus_ready) {
+    debugE("Cannot set up SPI for the relay shift registers");
+  }
+#endif
   Wire.begin(I2C_SDA, I2C_SCL);
+#endif
+  WiFi.onEvent(on_wifi_got_ip, ARDUINO_EVENT_WIFI_STA_GOT_IP);
 
   // Build the SensESP application.
   SensESPAppBuilder builder;
@@ -38,88 +377,246 @@ void setup() {
   //                  ->enable_uptime_sensor()
                     ->get_app();
 
-  // GPIO configuration:
-  // Define the number of remote channels.
-  const int num_relays = 4;
-
-  int buttonPins[num_relays] = {16, 17, 18, 19};
-  int statusLEDPins[num_relays] = {12, 13, 14, 15};
-  int relayPins[num_relays] = {32, 33, 25, 26};
-
-  // Define SignalK paths for each relay.
-  const char* sk_path_relay_1 = "electrical.switches.light.cabin.state";
-  const char* sk_path_relay_2 = "electrical.switches.light.port.state";
-  const char* sk_path_relay_3 = "electrical.switches.light.starboard.state";
-  const char* sk_path_relay_4 = "electrical.switches.light.engine.state";
-
-  const char* default_sk_paths[num_relays] = {
-      "electrical.switches.light.cabin.state",
-      "electrical.switches.light.port.state",
-      "electrical.switches.light.starboard.state",
-      "electrical.switches.light.engine.state"};
-
-  Serial.println(F("Starting 4 individual relay switches with status LEDs..."));
-
-  for (int i = 0; i < num_relays; i++) {
-    int relayIndex = i;
-    auto* button =
-        new DigitalInputChange(buttonPins[relayIndex], INPUT_PULLUP, CHANGE);
-    auto* relay = new DigitalOutput(relayPins[relayIndex]);
-    std::string relay_title = "Relay " + std::to_string(relayIndex + 1) + " Output";
-
-    // ConfigItem(relay)
-    //     ->set_title(relay_title.c_str())
-    //     ->set_description("The GPIO pin that controls the relay.")
-    //     ->set_sort_order(100 + relayIndex);
-
-    auto led = new DigitalOutput(statusLEDPins[relayIndex]);
-
-    relay->set(1);
-
-    auto* debouncer = new Debounce<bool>(50);
-    button->connect_to(debouncer);
-
-    button->connect_to(new LambdaConsumer<bool>([relay](bool isPressed) {
-      if (isPressed) {
-        bool new_state = !relay->get();
-        relay->set(new_state);
-        debugD("Relay %d toggled to: %d", new_state);
-      }
-    }));
-
-    std::string configPath =
-        "/Control/Relay" + std::to_string(relayIndex + 1) + "/Value";
-    std::string sk_output_title =
-        "Relay " + std::to_string(relayIndex + 1) + " Configuration";
-    std::string sk_metadata_title = "Control relay state for relay " +
-                                    std::to_string(relayIndex + 1);
-    const char* sk_path = default_sk_paths[relayIndex];
-    auto metadata = std::make_shared<SKMetadata>("", sk_metadata_title.c_str());
-    
-    // Create the SKOutput for this relay channel.
-    auto* sk_output = new SKOutput<bool>(sk_path, configPath.c_str(), metadata);
-
-    // Wrap the SKOutput in a ConfigItem so that its SK path is configurable.
-    ConfigItem(sk_output)
-        ->set_title(sk_output_title.c_str())
-        ->set_description("The Signal K path to publish the state of this relay.")
-        ->set_sort_order(100 + relayIndex);
-    
-
-    // Connect relay1 to both its SignalK output and its status LED.
-    relay->connect_to(new Repeat<bool, bool>(10000))->connect_to(sk_output);
-    relay->connect_to(
-        new LambdaConsumer<bool>([led](bool state) { led->set(state); }));
-
-    // Add a SignalK PUT listener for Relay 1 using SKPutRequestListener.
-    auto relay_put_listener = new SKPutRequestListener<bool>(sk_path);
-    relay_put_listener->connect_to(
-        new LambdaConsumer<bool>([relay, led](bool new_state) {
-          relay->set(new_state);
-          led->set(new_state);
-          debugD("Relay1 updated from SK PUT to: %d", new_state);
-        }));
+  Serial.printf("Starting %u relay switches, %u with status LEDs...\n",
+                static_cast<unsigned>(num_relays),
+                static_cast<unsigned>(led_count(kChannelTable)));
+
+  journal.attach(&relay_bank);
+#if defined(RELAY_EXPANDER_CHIPS)
+  expander_buttons.begin(relay_bank, &expander, EXPANDER_INT_PIN, 50);
+#elif defined(RELAY_BUTTON_MATRIX)
+  matrix_buttons.begin(relay_bank, &button_matrix, 50, MATRIX_SCAN_PERIOD_US);
+#else
+  edge_capture.begin(relay_bank);
+  // Same 50 ms the unused Debounce<bool>(50) asked for, now on every button.
+  debouncer.begin(relay_bank, 50);
+#endif
+#if defined(RELAY_N2K_SWITCH_BANK)
+  // Switch panels on the N2K bus reach the relays with or without WiFi.
+  // The NAME: the board's part of the MAC, no manufacturer code, device
+  // class electrical distribution, function load controller, marine.
+  if (can_bus.begin()) {
+    n2k::Name name = {n2k::unique_number_from_mac(ESP.getEfuseMac()), 2046, 0,
+                      140, 30, 0, 4};
+    n2k_switch_bank.begin(name, N2K_SWITCH_INSTANCE);
+  } else {
+    debugE("Cannot start the CAN controller for NMEA 2000");
+  }
+#endif
+  signalk_bridge.begin(&arena);
+  for (size_t i = 0; i < num_relays; i++) {
+    delta_batcher.set_path(i, signalk_bridge.sk_path(i));
+  }
+
+  // Scenes switch several relays with one PUT. Their relays, names and paths
+  // can be changed in the web UI.
+  arena
+      .make<SceneControl<num_relays>>(
+          &relay_bank, "/Control/Scene1", "All lights",
+          "electrical.switches.scene.allLights.state", "1=on,2=on,3=on,4=on")
+      ->begin(&arena, 200);
+  arena
+      .make<SceneControl<num_relays>>(
+          &relay_bank, "/Control/Scene2", "Navigation",
+          "electrical.switches.scene.navigation.state", "2=on,3=on")
+      ->begin(&arena, 201);
+  arena
+      .make<SceneControl<num_relays>>(
+          &relay_bank, "/Control/Scene3", "Cabin only",
+          "electrical.switches.scene.cabinOnly.state", "1=on,2=off,3=off,4=off")
+      ->begin(&arena, 202);
+
+  // The publish rate limit can be changed in the web UI and takes effect
+  // after the restart that saving triggers.
+  PublishLimit limit;
+  auto* publish_rate =
+      arena.make<NumberConfig>(limit.rate_per_s, "/System/PublishLimit/Rate");
+  ConfigItem(publish_rate)
+      ->set_title("Relay Publish Rate (per s)")
+      ->set_description("Sustained deltas per second for one relay; "
+                        "0 for no limit. The final state is always sent.")
+      ->set_sort_order(250);
+  auto* publish_burst = arena.make<NumberConfig>(
+      static_cast<float>(limit.burst), "/System/PublishLimit/Burst");
+  ConfigItem(publish_burst)
+      ->set_title("Relay Publish Burst")
+      ->set_description("Deltas one relay may send back to back before the "
+                        "rate applies.")
+      ->set_sort_order(251);
+  auto* flap_changes = arena.make<NumberConfig>(
+      static_cast<float>(limit.flap_changes), "/System/PublishLimit/Flap");
+  ConfigItem(flap_changes)
+      ->set_title("Relay Flapping Threshold")
+      ->set_description("Raise a notification when one relay changes more "
+                        "often than this in 10 s.")
+      ->set_sort_order(252);
+  limit.rate_per_s = publish_rate->get_value();
+  limit.burst = static_cast<uint32_t>(publish_burst->get_value());
+  limit.flap_changes = static_cast<uint32_t>(flap_changes->get_value());
+  publish_limiter.begin(limit);
+
+  delta_sink.begin(1024);
+  delta_batcher.set_limiter(&publish_limiter);
+  delta_batcher.set_sent_observer(&latency);
+  delta_batcher.begin();
+  heartbeat.begin();
+  latency.begin();
+  add_latency_endpoint(&latency, &arena);
+  add_relay_api_endpoint(&relay_api, &arena);
+
+  // One reaction per pipeline stage, so that the profiler can tell them
+  // apart. Tick reactions run in the order they were added.
+#if defined(RELAY_EXPANDER_CHIPS)
+  event_loop()->onTick(tick_profiler.profiled(
+      "expanderButtons", []() { expander_buttons.tick(&relay_bank); }));
+#elif defined(RELAY_BUTTON_MATRIX)
+  event_loop()->onTick(tick_profiler.profiled(
+      "matrixButtons", []() { matrix_buttons.tick(&relay_bank); }));
+#else
+  event_loop()->onTick(tick_profiler.profiled(
+      "edgeCapture", []() { edge_capture.drain(&debouncer); }));
+  event_loop()->onTick(tick_profiler.profiled(
+      "debouncer", []() { debouncer.tick(&relay_bank); }));
+#endif
+  // Requests from the web server task are applied here, ahead of the
+  // output flush, like button presses.
+  event_loop()->onTick(
+      tick_profiler.profiled("relayApi", []() { relay_api.tick(); }));
+#if defined(RELAY_N2K_SWITCH_BANK)
+  event_loop()->onTick(tick_profiler.profiled(
+      "n2kSwitchBank", []() { n2k_switch_bank.tick(); }));
+#endif
+  event_loop()->onTick(
+      tick_profiler.profiled("heartbeat", []() { heartbeat.tick(); }));
+  event_loop()->onTick(
+      tick_profiler.profiled("deltaBatcher", []() {
+        delta_batcher.tick();
+        if (delta_batcher.deltas_sent() > 0) {
+          boot_timeline.mark(BootStage::kFirstDelta);
+        }
+      }));
+  event_loop()->onTick(
+      tick_profiler.profiled("journal", []() { journal.tick(); }));
+#if defined(RELAY_EXPANDER_CHIPS)
+  // Everything switched so far this tick goes out in one burst per chip.
+  event_loop()->onTick(
+      tick_profiler.profiled("expanderFlush", []() { expander.flush(); }));
+#elif defined(RELAY_SHIFT_REGISTERS)
+  // Everything switched so far this tick goes out in one SPI transfer.
+  event_loop()->onTick(tick_profiler.profiled(
+      "shiftFlush", []() { shift_output.flush(); }));
+#endif
+  // Erasing the next sector blocks for a few tens of milliseconds, so keep
+  // it out of the per-tick path.
+  event_loop()->onRepeat(1000, tick_profiler.profiled("journalErase", []() {
+    journal.maintain();
+  }));
+
+#if !defined(RELAY_EXPANDER_CHIPS) && !defined(RELAY_BUTTON_MATRIX)
+  // Button edges are only lost if the loop stalls for long enough to fill
+  // the ring; say so when it happens.
+  event_loop()->onRepeat(10000, tick_profiler.profiled("ringCheck", []() {
+    static uint32_t reported_overflows = 0;
+    uint32_t overflows = edge_capture.overflows();
+    if (overflows != reported_overflows) {
+      RELAY_TRACE(kEdgeOverflow, overflows - reported_overflows);
+      debugW("Button edge ring overflowed: %u edges lost, high water %u",
+             overflows - reported_overflows, edge_capture.high_water());
+      reported_overflows = overflows;
+    }
+  }));
+#endif
+
+  event_loop()->onRepeat(60000, tick_profiler.profiled("latencyReport", []() {
+    latency.publish(&delta_sink);
+  }));
+
+  // The profiler can be switched off and its overrun threshold changed in
+  // the web UI; both take effect after the restart that saving triggers.
+  auto* profiler_enabled =
+      arena.make<CheckboxConfig>(true, "Enabled",
+                                 "/System/TickProfiler/Enabled");
+  ConfigItem(profiler_enabled)
+      ->set_title("Event Loop Profiler")
+      ->set_description("Time every event loop tick and publish the "
+                        "statistics once a minute.")
+      ->set_sort_order(300);
+  auto* overrun_ms =
+      arena.make<NumberConfig>(TickProfiler::kDefaultOverrunUs / 1000.0f,
+                               "/System/TickProfiler/OverrunMs");
+  ConfigItem(overrun_ms)
+      ->set_title("Event Loop Overrun (ms)")
+      ->set_description("Warn when one event loop tick takes longer.")
+      ->set_sort_order(301);
+  tick_profiler.set_enabled(profiler_enabled->get_value());
+  tick_profiler.set_overrun_us(
+      static_cast<uint32_t>(overrun_ms->get_value() * 1000));
+  tick_profiler.set_overrun_handler(
+      [](uint32_t tick_us, const char* worst_section, uint32_t worst_us) {
+        RELAY_TRACE(kTickOverrun, tick_profiler.overrun_us() / 1000, tick_us,
+                    worst_us);
+        debugW("Event loop tick took %u us; longest reaction %s, %u us",
+               tick_us, worst_section != nullptr ? worst_section : "-",
+               worst_us);
+      });
+  event_loop()->onRepeat(60000, []() { tick_profiler.publish(&delta_sink); });
+
+  // Switching events are traced in binary rather than logged; fetch them
+  // from /api/relays/trace or by sending "t" on the serial console, and
+  // decode them with tools/trace_decode.py.
+  add_trace_endpoint(&arena);
+  event_loop()->onRepeat(100, poll_trace_serial);
+
+  event_loop()->onRepeat(60000, tick_profiler.profiled("memoryReport", []() {
+    publish_memory_report(arena, &delta_sink);
+  }));
+
+  event_loop()->onRepeat(1000, []() {
+    static bool published = false;
+    boot_timeline.trace_stamped();
+    if (published || !boot_timeline.complete()) {
+      return;
+    }
+    published = boot_timeline.publish(&delta_sink, kFirmwareBuild);
+    if (!published) {
+      return;
+    }
+    debugI("Boot: outputs valid at %u us, WiFi up at %u ms, first delta at "
+           "%u ms",
+           boot_timeline.at_us(BootStage::kOutputsValid),
+           boot_timeline.at_us(BootStage::kWifiUp) / 1000,
+           boot_timeline.at_us(BootStage::kFirstDelta) / 1000);
+  });
+
+  hal::HeapStats heap = hal::heap_stats();
+  debugI("Arena: %u of %u bytes used by %u objects, %u on the heap",
+         static_cast<unsigned>(arena.used()),
+         static_cast<unsigned>(arena.capacity()), arena.allocations(),
+         arena.overflows());
+  if (arena.overflows() > 0) {
+    debugE("Arena: %u objects did not fit in %u bytes and went to the heap; "
+           "raise kArenaFixedBytes",
+           arena.overflows(), static_cast<unsigned>(arena.capacity()));
   }
+  debugI("Heap: %u bytes free, largest block %u",
+         static_cast<unsigned>(heap.free_bytes),
+         static_cast<unsigned>(heap.largest_free_block));
+  debugI("Journal: %s, restored in %u us", journal.enabled() ? "on" : "off",
+         static_cast<unsigned>(journal.restore_us()));
+  debugI("RelayBank: %u channels, %u bytes/channel, %u bytes total",
+         static_cast<unsigned>(num_relays),
+         static_cast<unsigned>(RelayBank<num_relays>::kBytesPerChannel),
+         static_cast<unsigned>(sizeof(relay_bank)));
+  debugI("LatencyMonitor: %u bytes/channel, %u more for each of %u tracked, "
+         "%u bytes total",
+         static_cast<unsigned>(decltype(latency)::kBytesPerChannel),
+         static_cast<unsigned>(decltype(latency)::kBytesPerTrackedChannel),
+         static_cast<unsigned>(latency.tracked()),
+         static_cast<unsigned>(sizeof(latency)));
 }
 
-void loop() { event_loop()->tick(); }
\ No newline at end of file
+void loop() {
+  tick_profiler.begin_tick();
+  event_loop()->tick();
+  tick_profiler.end_tick();
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef RELAY_CONTROLLER_NATIVE_BENCH_H_
+#define RELAY_CONTROLLER_NATIVE_BENCH_H_
+
+// Helpers shared by the host benchmarks in src/native/.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Pin blocks far enough apart that 256 channels never collide, and all
+// within the simulated ports.
+constexpr int kButtonPinBase = 0;
+constexpr int kRelayPinBase = 256;
+constexpr int kLedPinBase = 512;
+
+// The device's four Signal K paths, followed by generated ones.
+std::string channel_path(int index);
+
+// Number of heap allocations made by this process so far.
+uint64_t allocations();
+
+// Spread between the first and last write to relay pins first, first + 1,
+// ..., first + count - 1 in nanoseconds. Zero when one store switched all.
+uint64_t switching_skew_ns(int first, size_t count);
+
+// Raw latency samples in nanoseconds.
+class Samples {
+ public:
+  void reserve(size_t n) { values_.reserve(n); }
+  void add(uint64_t ns) { values_.push_back(ns); }
+  size_t size() const { return values_.size(); }
+
+  // Nearest-rank percentile, p in [0, 100]. Sorts the samples in place.
+  uint64_t percentile(double p);
+  uint64_t max();
+
+ private:
+  std::vector<uint64_t> values_;
+  bool sorted_ = false;
+};
+
+// Print "label  p50  p99  max" with the figures in microseconds.
+void print_latency(const char* label, size_t channels, Samples& samples);
+
+void print_header(const char* title);
+
+void print_count(const char* label, size_t channels, uint64_t count,
+                 const char* unit);
+
+void print_allocations(const char* label, size_t channels, uint64_t count,
+                       uint64_t presses);
+
+// Individual benchmarks, run in order by bench_main.cpp.
+void run_legacy_graph_benchmark();
+void run_relay_bank_benchmark();
+void run_tick_profiler_benchmark();
+void run_trace_benchmark();
+void run_journal_benchmark();
+void run_expander_benchmark();
+void run_shift_register_benchmark();
+void run_button_matrix_benchmark();
+void run_delta_template_benchmark();
+void run_relay_api_benchmark();
+void run_n2k_benchmark();
+void run_publish_limiter_benchmark();
+void run_put_listener_benchmark();
+
+// Run a switch bank on a SocketCAN interface until interrupted.
+int serve_n2k_switch_bank(const char* interface);
+
+}  // namespace bench
+
+#endif  // RELAY_CONTROLLER_NATIVE_BENCH_H_
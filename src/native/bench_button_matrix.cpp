@@ -0,0 +1,130 @@
+// 64 buttons on a simulated 8 x 8 matrix: host CPU per idle check and per
+// full scan, with and without diodes, n-key rollover with every key held,
+// and whether a ghost on a diode-less panel switches a relay.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_hw.h"
+#include "native/sim_matrix.h"
+#include "relay/button_matrix.h"
+#include "relay/matrix_buttons.h"
+#include "relay/relay_bank.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::ButtonMatrix;
+using relay_controller::ChannelSpec;
+using relay_controller::kNoPin;
+using relay_controller::MatrixButtons;
+using relay_controller::MatrixWiring;
+using relay_controller::RelayBank;
+
+constexpr size_t kKeys = 64;
+constexpr int kScans = 20000;
+
+void run(bool diodes) {
+  sim::reset_hw();
+  // Rows on pins 0-7, columns on 8-15; the simulated lines settle at once.
+  MatrixWiring pins = {{0, 1, 2, 3, 4, 5, 6, 7},
+                       {8, 9, 10, 11, 12, 13, 14, 15},
+                       8,
+                       8,
+                       diodes,
+                       0};
+  sim::SimMatrix panel(pins);
+  ButtonMatrix matrix;
+  matrix.begin(pins);
+
+  static RelayBank<kKeys> bank;
+  static MatrixButtons<kKeys> buttons;
+  static std::vector<std::string> paths;
+  std::vector<ChannelSpec> specs;
+  paths.clear();
+  for (size_t i = 0; i < kKeys; i++) {
+    paths.push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < kKeys; i++) {
+    specs.push_back({{static_cast<uint16_t>(i), kNoPin,
+                      static_cast<uint16_t>(kRelayPinBase + i)},
+                     paths[i].c_str()});
+  }
+  bank.set_input_stage(&matrix);
+  bank.begin(specs.data(), false);
+  // No debounce and a scan on every tick, so that each tick is one scan.
+  buttons.begin(bank, &matrix, 0, 0);
+
+  const char* name = diodes ? "diodes" : "no diodes";
+  Samples idle;
+  Samples held;
+  idle.reserve(kScans);
+  held.reserve(kScans);
+  for (int i = 0; i < kScans; i++) {
+    uint64_t start = sim::now_ns();
+    buttons.tick(&bank);
+    idle.add(sim::now_ns() - start);
+  }
+  panel.set_key(0, true);
+  buttons.tick(&bank);
+  for (int i = 0; i < kScans; i++) {
+    uint64_t start = sim::now_ns();
+    buttons.tick(&bank);
+    held.add(sim::now_ns() - start);
+  }
+  panel.set_key(0, false);
+  buttons.tick(&bank);
+
+  // Hold every key, then let go of all of them: with diodes each one
+  // toggles its relay, without them only those pressed before they were
+  // hidden by ghost rectangles.
+  for (size_t k = 0; k < kKeys; k++) {
+    panel.set_key(k, true);
+    buttons.tick(&bank);
+  }
+  for (size_t k = 0; k < kKeys; k++) {
+    panel.set_key(k, false);
+  }
+  buttons.tick(&bank);
+  size_t toggled = 0;
+  for (size_t i = 0; i < kKeys; i++) {
+    toggled += bank.state(i) != (i == 0);
+  }
+
+  // Keys 0, 1 and 8 pressed: without diodes key 9 reads pressed as well.
+  bool before = bank.state(9);
+  uint32_t ghosts_before = matrix.ghost_scans();
+  for (int key : {0, 1, 8}) {
+    panel.set_key(key, true);
+    buttons.tick(&bank);
+  }
+  for (int key : {0, 1, 8}) {
+    panel.set_key(key, false);
+    buttons.tick(&bank);
+  }
+  bool ghost_switched = bank.state(9) != before;
+
+  std::string label = std::string("idle check, ") + name;
+  print_latency(label.c_str(), kKeys, idle);
+  label = std::string("full scan, ") + name;
+  print_latency(label.c_str(), kKeys, held);
+  printf("%-28s %8zu %10zu of %zu relays toggled with every key held\n",
+         name, kKeys, toggled, kKeys);
+  printf("%-28s %8zu %10u ghost scan(s), phantom key %s its relay\n", name,
+         kKeys, matrix.ghost_scans() - ghosts_before,
+         ghost_switched ? "switched" : "did not switch");
+}
+
+}  // namespace
+
+void run_button_matrix_benchmark() {
+  print_header("Button matrix, 8 x 8 on 16 pins, host CPU per tick");
+  run(true);
+  run(false);
+}
+
+}  // namespace bench
@@ -0,0 +1,253 @@
+// Cost of publishing relay states, per emit: the per-value JSON documents
+// of SKOutput<bool>, the deltas DeltaBatcher used to build with JsonWriter
+// on every flush, and the DeltaTemplate it patches now. For one changed
+// relay and for a heartbeat of the whole bank. Then a minute-long Signal K
+// outage: what piles up, and what goes out on reconnect.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_sensesp.h"
+#include "relay/delta_batcher.h"
+#include "relay/delta_sink.h"
+#include "relay/heartbeat_wheel.h"
+#include "relay/json_writer.h"
+#include "relay/relay_bank.h"
+#include "relay/sk_timestamp.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::ChangeSource;
+using relay_controller::ChannelSpec;
+using relay_controller::DeltaBatcher;
+using relay_controller::DeltaSink;
+using relay_controller::HeartbeatWheel;
+using relay_controller::JsonWriter;
+using relay_controller::kNoPin;
+using relay_controller::RelayBank;
+using relay_controller::RelayBankBase;
+
+constexpr int kEmits = 20000;
+constexpr size_t kBufferSize = 8192;
+
+class CountingSink : public DeltaSink {
+ public:
+  bool send_delta(const char* json, size_t length) override {
+    if (!up) {
+      return false;
+    }
+    bytes += length;
+    deltas++;
+    return true;
+  }
+  bool connected() override { return up; }
+
+  bool up = true;
+  uint64_t bytes = 0;
+  uint64_t deltas = 0;
+};
+
+// The delta DeltaBatcher built before it kept a template.
+size_t build_with_writer(char* buffer, const std::vector<std::string>& paths,
+                         const RelayBankBase& bank, size_t first,
+                         size_t count, uint64_t stamp_us) {
+  JsonWriter writer(buffer, kBufferSize);
+  char timestamp[relay_controller::kSKTimestampSize];
+  writer.raw("{\"updates\":[{");
+  if (relay_controller::format_sk_timestamp(stamp_us, timestamp,
+                                            sizeof(timestamp))) {
+    writer.raw("\"timestamp\":\"").raw(timestamp).raw("\",");
+  }
+  writer.raw("\"values\":[");
+  for (size_t i = first; i < first + count; i++) {
+    if (i > first) {
+      writer.raw(",");
+    }
+    writer.raw("{\"path\":")
+        .string(paths[i].c_str())
+        .raw(",\"value\":")
+        .boolean(bank.state(i))
+        .raw("}");
+  }
+  writer.raw("]}]}");
+  return writer.length();
+}
+
+void print_emit(const char* label, size_t channels, Samples& samples,
+                uint64_t allocated, uint64_t bytes) {
+  printf("%-28s %8zu %10.2f %10.2f %10.2f %8.2f %8.1f\n", label, channels,
+         samples.percentile(50) / 1000.0, samples.percentile(99) / 1000.0,
+         samples.max() / 1000.0, static_cast<double>(allocated) / kEmits,
+         static_cast<double>(bytes) / kEmits);
+}
+
+template <size_t N>
+void run() {
+  sim::reset();
+  static RelayBank<N> bank;
+  static CountingSink sink;
+  static DeltaBatcher<N, kBufferSize> batcher(&bank, &sink, 0);
+  static std::vector<std::string> paths;
+  static char buffer[kBufferSize];
+  std::vector<ChannelSpec> specs;
+  paths.clear();
+  for (size_t i = 0; i < N; i++) {
+    paths.push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < N; i++) {
+    specs.push_back({{kNoPin, kNoPin, static_cast<uint16_t>(kRelayPinBase + i)},
+                     paths[i].c_str()});
+  }
+  bank.begin(specs.data(), false);
+  batcher.begin();
+
+  // One SKOutput per channel, as the graph had.
+  auto metadata = std::make_shared<sensesp::SKMetadata>("", "relay");
+  std::vector<sensesp::SKOutput<bool>*> outputs;
+  for (size_t i = 0; i < N; i++) {
+    outputs.push_back(
+        new sensesp::SKOutput<bool>(paths[i], "/relay", metadata));
+  }
+
+  for (bool all : {false, true}) {
+    size_t values = all ? N : 1;
+    const char* what = all ? "heartbeat" : "one change";
+    Samples legacy;
+    Samples writer;
+    Samples templated;
+    uint64_t legacy_allocations = 0;
+    uint64_t writer_allocations = 0;
+    uint64_t template_allocations = 0;
+    uint64_t legacy_bytes = 0;
+    uint64_t writer_bytes = 0;
+    uint64_t template_bytes = 0;
+    for (int n = 0; n < kEmits; n++) {
+      size_t first = all ? 0 : n % N;
+      bank.set(first, !bank.state(first), ChangeSource::kRemote,
+               sim::now_ns() / 1000);
+      uint64_t stamp = sim::now_ns() / 1000;
+
+      uint64_t before_bytes = sim::signalk().bytes_sent();
+      uint64_t before = allocations();
+      uint64_t start = sim::now_ns();
+      for (size_t i = first; i < first + values; i++) {
+        outputs[i]->set(bank.state(i));
+      }
+      sim::signalk().send_pending();
+      legacy.add(sim::now_ns() - start);
+      legacy_allocations += allocations() - before;
+      legacy_bytes += sim::signalk().bytes_sent() - before_bytes;
+
+      before = allocations();
+      start = sim::now_ns();
+      size_t length = build_with_writer(buffer, paths, bank, first, values,
+                                        stamp);
+      sink.send_delta(buffer, length);
+      writer.add(sim::now_ns() - start);
+      writer_allocations += allocations() - before;
+      writer_bytes += length;
+
+      for (size_t i = first; i < first + values; i++) {
+        if (i != first) {
+          bank.refresh(i, stamp);
+        }
+      }
+      before = allocations();
+      uint64_t before_bytes_sent = sink.bytes;
+      start = sim::now_ns();
+      batcher.flush();
+      templated.add(sim::now_ns() - start);
+      template_allocations += allocations() - before;
+      template_bytes += sink.bytes - before_bytes_sent;
+    }
+    std::string label = std::string("SKOutput, ") + what;
+    print_emit(label.c_str(), N, legacy, legacy_allocations, legacy_bytes);
+    label = std::string("JsonWriter, ") + what;
+    print_emit(label.c_str(), N, writer, writer_allocations, writer_bytes);
+    label = std::string("template, ") + what;
+    print_emit(label.c_str(), N, templated, template_allocations,
+               template_bytes);
+  }
+  for (auto* output : outputs) {
+    delete output;
+  }
+}
+
+// 60 s without a server, with a change every 100 ms and the usual 10 s
+// heartbeats, then the reconnect.
+template <size_t N>
+void run_outage() {
+  sim::reset();
+  static RelayBank<N> bank;
+  static CountingSink sink;
+  static DeltaBatcher<N, kBufferSize> batcher(&bank, &sink, 10000);
+  static HeartbeatWheel<N> heartbeat(&bank);
+  static std::vector<std::string> paths;
+  std::vector<ChannelSpec> specs;
+  paths.clear();
+  for (size_t i = 0; i < N; i++) {
+    paths.push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < N; i++) {
+    specs.push_back({{kNoPin, kNoPin, static_cast<uint16_t>(kRelayPinBase + i)},
+                     paths[i].c_str()});
+  }
+  bank.begin(specs.data(), false);
+  batcher.begin();
+  heartbeat.begin();
+
+  auto tick = [&]() {
+    heartbeat.tick();
+    batcher.tick();
+  };
+  sink.up = false;
+  uint32_t changes = 0;
+  uint64_t allocated_before = allocations();
+  for (int ms = 0; ms < 60000; ms++) {
+    if (ms % 100 == 0) {
+      size_t channel = changes++ % N;
+      bank.set(channel, !bank.state(channel), ChangeSource::kRemote,
+               sim::now_ns() / 1000);
+    }
+    tick();
+    sim::advance_clock(1000);
+  }
+  uint64_t offline_deltas = sink.deltas;
+  sink.up = true;
+  // The replay waits for one batching window after the last failure.
+  for (int ms = 0; ms < 20; ms++) {
+    tick();
+    sim::advance_clock(1000);
+  }
+  uint64_t allocated = allocations() - allocated_before;
+  printf("%-28s %8zu %u changes, %u updates folded into marks, %llu "
+         "deltas while offline\n",
+         "outage 60 s", N, changes, batcher.coalesced(),
+         static_cast<unsigned long long>(offline_deltas));
+  printf("%-28s %8zu %llu delta(s), %llu bytes, %u values on reconnect; "
+         "outbox %zu bytes, %llu allocations\n",
+         "reconnect", N, static_cast<unsigned long long>(sink.deltas),
+         static_cast<unsigned long long>(sink.bytes), batcher.values_sent(),
+         sizeof(relay_controller::ChannelSet<N>),
+         static_cast<unsigned long long>(allocated));
+}
+
+}  // namespace
+
+void run_delta_template_benchmark() {
+  printf("\nPublishing relay states, per emit\n");
+  printf("%-28s %8s %10s %10s %10s %8s %8s\n", "path", "channels", "p50 us",
+         "p99 us", "max us", "allocs", "bytes");
+  run<4>();
+  run<16>();
+  run<64>();
+  printf("\nSignal K outage and reconnect\n");
+  run_outage<4>();
+  run_outage<64>();
+}
+
+}  // namespace bench
@@ -0,0 +1,195 @@
+// RelayBank on simulated I2C expanders: bus traffic per button press and
+// per full-bank change, traffic while idle, and press-to-relay latency,
+// for 64 channels on eight MCP23017 or PCF8575 chips, and the traffic per
+// debounced press for one to eight chips.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_hw.h"
+#include "native/sim_i2c.h"
+#include "relay/expander_buttons.h"
+#include "relay/i2c_expander.h"
+#include "relay/relay_bank.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::ChangeSource;
+using relay_controller::ChannelSet;
+using relay_controller::ChannelSpec;
+using relay_controller::ExpanderButtons;
+using relay_controller::I2cExpanderBank;
+using relay_controller::kNoPin;
+using relay_controller::RelayBank;
+
+constexpr int kInterruptPin = 760;
+constexpr int kPresses = 2000;
+constexpr int kIdleTicks = 10000;
+// As on the device.
+constexpr uint32_t kDebounceMs = 50;
+constexpr uint32_t kSamplePeriodUs = 2000;
+
+// Port A drives eight relays, port B reads their eight buttons.
+uint16_t relay_pin(size_t channel) {
+  return static_cast<uint16_t>(channel / 8 * 16 + channel % 8);
+}
+uint16_t button_pin(size_t channel) { return relay_pin(channel) + 8; }
+
+struct Models {
+  sim::SimExpander::Model sim;
+  I2cExpanderBank::Model model;
+  const char* name;
+};
+
+// Bus traffic per press, from the press to the relay switching after the
+// release.
+struct PressTraffic {
+  double transactions;
+  double bytes;
+  double wire_us;
+};
+
+// kChips chips, eight channels each. With debounce_ms 0 every press and
+// release is read in one tick and the release->relay latency goes to
+// latency; otherwise the loop ticks every millisecond until the buttons
+// settle. details prints boot, idle and full-bank traffic as well.
+template <size_t kChips>
+PressTraffic run(const Models& models, uint32_t debounce_ms, bool details,
+                 Samples* latency) {
+  constexpr size_t kChannels = kChips * 8;
+  sim::reset_hw();
+  sim::SimI2cBus bus(kInterruptPin);
+  std::vector<sim::SimExpander> chips(kChips, sim::SimExpander(models.sim));
+  for (size_t c = 0; c < kChips; c++) {
+    bus.attach(0x20 + c, &chips[c]);
+  }
+  I2cExpanderBank expander(&bus, models.model, 0x20, kChips);
+  expander.begin();
+
+  static RelayBank<kChannels> bank;
+  static ExpanderButtons<kChannels> buttons;
+  static std::vector<std::string> paths;
+  paths.clear();
+  std::vector<ChannelSpec> specs;
+  for (size_t i = 0; i < kChannels; i++) {
+    paths.push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < kChannels; i++) {
+    specs.push_back({{button_pin(i), kNoPin, relay_pin(i)}, paths[i].c_str()});
+  }
+  bank.set_output_stages(&expander, &expander);
+  bank.set_input_stage(&expander);
+  bus.reset_stats();
+  bank.begin(specs.data(), true);
+  expander.flush();
+  uint64_t boot_transactions = bus.transactions();
+  buttons.begin(bank, &expander, kInterruptPin, debounce_ms,
+                debounce_ms == 0 ? 0 : kSamplePeriodUs);
+
+  auto tick = [&]() {
+    buttons.tick(&bank);
+    expander.flush();
+  };
+  // Long enough for the buttons to settle, with some ticks to spare.
+  uint32_t settle_ticks = debounce_ms == 0 ? 1 : debounce_ms + 10;
+  auto run_for_settling = [&]() {
+    for (uint32_t t = 0; t < settle_ticks; t++) {
+      if (debounce_ms != 0) {
+        sim::advance_clock(1000);
+      }
+      tick();
+    }
+  };
+
+  bus.reset_stats();
+  for (int i = 0; i < kIdleTicks; i++) {
+    tick();
+  }
+  uint64_t idle_transactions = bus.transactions();
+
+  std::mt19937 random(1);
+  bus.reset_stats();
+  for (int i = 0; i < kPresses; i++) {
+    size_t channel = random() % kChannels;
+    sim::SimExpander& chip = chips[channel / 8];
+    chip.set_input(8 + channel % 8, false);
+    run_for_settling();
+    uint64_t released = sim::now_ns();
+    chip.set_input(8 + channel % 8, true);
+    run_for_settling();
+    if (latency != nullptr) {
+      latency->add(chip.last_output_ns() - released);
+    }
+  }
+  PressTraffic traffic = {
+      static_cast<double>(bus.transactions()) / kPresses,
+      static_cast<double>(bus.bytes()) / kPresses,
+      bus.wire_ns() / 1000.0 / kPresses};
+  if (!details) {
+    return traffic;
+  }
+
+  ChannelSet<kChannels> all;
+  ChannelSet<kChannels> off;
+  for (size_t i = 0; i < kChannels; i++) {
+    all.set(i);
+  }
+  bus.reset_stats();
+  bank.set_group(all, off, ChangeSource::kRemote, 0);
+  expander.flush();
+
+  printf("%-10s boot %llu transactions, idle %llu per %d ticks\n",
+         models.name, static_cast<unsigned long long>(boot_transactions),
+         static_cast<unsigned long long>(idle_transactions), kIdleTicks);
+  printf("%-10s press, no debounce: %.2f transactions, %.1f bytes, %.0f us "
+         "on the wire at 400 kHz\n",
+         models.name, traffic.transactions, traffic.bytes, traffic.wire_us);
+  printf("%-10s full-bank change: %llu transactions, %llu bytes, %.0f us\n",
+         models.name, static_cast<unsigned long long>(bus.transactions()),
+         static_cast<unsigned long long>(bus.bytes()), bus.wire_ns() / 1000.0);
+  return traffic;
+}
+
+template <size_t kChips>
+void print_press_traffic(const Models& models) {
+  PressTraffic traffic = run<kChips>(models, kDebounceMs, false, nullptr);
+  printf("%-10s %6zu %14.2f %10.1f %10.0f\n", models.name, kChips,
+         traffic.transactions, traffic.bytes, traffic.wire_us);
+}
+
+}  // namespace
+
+void run_expander_benchmark() {
+  const Models models[] = {
+      {sim::SimExpander::Model::kMcp23017, I2cExpanderBank::Model::kMcp23017,
+       "MCP23017"},
+      {sim::SimExpander::Model::kPcf8575, I2cExpanderBank::Model::kPcf8575,
+       "PCF8575"},
+  };
+  printf("\nRelayBank on I2C expanders, 64 channels on 8 chips\n");
+  for (const Models& m : models) {
+    Samples latency;
+    latency.reserve(kPresses);
+    run<8>(m, 0, true, &latency);
+    print_header("Expander release->relay (host CPU only)");
+    print_latency(m.name, 64, latency);
+  }
+
+  printf("\nI2C traffic per press, %u ms debounce sampled every %u us\n",
+         kDebounceMs, kSamplePeriodUs);
+  printf("%-10s %6s %14s %10s %10s\n", "chip", "chips", "transactions",
+         "bytes", "wire us");
+  for (const Models& m : models) {
+    print_press_traffic<1>(m);
+    print_press_traffic<2>(m);
+    print_press_traffic<4>(m);
+    print_press_traffic<8>(m);
+  }
+}
+
+}  // namespace bench
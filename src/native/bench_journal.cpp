@@ -0,0 +1,100 @@
+// Flash wear and restore time of the relay state journal: random toggles
+// through a RelayBank into a StateJournal on simulated NOR flash, then a
+// fresh journal restoring from the same flash, as after a power cut.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_flash.h"
+#include "native/sim_hw.h"
+#include "relay/relay_bank.h"
+#include "relay/state_journal.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::ChangeSource;
+using relay_controller::ChannelSet;
+using relay_controller::ChannelSpec;
+using relay_controller::RelayBank;
+using relay_controller::StateJournal;
+
+constexpr size_t kSectorSize = 4096;
+constexpr size_t kSectors = 4;
+constexpr int kToggles = 10000;
+// Ten times faster than the journal writes.
+constexpr uint64_t kToggleIntervalUs = 100000;
+
+template <size_t N>
+void run() {
+  sim::reset_hw();
+  sim::SimFlash flash(kSectorSize, kSectors);
+
+  static RelayBank<N> bank;
+  static StateJournal<N> journal;
+  std::vector<ChannelSpec> specs;
+  for (size_t i = 0; i < N; i++) {
+    specs.push_back({{static_cast<uint16_t>(kButtonPinBase + i),
+                      static_cast<uint16_t>(kLedPinBase + i),
+                      static_cast<uint16_t>(kRelayPinBase + i)},
+                     ""});
+  }
+  journal.begin(&flash, true);
+  bank.begin(specs.data(), journal.states());
+  journal.attach(&bank);
+
+  std::mt19937 random(1);
+  for (int i = 0; i < kToggles; i++) {
+    bank.toggle(random() % N, ChangeSource::kButton, 0);
+    sim::advance_clock(kToggleIntervalUs);
+    journal.tick();
+    // Once a second on the device, which is more often than relays change.
+    journal.maintain();
+  }
+  // The changes held back by the last interval.
+  sim::advance_clock(StateJournal<N>::kDefaultWriteIntervalUs);
+  journal.tick();
+
+  static StateJournal<N> restored;
+  auto start = std::chrono::steady_clock::now();
+  bool found = restored.begin(&flash, false);
+  std::chrono::duration<double, std::micro> restore_time =
+      std::chrono::steady_clock::now() - start;
+  bool match = found;
+  for (size_t i = 0; i < N; i++) {
+    match &= restored.states().test(i) == bank.state(i);
+  }
+
+  uint32_t min_erases = UINT32_MAX;
+  uint32_t max_erases = 0;
+  for (size_t s = 0; s < kSectors; s++) {
+    min_erases = std::min(min_erases, flash.erase_count(s));
+    max_erases = std::max(max_erases, flash.erase_count(s));
+  }
+  printf("%8zu %10u %10u %10u %10.2f %10.2f %10s\n", N,
+         journal.changes_written(), min_erases, max_erases,
+         static_cast<double>(flash.bytes_written()) /
+             journal.changes_written(),
+         restore_time.count(), match ? "yes" : "NO");
+}
+
+}  // namespace
+
+void run_journal_benchmark() {
+  printf("\nState journal, %d toggles %llu ms apart, %zu x %zu byte "
+         "sectors\n",
+         kToggles, static_cast<unsigned long long>(kToggleIntervalUs / 1000),
+         kSectors, kSectorSize);
+  printf("%8s %10s %10s %10s %10s %10s %10s\n", "channels", "records",
+         "min erase", "max erase", "B/record", "restore us", "restored");
+  run<4>();
+  run<64>();
+  run<255>();
+}
+
+}  // namespace bench
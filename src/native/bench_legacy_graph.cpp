@@ -0,0 +1,97 @@
+// Button-to-relay and button-to-delta latency of the SensESP graph setup()
+// used to build, as the baseline for RelayBank.
+
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/legacy_graph.h"
+#include "native/sim_sensesp.h"
+
+namespace bench {
+
+namespace {
+
+constexpr int kPresses = 4000;
+
+void run(int num_channels) {
+  sim::reset();
+
+  std::vector<std::string> paths;
+  for (int i = 0; i < num_channels; i++) {
+    paths.push_back(channel_path(i));
+    relay_controller::build_relay_channel(i, kButtonPinBase + i,
+                                          kLedPinBase + i, kRelayPinBase + i,
+                                          paths.back().c_str());
+  }
+  sensesp::event_loop()->tick();
+
+  Samples to_relay;
+  Samples to_delta;
+  to_relay.reserve(kPresses);
+  to_delta.reserve(kPresses);
+  uint64_t allocations_before = allocations();
+
+  for (int n = 0; n < kPresses; n++) {
+    int channel = n % num_channels;
+    int button_pin = kButtonPinBase + channel;
+
+    // The graph toggles when it reads a high level, so press = rising edge.
+    sim::drive_input(button_pin, false);
+    sensesp::event_loop()->tick();
+
+    uint64_t writes_before = sim::write_count(kRelayPinBase + channel);
+    uint64_t edge_ns = sim::now_ns();
+    sim::drive_input(button_pin, true);
+    while (sim::signalk().last_sent_ns(paths[channel]) < edge_ns) {
+      sensesp::event_loop()->tick();
+    }
+    if (sim::write_count(kRelayPinBase + channel) == writes_before) {
+      continue;
+    }
+    to_relay.add(sim::last_write_ns(kRelayPinBase + channel) - edge_ns);
+    to_delta.add(sim::signalk().last_sent_ns(paths[channel]) - edge_ns);
+  }
+
+  uint64_t allocated = allocations() - allocations_before;
+
+  print_latency("legacy edge->relay", num_channels, to_relay);
+  print_latency("legacy edge->delta", num_channels, to_delta);
+  print_allocations("legacy incl. SK transport", num_channels, allocated,
+                    kPresses);
+
+  // Turn everything on, then measure turning everything off.
+  for (int i = 0; i < num_channels; i++) {
+    sim::signalk().put(paths[i], true);
+  }
+  sensesp::event_loop()->tick();
+  uint64_t messages_before = sim::signalk().messages_sent();
+  for (int i = 0; i < num_channels; i++) {
+    sim::signalk().put(paths[i], false);
+  }
+  sensesp::event_loop()->tick();
+  print_count("legacy full-bank change", num_channels,
+              sim::signalk().messages_sent() - messages_before, "messages");
+  print_count("legacy full-bank skew", num_channels,
+              switching_skew_ns(kRelayPinBase, num_channels), "ns");
+
+  // Let three Repeat periods pass.
+  messages_before = sim::signalk().messages_sent();
+  for (int period = 0; period < 3; period++) {
+    sim::advance_clock(10000000);
+    sensesp::event_loop()->tick();
+  }
+  print_count("legacy 3 heartbeats", num_channels,
+              sim::signalk().messages_sent() - messages_before, "messages");
+}
+
+}  // namespace
+
+void run_legacy_graph_benchmark() {
+  print_header("SensESP graph (build_relay_channel)");
+  for (int channels : {4, 32, 256}) {
+    run(channels);
+  }
+}
+
+}  // namespace bench
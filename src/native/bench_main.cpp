@@ -0,0 +1,133 @@
+// Host benchmarks for the relay controller.
+//
+// Build and run with:
+//   pio run -e native && .pio/build/native/program
+// or serve a four-relay NMEA 2000 switch bank on a SocketCAN interface:
+//   .pio/build/native/program n2k vcan0
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "native/bench.h"
+#include "native/sim_hw.h"
+
+namespace {
+
+std::atomic<uint64_t> allocation_count{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace bench {
+
+namespace {
+
+const char* const kDefaultPaths[] = {
+    "electrical.switches.light.cabin.state",
+    "electrical.switches.light.port.state",
+    "electrical.switches.light.starboard.state",
+    "electrical.switches.light.engine.state"};
+
+}  // namespace
+
+std::string channel_path(int index) {
+  if (index < 4) {
+    return kDefaultPaths[index];
+  }
+  return "electrical.switches.light.channel" + std::to_string(index + 1) +
+         ".state";
+}
+
+uint64_t allocations() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t switching_skew_ns(int first, size_t count) {
+  uint64_t earliest = UINT64_MAX;
+  uint64_t latest = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t written = sim::last_write_ns(first + i);
+    earliest = std::min(earliest, written);
+    latest = std::max(latest, written);
+  }
+  return count == 0 ? 0 : latest - earliest;
+}
+
+uint64_t Samples::percentile(double p) {
+  if (values_.empty()) {
+    return 0;
+  }
+  if (!sorted_) {
+    std::sort(values_.begin(), values_.end());
+    sorted_ = true;
+  }
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values_.size()));
+  return values_[rank == 0 ? 0 : rank - 1];
+}
+
+uint64_t Samples::max() { return percentile(100.0); }
+
+void print_header(const char* title) {
+  printf("\n%s\n", title);
+  printf("%-28s %8s %10s %10s %10s\n", "path", "channels", "p50 us",
+         "p99 us", "max us");
+}
+
+void print_latency(const char* label, size_t channels, Samples& samples) {
+  printf("%-28s %8zu %10.2f %10.2f %10.2f\n", label, channels,
+         samples.percentile(50) / 1000.0, samples.percentile(99) / 1000.0,
+         samples.max() / 1000.0);
+}
+
+void print_count(const char* label, size_t channels, uint64_t count,
+                 const char* unit) {
+  printf("%-28s %8zu %10llu %s\n", label, channels,
+         static_cast<unsigned long long>(count), unit);
+}
+
+void print_allocations(const char* label, size_t channels, uint64_t count,
+                       uint64_t presses) {
+  printf("%-28s %8zu %10.2f allocations/press\n", label, channels,
+         presses == 0 ? 0.0 : static_cast<double>(count) / presses);
+}
+
+}  // namespace bench
+
+// pio test builds these sources into each test, which has its own main().
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char** argv) {
+  if (argc == 3 && strcmp(argv[1], "n2k") == 0) {
+    return bench::serve_n2k_switch_bank(argv[2]);
+  }
+  bench::run_legacy_graph_benchmark();
+  bench::run_relay_bank_benchmark();
+  bench::run_tick_profiler_benchmark();
+  bench::run_trace_benchmark();
+  bench::run_journal_benchmark();
+  bench::run_expander_benchmark();
+  bench::run_shift_register_benchmark();
+  bench::run_button_matrix_benchmark();
+  bench::run_delta_template_benchmark();
+  bench::run_relay_api_benchmark();
+  bench::run_n2k_benchmark();
+  bench::run_publish_limiter_benchmark();
+  bench::run_put_listener_benchmark();
+  return 0;
+}
+#endif  // PIO_UNIT_TESTING
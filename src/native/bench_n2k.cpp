@@ -0,0 +1,246 @@
+// RelayBank as an NMEA 2000 switch bank on a simulated CAN bus: control
+// frame to relay latency, the status frames a full-bank change sends, the
+// bus load of the periodic status, and an address contest. With
+// RELAY_N2K_CAN set to a SocketCAN interface such as vcan0, the control to
+// status round trip is also timed through the kernel.
+//
+// "program n2k vcan0" instead runs a four-relay bank on vcan0 until it is
+// interrupted, for candump and cansend.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_can.h"
+#include "native/sim_sensesp.h"
+#include "native/socket_can_bus.h"
+#include "relay/n2k.h"
+#include "relay/n2k_switch_bank.h"
+#include "relay/relay_bank.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::CanBus;
+using relay_controller::CanFrame;
+using relay_controller::ChannelSpec;
+using relay_controller::kNoPin;
+using relay_controller::N2kSwitchBank;
+using relay_controller::RelayBank;
+using relay_controller::SocketCanBus;
+namespace n2k = relay_controller::n2k;
+
+constexpr int kCommands = 4000;
+constexpr uint8_t kPanelAddress = 1;
+constexpr n2k::Name kName = {0x12345, 2046, 0, 140, 30, 0, 4};
+
+// Switch every relay of bank b on or off, as a panel would.
+CanFrame control_frame(size_t b, size_t channels, bool on) {
+  CanFrame frame = {n2k::make_id(3, n2k::kSwitchBankControl, kPanelAddress),
+                    8,
+                    {}};
+  for (auto& byte : frame.data) {
+    byte = 0xff;
+  }
+  frame.data[0] = static_cast<uint8_t>(b);
+  for (size_t s = 0; s < n2k::kSwitchesPerBank &&
+                     b * n2k::kSwitchesPerBank + s < channels;
+       s++) {
+    n2k::set_switch_field(frame.data, s,
+                          on ? n2k::kSwitchOn : n2k::kSwitchOff);
+  }
+  return frame;
+}
+
+template <size_t N>
+void begin_bank(RelayBank<N>* bank, std::vector<std::string>* paths) {
+  std::vector<ChannelSpec> specs;
+  paths->clear();
+  for (size_t i = 0; i < N; i++) {
+    paths->push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < N; i++) {
+    specs.push_back({{kNoPin, kNoPin, static_cast<uint16_t>(kRelayPinBase + i)},
+                     (*paths)[i].c_str()});
+  }
+  bank->begin(specs.data(), false);
+}
+
+template <size_t N>
+void run() {
+  using SwitchBank = N2kSwitchBank<N>;
+  sim::reset();
+  static RelayBank<N> bank;
+  static sim::SimCanBus bus;
+  static SwitchBank switch_bank(&bank, &bus);
+  static std::vector<std::string> paths;
+  begin_bank(&bank, &paths);
+  switch_bank.begin(kName, 0);
+  sim::advance_clock(SwitchBank::kClaimSettleUs);
+  switch_bank.tick();
+  bus.clear_sent();
+
+  Samples control;
+  uint64_t control_allocations = 0;
+  uint64_t status_frames = 0;
+  for (int n = 0; n < kCommands; n++) {
+    bool on = n % 2 == 0;
+    for (size_t b = 0; b < SwitchBank::kBanks; b++) {
+      bus.inject(control_frame(b, N, on));
+    }
+    uint64_t before = allocations();
+    uint64_t start = sim::now_ns();
+    switch_bank.tick();
+    uint64_t elapsed = sim::now_ns() - start;
+    control_allocations += allocations() - before;
+    control.add(elapsed);
+    if (bank.state(N - 1) != on) {
+      printf("control frame not applied\n");
+      return;
+    }
+    status_frames += bus.sent().size();
+    bus.clear_sent();
+  }
+  print_latency("N2K control, whole bank", N, control);
+  print_count("N2K status per change", N, status_frames / kCommands,
+              "frames");
+  print_allocations("N2K engine", N, control_allocations, kCommands);
+
+  // A minute of periodic status with nothing changing.
+  bus.reset_stats();
+  for (int ms = 0; ms < 60000; ms++) {
+    sim::advance_clock(1000);
+    switch_bank.tick();
+  }
+  bus.clear_sent();
+  printf("%-28s %8zu %10llu frames/min, %.3f%% of the bus\n",
+         "N2K periodic status", N,
+         static_cast<unsigned long long>(bus.frames()),
+         bus.wire_ns() / 60e9 * 100);
+}
+
+// Another device claims the bank's address, first with a higher NAME, then
+// with the same NAME and then with a lower one.
+void run_address_contest() {
+  using SwitchBank = N2kSwitchBank<4>;
+  sim::reset();
+  static RelayBank<4> bank;
+  static sim::SimCanBus bus;
+  static SwitchBank switch_bank(&bank, &bus);
+  static std::vector<std::string> paths;
+  begin_bank(&bank, &paths);
+  switch_bank.begin(kName, 0);
+  uint8_t addresses[4] = {switch_bank.address()};
+  uint64_t others[] = {kName.value() + 1, kName.value(), kName.value() - 1};
+  for (size_t n = 0; n < 3; n++) {
+    CanFrame claim = {
+        n2k::make_id(6, n2k::kIsoAddressClaim, switch_bank.address()), 8, {}};
+    for (size_t i = 0; i < 8; i++) {
+      claim.data[i] = static_cast<uint8_t>(others[n] >> (8 * i));
+    }
+    bus.inject(claim);
+    switch_bank.tick();
+    addresses[n + 1] = switch_bank.address();
+  }
+  printf("%-28s %8d kept %u to a higher NAME, moved to %u on an equal one "
+         "and to %u on a lower one\n",
+         "N2K address contest", 4, addresses[1], addresses[2], addresses[3]);
+}
+
+template <size_t N>
+void run_socket_can(const char* interface) {
+  using SwitchBank = N2kSwitchBank<N>;
+  sim::reset();
+  static SocketCanBus device_bus;
+  static SocketCanBus panel_bus;
+  if (!device_bus.open(interface) || !panel_bus.open(interface)) {
+    printf("%-28s %8zu could not open %s\n", "N2K over SocketCAN", N,
+           interface);
+    return;
+  }
+  static RelayBank<N> bank;
+  static SwitchBank switch_bank(&bank, &device_bus);
+  static std::vector<std::string> paths;
+  begin_bank(&bank, &paths);
+  switch_bank.begin(kName, 0);
+  sim::advance_clock(SwitchBank::kClaimSettleUs);
+  switch_bank.tick();
+
+  Samples to_relay;
+  Samples to_status;
+  CanFrame frame;
+  for (int n = 0; n < kCommands / 4; n++) {
+    while (panel_bus.receive(&frame)) {
+    }
+    bool on = n % 2 == 0;
+    uint64_t start = sim::now_ns();
+    panel_bus.send(control_frame(0, N, on));
+    uint64_t deadline = start + 100000000;
+    while (bank.state(0) != on && sim::now_ns() < deadline) {
+      switch_bank.tick();
+    }
+    to_relay.add(sim::now_ns() - start);
+    bool acknowledged = false;
+    while (!acknowledged && sim::now_ns() < deadline) {
+      switch_bank.tick();
+      acknowledged =
+          panel_bus.receive(&frame) &&
+          n2k::parse_id(frame.id).pgn == n2k::kSwitchBankStatus &&
+          n2k::switch_field(frame.data, 0) ==
+              (on ? n2k::kSwitchOn : n2k::kSwitchOff);
+    }
+    to_status.add(sim::now_ns() - start);
+  }
+  std::string label = std::string(interface) + " control->relay";
+  print_latency(label.c_str(), N, to_relay);
+  label = std::string(interface) + " control->status";
+  print_latency(label.c_str(), N, to_status);
+}
+
+}  // namespace
+
+void run_n2k_benchmark() {
+  print_header("NMEA 2000 switch bank");
+  run<4>();
+  run<28>();
+  run<64>();
+  run_address_contest();
+  if (const char* interface = getenv("RELAY_N2K_CAN")) {
+    run_socket_can<28>(interface);
+  }
+}
+
+int serve_n2k_switch_bank(const char* interface) {
+  sim::reset();
+  static SocketCanBus bus;
+  if (!bus.open(interface)) {
+    fprintf(stderr, "could not open %s\n", interface);
+    return 1;
+  }
+  static RelayBank<4> bank;
+  static N2kSwitchBank<4> switch_bank(&bank, &bus);
+  static std::vector<std::string> paths;
+  begin_bank(&bank, &paths);
+  switch_bank.begin(kName, 0);
+  printf("switch bank 0 with 4 relays on %s, address %u\n", interface,
+         switch_bank.address());
+  bool states[4] = {};
+  for (;;) {
+    switch_bank.tick();
+    for (size_t i = 0; i < 4; i++) {
+      if (bank.state(i) != states[i]) {
+        states[i] = bank.state(i);
+        printf("relay %zu %s\n", i + 1, states[i] ? "on" : "off");
+        fflush(stdout);
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+}  // namespace bench
@@ -0,0 +1,123 @@
+// A delta storm: one relay flipped every 10 ms for 10 s, as a chattering
+// input or a PUT loop would, then left alone. Deltas and bytes published
+// with and without a PublishLimiter, whether the final state got out, and
+// the flapping notifications.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_sensesp.h"
+#include "relay/delta_batcher.h"
+#include "relay/delta_sink.h"
+#include "relay/publish_limiter.h"
+#include "relay/relay_bank.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::ChangeSource;
+using relay_controller::ChannelSpec;
+using relay_controller::DeltaBatcher;
+using relay_controller::DeltaSink;
+using relay_controller::kNoPin;
+using relay_controller::PublishLimit;
+using relay_controller::PublishLimiter;
+using relay_controller::RelayBank;
+
+constexpr int kStormMs = 10000;
+constexpr int kFlipEveryMs = 10;
+constexpr int kSettleMs = 15000;
+
+class RecordingSink : public DeltaSink {
+ public:
+  bool send_delta(const char* json, size_t length) override {
+    std::string delta(json, length);
+    if (delta.find("notifications.") != std::string::npos) {
+      notifications++;
+      return true;
+    }
+    deltas++;
+    bytes += length;
+    // The channel's value in the newest delta that carried it.
+    size_t at = delta.find(path);
+    if (at != std::string::npos) {
+      size_t value = delta.find("\"value\":", at) + 8;
+      last_value = delta.compare(value, 4, "true") == 0 ? 1 : 0;
+    }
+    return true;
+  }
+
+  std::string path;
+  uint64_t deltas = 0;
+  uint64_t bytes = 0;
+  uint64_t notifications = 0;
+  int last_value = -1;
+};
+
+// Each combination gets its own statics: observers cannot be registered
+// with a bank twice.
+template <size_t N, bool limited>
+void run() {
+  sim::reset();
+  static RelayBank<N> bank;
+  static RecordingSink sink;
+  static DeltaBatcher<N, 8192> batcher(&bank, &sink, 10000);
+  static PublishLimiter<N> limiter(&bank);
+  static std::vector<std::string> paths;
+  std::vector<ChannelSpec> specs;
+  paths.clear();
+  for (size_t i = 0; i < N; i++) {
+    paths.push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < N; i++) {
+    specs.push_back({{kNoPin, kNoPin, static_cast<uint16_t>(kRelayPinBase + i)},
+                     paths[i].c_str()});
+  }
+  sink = RecordingSink();
+  sink.path = "\"" + paths[0] + "\"";
+  bank.begin(specs.data(), false);
+  PublishLimit limit;
+  if (limited) {
+    limiter.begin(limit);
+    batcher.set_limiter(&limiter);
+  }
+  batcher.begin();
+
+  for (int ms = 0; ms < kStormMs + kSettleMs; ms++) {
+    if (ms < kStormMs && ms % kFlipEveryMs == 0) {
+      bank.set(0, !bank.state(0), ChangeSource::kRemote,
+               sim::now_ns() / 1000);
+    }
+    batcher.tick();
+    sim::advance_clock(1000);
+  }
+  bool final_published = sink.last_value == (bank.state(0) ? 1 : 0);
+  char label[32] = "storm, no limit";
+  if (limited) {
+    snprintf(label, sizeof(label), "storm, %.0f/s burst %u",
+             limit.rate_per_s, limit.burst);
+  }
+  printf("%-28s %8zu %10llu %10llu %10u %8s %8llu\n", label, N,
+         static_cast<unsigned long long>(sink.deltas),
+         static_cast<unsigned long long>(sink.bytes), batcher.held_back(),
+         final_published ? "yes" : "NO",
+         static_cast<unsigned long long>(sink.notifications));
+}
+
+}  // namespace
+
+void run_publish_limiter_benchmark() {
+  printf("\nDelta storm: relay 1 flipped every %d ms for %d s\n",
+         kFlipEveryMs, kStormMs / 1000);
+  printf("%-28s %8s %10s %10s %10s %8s %8s\n", "path", "channels",
+         "deltas", "bytes", "held back", "final", "notices");
+  run<4, false>();
+  run<4, true>();
+  run<64, false>();
+  run<64, true>();
+}
+
+}  // namespace bench
@@ -0,0 +1,117 @@
+// Signal K PUT dispatch as the device does it. SensESP matches a PUT to a
+// listener by comparing its path with every listener's in turn; that scan
+// is in both figures. Before, each channel's listener emitted to its own
+// consumer; now the listener holds its channel index and calls the bank
+// itself, as SignalKBridge does. Both end in the same handler, which only
+// counts, so that 512 paths can be measured past RelayBank's limit.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_sensesp.h"
+
+namespace bench {
+
+namespace {
+
+constexpr int kPuts = 200000;
+
+// Stands in for RelayBank::set().
+struct CountingHandler {
+  void on_put(size_t channel, bool on) {
+    puts++;
+    ons += on;
+    last_channel = channel;
+  }
+
+  uint64_t puts = 0;
+  uint64_t ons = 0;
+  size_t last_channel = 0;
+};
+
+CountingHandler handler;
+
+// SignalKBridge's listener, on the simulated SensESP.
+class IndexedListener : public sensesp::SKPutListener {
+ public:
+  IndexedListener(const std::string& sk_path, size_t channel)
+      : sensesp::SKPutListener(sk_path), channel_(channel) {}
+
+  void parse_value(const std::string&, bool value) override {
+    handler.on_put(channel_, value);
+  }
+
+ private:
+  size_t channel_;
+};
+
+// Mean time per PUT over kPuts PUTs that cycle through every path, turning
+// all channels on in one round and off in the next.
+template <typename F>
+double ns_per_put(size_t channels, F put) {
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < kPuts; n++) {
+    size_t channel = n % channels;
+    put(channel, (n / channels) % 2 == 0);
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / kPuts;
+}
+
+void run(size_t channels) {
+  static std::vector<std::string> paths;
+  paths.clear();
+  for (size_t i = 0; i < channels; i++) {
+    paths.push_back(channel_path(i));
+  }
+  handler = CountingHandler();
+
+  // What the bridge did before: a listener and a consumer per channel.
+  sim::reset();
+  for (size_t i = 0; i < channels; i++) {
+    auto* listener = new sensesp::SKPutRequestListener<bool>(paths[i]);
+    listener->connect_to(new sensesp::LambdaConsumer<bool>(
+        [i](bool on) { handler.on_put(i, on); }));
+  }
+  uint64_t before = allocations();
+  double consumers_ns = ns_per_put(channels, [](size_t channel, bool on) {
+    sim::signalk().put(paths[channel], on);
+  });
+  uint64_t consumer_allocations = allocations() - before;
+
+  // What it does now.
+  sim::reset();
+  for (size_t i = 0; i < channels; i++) {
+    new IndexedListener(paths[i], i);
+  }
+  before = allocations();
+  double listeners_ns = ns_per_put(channels, [](size_t channel, bool on) {
+    sim::signalk().put(paths[channel], on);
+  });
+  uint64_t listener_allocations = allocations() - before;
+
+  printf("%-28s %8zu %10.1f %10llu\n", "listener + consumer", channels,
+         consumers_ns, static_cast<unsigned long long>(consumer_allocations));
+  printf("%-28s %8zu %10.1f %10llu\n", "listener with channel", channels,
+         listeners_ns, static_cast<unsigned long long>(listener_allocations));
+  if (handler.puts != 2 * kPuts) {
+    printf("%llu of %d PUTs reached a channel\n",
+           static_cast<unsigned long long>(handler.puts), 2 * kPuts);
+  }
+}
+
+}  // namespace
+
+void run_put_listener_benchmark() {
+  printf("\nSignal K PUT to relay, per PUT\n");
+  printf("%-28s %8s %10s %10s\n", "path", "channels", "ns/PUT", "allocs");
+  run(4);
+  run(64);
+  run(512);
+}
+
+}  // namespace bench
@@ -0,0 +1,112 @@
+// The local REST API: switching the whole bank with one POST against one
+// request per relay, and serving the state document. Parsing and applying
+// only; the web server's own share is not simulated.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_sensesp.h"
+#include "relay/json_writer.h"
+#include "relay/relay_api.h"
+#include "relay/relay_bank.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::ChangeSource;
+using relay_controller::ChannelSpec;
+using relay_controller::JsonWriter;
+using relay_controller::kNoPin;
+using relay_controller::RelayApi;
+using relay_controller::RelayBank;
+
+constexpr int kRequests = 2000;
+
+template <size_t N>
+void run() {
+  sim::reset();
+  static RelayBank<N> bank;
+  static RelayApi<N> api(&bank);
+  static std::vector<std::string> paths;
+  std::vector<ChannelSpec> specs;
+  paths.clear();
+  for (size_t i = 0; i < N; i++) {
+    paths.push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < N; i++) {
+    specs.push_back({{kNoPin, kNoPin, static_cast<uint16_t>(kRelayPinBase + i)},
+                     paths[i].c_str()});
+  }
+  bank.begin(specs.data(), false);
+
+  // The POST turns every relay on, the per-relay requests turn them all
+  // off again.
+  std::string body = "{\"on\":\"";
+  for (size_t digit = 0; digit < (N + 3) / 4; digit++) {
+    body += digit == 0 && N % 4 != 0 ? "0137"[N % 4] : 'f';
+  }
+  body += "\"}";
+
+  Samples one_post;
+  Samples per_relay;
+  Samples document;
+  uint64_t post_allocations = 0;
+  uint64_t post_skew = 0;
+  uint64_t per_relay_skew = 0;
+  size_t document_length = 0;
+  static char buffer[RelayApi<N>::kMaxDocumentLength];
+  for (int n = 0; n < kRequests; n++) {
+    uint64_t before = allocations();
+    uint64_t start = sim::now_ns();
+    typename RelayApi<N>::Request request;
+    if (!RelayApi<N>::parse(body.data(), body.size(), &request)) {
+      printf("request rejected: %s\n", body.c_str());
+      return;
+    }
+    request.received_us = start / 1000;
+    api.submit(request);
+    api.tick();
+    uint64_t elapsed = sim::now_ns() - start;
+    post_allocations += allocations() - before;
+    one_post.add(elapsed);
+    post_skew = std::max(post_skew, switching_skew_ns(kRelayPinBase, N));
+
+    // The same change as one request per relay, as a panel without the
+    // API would make through Signal K PUTs.
+    start = sim::now_ns();
+    for (size_t i = 0; i < N; i++) {
+      bank.set(i, false, ChangeSource::kRemote, sim::now_ns() / 1000);
+    }
+    per_relay.add(sim::now_ns() - start);
+    per_relay_skew =
+        std::max(per_relay_skew, switching_skew_ns(kRelayPinBase, N));
+
+    start = sim::now_ns();
+    JsonWriter writer(buffer, sizeof(buffer));
+    api.write_states(&writer);
+    document.add(sim::now_ns() - start);
+    document_length = writer.length();
+  }
+  print_latency("POST, whole bank", N, one_post);
+  print_latency("one set per relay", N, per_relay);
+  print_latency("GET document", N, document);
+  print_count("POST, whole bank skew", N, post_skew, "ns");
+  print_count("one set per relay skew", N, per_relay_skew, "ns");
+  print_allocations("POST engine", N, post_allocations, kRequests);
+  print_count("GET document size", N, document_length, "bytes");
+}
+
+}  // namespace
+
+void run_relay_api_benchmark() {
+  print_header("Local REST API, per request");
+  run<4>();
+  run<64>();
+  run<256>();
+}
+
+}  // namespace bench
@@ -0,0 +1,182 @@
+// Button-to-relay and button-to-delta latency of RelayBank, plus the heap
+// allocations the engine makes per press, and the Signal K messages and
+// relay switching skew of a full-bank scene.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_sensesp.h"
+#include "relay/bank_debouncer.h"
+#include "relay/delta_batcher.h"
+#include "relay/edge_capture.h"
+#include "relay/heartbeat_wheel.h"
+#include "relay/latency_monitor.h"
+#include "relay/relay_bank.h"
+#include "relay/relay_scene.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::BankDebouncer;
+using relay_controller::ChangeSource;
+using relay_controller::ChannelSpec;
+using relay_controller::DeltaBatcher;
+using relay_controller::DeltaSink;
+using relay_controller::EdgeCapture;
+using relay_controller::HeartbeatWheel;
+using relay_controller::kDefaultTrackedChannels;
+using relay_controller::LatencyLeg;
+using relay_controller::LatencyMonitor;
+using relay_controller::RelayBank;
+using relay_controller::RelayScene;
+
+constexpr int kPresses = 4000;
+
+// Stands in for the device's WebsocketDeltaSink. What the simulated server
+// allocates is not charged to the engine.
+class SimDeltaSink : public DeltaSink {
+ public:
+  bool send_delta(const char* json, size_t length) override {
+    uint64_t before = allocations();
+    sim::signalk().send_raw(json, length);
+    transport_allocations += allocations() - before;
+    return true;
+  }
+
+  uint64_t transport_allocations = 0;
+};
+
+template <size_t N>
+void run() {
+  sim::reset();
+
+  static RelayBank<N> bank;
+  static EdgeCapture<N> capture;
+  static BankDebouncer<N> debouncer;
+  static SimDeltaSink sink;
+  // No batching window: flush on the tick that saw the change.
+  static DeltaBatcher<N, 16384> batcher(&bank, &sink, 0);
+  static HeartbeatWheel<N> heartbeat(&bank);
+  static LatencyMonitor<N> latency(&bank);
+  static std::vector<std::string> paths;
+  std::vector<ChannelSpec> specs;
+  for (size_t i = 0; i < N; i++) {
+    paths.push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < N; i++) {
+    specs.push_back({{static_cast<uint16_t>(kButtonPinBase + i),
+                      static_cast<uint16_t>(kLedPinBase + i),
+                      static_cast<uint16_t>(kRelayPinBase + i)},
+                     paths[i].c_str()});
+  }
+  bank.begin(specs.data(), true);
+  capture.begin(bank);
+  // Sample every tick and accept the first sample, so that the figures show
+  // processing cost rather than the debounce time.
+  debouncer.begin(bank, 0, 0);
+  batcher.set_sent_observer(&latency);
+  batcher.begin();
+  heartbeat.begin();
+  latency.begin();
+
+  uint64_t engine_allocations = 0;
+  sensesp::event_loop()->onTick([&engine_allocations]() {
+    uint64_t before = allocations() - sink.transport_allocations;
+    capture.drain(&debouncer);
+    debouncer.tick(&bank);
+    heartbeat.tick();
+    batcher.tick();
+    engine_allocations +=
+        allocations() - sink.transport_allocations - before;
+  });
+  sensesp::event_loop()->tick();
+  engine_allocations = 0;
+
+  Samples to_relay;
+  Samples to_delta;
+  to_relay.reserve(kPresses);
+  to_delta.reserve(kPresses);
+
+  for (int n = 0; n < kPresses; n++) {
+    size_t channel = n % N;
+    int button_pin = kButtonPinBase + channel;
+
+    sim::drive_input(button_pin, false);
+    sensesp::event_loop()->tick();
+
+    uint64_t edge_ns = sim::now_ns();
+    sim::drive_input(button_pin, true);
+    while (sim::signalk().last_sent_ns(paths[channel]) < edge_ns) {
+      sensesp::event_loop()->tick();
+    }
+    to_relay.add(sim::last_write_ns(kRelayPinBase + channel) - edge_ns);
+    to_delta.add(sim::signalk().last_sent_ns(paths[channel]) - edge_ns);
+  }
+
+  print_latency("RelayBank edge->relay", N, to_relay);
+  print_latency("RelayBank edge->delta", N, to_delta);
+  print_allocations("RelayBank engine", N, engine_allocations, kPresses);
+  // What the on-device histogram of the whole bank saw, in whole
+  // microseconds rounded up to its bucket.
+  const auto& relay_to_delta =
+      latency.bank_histogram(LatencyLeg::kRelayToDelta);
+  printf("%-28s %8zu %10.2f %10.2f %10.2f\n", "RelayBank histogram r->d", N,
+         static_cast<double>(relay_to_delta.percentile(50)),
+         static_cast<double>(relay_to_delta.percentile(99)),
+         static_cast<double>(relay_to_delta.max_us()));
+  print_count("RelayBank latency report", N, latency.publish(&sink),
+              "messages");
+  print_count("LatencyMonitor size", N, sizeof(latency), "bytes");
+
+  // Turn everything on with a scene, then measure turning it off again, as
+  // one PUT to the scene's path would.
+  std::string spec;
+  for (size_t i = 0; i < N; i++) {
+    spec += (i == 0 ? "" : ",") + std::to_string(i + 1) + "=on";
+  }
+  RelayScene<N> scene;
+  scene.parse(spec.c_str());
+  scene.apply(&bank, true, ChangeSource::kRemote, sim::now_ns() / 1000);
+  sensesp::event_loop()->tick();
+  uint64_t messages_before = sim::signalk().messages_sent();
+  scene.apply(&bank, false, ChangeSource::kRemote, sim::now_ns() / 1000);
+  sensesp::event_loop()->tick();
+  print_count("RelayBank full-bank change", N,
+              sim::signalk().messages_sent() - messages_before, "messages");
+  print_count("RelayBank full-bank skew", N,
+              switching_skew_ns(kRelayPinBase, N), "ns");
+
+  // Let three heartbeat periods pass.
+  messages_before = sim::signalk().messages_sent();
+  for (int period = 0; period < 3; period++) {
+    sim::advance_clock(HeartbeatWheel<N>::kDefaultPeriodUs);
+    sensesp::event_loop()->tick();
+  }
+  print_count("RelayBank 3 heartbeats", N,
+              sim::signalk().messages_sent() - messages_before, "messages");
+
+  if (capture.overflows() != 0) {
+    printf("edge ring overflowed %u times\n", capture.overflows());
+  }
+}
+
+}  // namespace
+
+void run_relay_bank_benchmark() {
+  printf("\nRelayChannel: %zu bytes/channel\n",
+         RelayBank<4>::kBytesPerChannel);
+  printf("LatencyMonitor: %zu bytes/channel, %zu more for each of the %zu "
+         "tracked\n",
+         LatencyMonitor<4>::kBytesPerChannel,
+         LatencyMonitor<4>::kBytesPerTrackedChannel,
+         kDefaultTrackedChannels);
+  print_header("RelayBank<N>");
+  run<4>();
+  run<32>();
+  run<256>();
+}
+
+}  // namespace bench
@@ -0,0 +1,96 @@
+// RelayBank on a simulated 74HC595 chain: host CPU from a switch to the
+// latch, time on the wire at 10 MHz and transfers per full-bank change,
+// for 16, 32 and 64 relays.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "native/bench.h"
+#include "native/sim_hw.h"
+#include "native/sim_shift_chain.h"
+#include "relay/relay_bank.h"
+#include "relay/shift_register_output.h"
+
+namespace bench {
+
+namespace {
+
+using relay_controller::ChangeSource;
+using relay_controller::ChannelSet;
+using relay_controller::ChannelSpec;
+using relay_controller::kNoPin;
+using relay_controller::RelayBank;
+using relay_controller::ShiftRegisterOutput;
+
+constexpr int kSwitches = 5000;
+
+template <size_t N>
+void run() {
+  sim::reset_hw();
+  sim::SimShiftChain chain;
+  ShiftRegisterOutput output(&chain, N / 8);
+  static RelayBank<N> bank;
+  static std::vector<std::string> paths;
+  std::vector<ChannelSpec> specs;
+  paths.clear();
+  for (size_t i = 0; i < N; i++) {
+    paths.push_back(channel_path(i));
+  }
+  for (size_t i = 0; i < N; i++) {
+    specs.push_back({{kNoPin, kNoPin, static_cast<uint16_t>(i)},
+                     paths[i].c_str()});
+  }
+  bank.set_output_stages(&output, &output);
+  bank.begin(specs.data(), false);
+  output.flush();
+
+  std::mt19937 random(1);
+  Samples latency;
+  latency.reserve(kSwitches);
+  uint64_t allocations_before = allocations();
+  for (int i = 0; i < kSwitches; i++) {
+    size_t channel = random() % N;
+    bool on = !bank.state(channel);
+    uint64_t start = sim::now_ns();
+    bank.set(channel, on, ChangeSource::kRemote, 0);
+    output.flush();
+    latency.add(chain.last_latch_ns() - start);
+    if (chain.output(channel) != on) {
+      printf("shift register: channel %zu did not switch\n", channel);
+    }
+  }
+  uint64_t switch_allocations = allocations() - allocations_before;
+  uint64_t switch_wire_ns = chain.last_wire_ns();
+
+  ChannelSet<N> all;
+  ChannelSet<N> on;
+  for (size_t i = 0; i < N; i++) {
+    all.set(i);
+    on.assign(i, !bank.state(i));
+  }
+  uint64_t before = output.transfers();
+  bank.set_group(all, on, ChangeSource::kRemote, 0);
+  output.flush();
+  uint64_t group_transfers = output.transfers() - before;
+
+  std::string label = "74HC595 x" + std::to_string(N / 8);
+  print_latency(label.c_str(), N, latency);
+  printf("%-28s %8zu %10.2f wire us at 10 MHz, %llu transfer(s) per "
+         "full-bank change\n",
+         label.c_str(), N, switch_wire_ns / 1000.0,
+         static_cast<unsigned long long>(group_transfers));
+  print_allocations(label.c_str(), N, switch_allocations, kSwitches);
+}
+
+}  // namespace
+
+void run_shift_register_benchmark() {
+  print_header("Shift register switch->latch (host CPU only)");
+  run<16>();
+  run<32>();
+  run<64>();
+}
+
+}  // namespace bench
@@ -0,0 +1,47 @@
+// Cost of recording a switching event: RELAY_TRACE() against formatting the
+// same line the way debugD() does before it reaches the UART.
+
+#include <chrono>
+#include <cstdio>
+
+#include "native/bench.h"
+#include "relay/trace.h"
+
+namespace bench {
+
+namespace {
+
+constexpr int kEvents = 1000000;
+
+template <typename F>
+double ns_per_event(F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kEvents; i++) {
+    f(i);
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / kEvents;
+}
+
+}  // namespace
+
+void run_trace_benchmark() {
+  printf("\nSwitching event record\n");
+  printf("%-28s %10s\n", "method", "ns/event");
+  uint64_t allocations_before = allocations();
+  double trace_ns = ns_per_event(
+      [](int i) { RELAY_TRACE(kRelaySet, i & 3, i & 1, 1); });
+  uint64_t trace_allocations = allocations() - allocations_before;
+  static char line[128];
+  double format_ns = ns_per_event([](int i) {
+    snprintf(line, sizeof(line), "relay %u -> %u, source %u", i & 3, i & 1,
+             1u);
+  });
+  printf("%-28s %10.2f\n", "RELAY_TRACE", trace_ns);
+  printf("%-28s %10.2f\n", "snprintf (debugD, no UART)", format_ns);
+  printf("%-28s %10llu\n", "RELAY_TRACE allocations",
+         static_cast<unsigned long long>(trace_allocations));
+}
+
+}  // namespace bench
@@ -0,0 +1,61 @@
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "native/sim_hw.h"
+#include "relay/hal.h"
+
+namespace relay_controller {
+namespace hal {
+
+uint64_t now_us() { return micros(); }
+
+uint64_t wall_time_us() {
+  auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::microseconds>(since_epoch)
+      .count();
+}
+
+void configure_output(int pin) { pinMode(pin, OUTPUT); }
+
+void configure_input_pullup(int pin) { pinMode(pin, INPUT_PULLUP); }
+
+void configure_open_drain(int pin) { pinMode(pin, OUTPUT_OPEN_DRAIN); }
+
+void write_pin(int pin, bool level) { digitalWrite(pin, level); }
+
+bool read_pin(int pin) { return digitalRead(pin); }
+
+void read_inputs(uint64_t* words) {
+  for (size_t w = 0; w < kPinWords; w++) {
+    words[w] = sim::read_port(w);
+  }
+}
+
+void write_outputs(const uint64_t* set, const uint64_t* clear) {
+  for (size_t w = 0; w < kPinWords; w++) {
+    if ((set[w] | clear[w]) != 0) {
+      sim::write_port(w, set[w], clear[w]);
+    }
+  }
+}
+
+void attach_edge_interrupt(int pin, IsrHandler handler, void* arg) {
+  sim::attach_interrupt(pin, CHANGE, [handler, arg]() { handler(arg); });
+}
+
+uint64_t isr_now_us() { return micros(); }
+
+bool isr_read_pin(int pin) { return digitalRead(pin); }
+
+HeapStats heap_stats() {
+  static size_t minimum_free = SIZE_MAX;
+  size_t free_bytes = mallinfo2().fordblks;
+  minimum_free = std::min(minimum_free, free_bytes);
+  // glibc does not report its largest free chunk.
+  return {free_bytes, free_bytes, minimum_free};
+}
+
+}  // namespace hal
+}  // namespace relay_controller
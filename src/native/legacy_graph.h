@@ -0,0 +1,81 @@
+#ifndef RELAY_CONTROLLER_NATIVE_LEGACY_GRAPH_H_
+#define RELAY_CONTROLLER_NATIVE_LEGACY_GRAPH_H_
+
+// The per-channel SensESP graph setup() built before RelayBank replaced it.
+//
+// Kept verbatim as the baseline for the host benchmarks; it is built against
+// the simulated SensESP in sim_sensesp.h.
+
+#include <memory>
+#include <string>
+
+#include "native/sim_sensesp.h"
+
+namespace relay_controller {
+
+// Build one button -> relay -> Signal K channel. Every object is heap
+// allocated and lives for the rest of the program.
+inline void build_relay_channel(int relayIndex, int button_pin, int led_pin,
+                                int relay_pin, const char* sk_path) {
+  using namespace sensesp;
+
+  auto* button = new DigitalInputChange(button_pin, INPUT_PULLUP, CHANGE);
+  auto* relay = new DigitalOutput(relay_pin);
+  std::string relay_title =
+      "Relay " + std::to_string(relayIndex + 1) + " Output";
+
+  // ConfigItem(relay)
+  //     ->set_title(relay_title.c_str())
+  //     ->set_description("The GPIO pin that controls the relay.")
+  //     ->set_sort_order(100 + relayIndex);
+
+  auto led = new DigitalOutput(led_pin);
+
+  relay->set(1);
+
+  auto* debouncer = new Debounce<bool>(50);
+  button->connect_to(debouncer);
+
+  button->connect_to(new LambdaConsumer<bool>([relay](bool isPressed) {
+    if (isPressed) {
+      bool new_state = !relay->get();
+      relay->set(new_state);
+      debugD("Relay %d toggled to: %d", new_state);
+    }
+  }));
+
+  std::string configPath =
+      "/Control/Relay" + std::to_string(relayIndex + 1) + "/Value";
+  std::string sk_output_title =
+      "Relay " + std::to_string(relayIndex + 1) + " Configuration";
+  std::string sk_metadata_title =
+      "Control relay state for relay " + std::to_string(relayIndex + 1);
+  auto metadata = std::make_shared<SKMetadata>("", sk_metadata_title.c_str());
+
+  // Create the SKOutput for this relay channel.
+  auto* sk_output = new SKOutput<bool>(sk_path, configPath.c_str(), metadata);
+
+  // Wrap the SKOutput in a ConfigItem so that its SK path is configurable.
+  ConfigItem(sk_output)
+      ->set_title(sk_output_title.c_str())
+      ->set_description("The Signal K path to publish the state of this relay.")
+      ->set_sort_order(100 + relayIndex);
+
+  // Connect the relay to both its SignalK output and its status LED.
+  relay->connect_to(new Repeat<bool, bool>(10000))->connect_to(sk_output);
+  relay->connect_to(
+      new LambdaConsumer<bool>([led](bool state) { led->set(state); }));
+
+  // Add a SignalK PUT listener for the relay using SKPutRequestListener.
+  auto relay_put_listener = new SKPutRequestListener<bool>(sk_path);
+  relay_put_listener->connect_to(
+      new LambdaConsumer<bool>([relay, led](bool new_state) {
+        relay->set(new_state);
+        led->set(new_state);
+        debugD("Relay1 updated from SK PUT to: %d", new_state);
+      }));
+}
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_NATIVE_LEGACY_GRAPH_H_
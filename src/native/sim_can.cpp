@@ -0,0 +1,38 @@
+#include "native/sim_can.h"
+
+namespace sim {
+
+using relay_controller::CanFrame;
+
+void SimCanBus::inject(const CanFrame& frame) { received_.push_back(frame); }
+
+bool SimCanBus::send(const CanFrame& frame) {
+  sent_.push_back(frame);
+  frames_++;
+  wire_bits_ += frame_bits(frame.length);
+  return true;
+}
+
+bool SimCanBus::receive(CanFrame* frame) {
+  if (received_.empty()) {
+    return false;
+  }
+  *frame = received_.front();
+  received_.pop_front();
+  return true;
+}
+
+void SimCanBus::reset_stats() {
+  frames_ = 0;
+  wire_bits_ = 0;
+}
+
+size_t SimCanBus::frame_bits(size_t length) {
+  // 39 bits from start of frame to the end of the data length code, the
+  // data and a 15-bit CRC, with up to one stuff bit per four of those.
+  // Then CRC delimiter, acknowledgement, end of frame and interframe space.
+  size_t stuffed = 39 + 8 * length + 15;
+  return stuffed + (stuffed - 1) / 4 + 13;
+}
+
+}  // namespace sim
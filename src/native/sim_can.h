@@ -0,0 +1,52 @@
+#ifndef RELAY_CONTROLLER_NATIVE_SIM_CAN_H_
+#define RELAY_CONTROLLER_NATIVE_SIM_CAN_H_
+
+// Simulated 250 kbit/s CAN bus between the device and the rest of an
+// NMEA 2000 network. Frames the device sends are recorded; frames from
+// other nodes are injected and queued for it to receive. The bus estimates
+// the time its traffic would take on the wire.
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "relay/can_bus.h"
+
+namespace sim {
+
+class SimCanBus : public relay_controller::CanBus {
+ public:
+  static constexpr uint32_t kBitRate = 250000;
+
+  // A frame from another node, received by the device on its next tick.
+  void inject(const relay_controller::CanFrame& frame);
+
+  bool send(const relay_controller::CanFrame& frame) override;
+  bool receive(relay_controller::CanFrame* frame) override;
+
+  // Frames the device has sent since the last clear_sent().
+  const std::vector<relay_controller::CanFrame>& sent() const {
+    return sent_;
+  }
+  void clear_sent() { sent_.clear(); }
+
+  uint64_t frames() const { return frames_; }
+  // Time the device's frames so far would take on the wire, in
+  // nanoseconds, with worst-case bit stuffing.
+  uint64_t wire_ns() const { return wire_bits_ * 1000000000ull / kBitRate; }
+  void reset_stats();
+
+  // Bits on the wire for one frame with a 29-bit identifier.
+  static size_t frame_bits(size_t length);
+
+ private:
+  std::deque<relay_controller::CanFrame> received_;
+  std::vector<relay_controller::CanFrame> sent_;
+  uint64_t frames_ = 0;
+  uint64_t wire_bits_ = 0;
+};
+
+}  // namespace sim
+
+#endif  // RELAY_CONTROLLER_NATIVE_SIM_CAN_H_
@@ -0,0 +1,42 @@
+#include "native/sim_flash.h"
+
+#include <cstring>
+
+namespace sim {
+
+SimFlash::SimFlash(size_t sector_size, size_t sector_count)
+    : sector_size_(sector_size),
+      sector_count_(sector_count),
+      bytes_(sector_size * sector_count, 0xff),
+      erases_(sector_count, 0) {}
+
+bool SimFlash::read(size_t offset, void* data, size_t length) {
+  if (offset + length > bytes_.size()) {
+    return false;
+  }
+  memcpy(data, &bytes_[offset], length);
+  return true;
+}
+
+bool SimFlash::write(size_t offset, const void* data, size_t length) {
+  if (offset + length > bytes_.size()) {
+    return false;
+  }
+  const uint8_t* in = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < length; i++) {
+    bytes_[offset + i] &= in[i];
+  }
+  bytes_written_ += length;
+  return true;
+}
+
+bool SimFlash::erase_sector(size_t sector) {
+  if (sector >= sector_count_) {
+    return false;
+  }
+  memset(&bytes_[sector * sector_size_], 0xff, sector_size_);
+  erases_[sector]++;
+  return true;
+}
+
+}  // namespace sim
@@ -0,0 +1,40 @@
+#ifndef RELAY_CONTROLLER_NATIVE_SIM_FLASH_H_
+#define RELAY_CONTROLLER_NATIVE_SIM_FLASH_H_
+
+// Simulated NOR flash for the state journal on the host: erased bytes read
+// 0xff and a write ANDs into what is there, as on the device. Counts
+// erases per sector so that the benchmark can show the wear spread.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "relay/journal_flash.h"
+
+namespace sim {
+
+class SimFlash : public relay_controller::JournalFlash {
+ public:
+  SimFlash(size_t sector_size, size_t sector_count);
+
+  size_t sector_size() const override { return sector_size_; }
+  size_t sector_count() const override { return sector_count_; }
+
+  bool read(size_t offset, void* data, size_t length) override;
+  bool write(size_t offset, const void* data, size_t length) override;
+  bool erase_sector(size_t sector) override;
+
+  uint32_t erase_count(size_t sector) const { return erases_[sector]; }
+  uint64_t bytes_written() const { return bytes_written_; }
+
+ private:
+  size_t sector_size_;
+  size_t sector_count_;
+  std::vector<uint8_t> bytes_;
+  std::vector<uint32_t> erases_;
+  uint64_t bytes_written_ = 0;
+};
+
+}  // namespace sim
+
+#endif  // RELAY_CONTROLLER_NATIVE_SIM_FLASH_H_
@@ -0,0 +1,134 @@
+#include "native/sim_hw.h"
+
+#include <chrono>
+#include <vector>
+
+namespace sim {
+
+namespace {
+
+struct Pin {
+  int mode = INPUT;
+  uint64_t last_write_ns = 0;
+  uint64_t write_count = 0;
+};
+
+struct Interrupt {
+  int pin;
+  int mode;
+  std::function<void()> handler;
+};
+
+Pin pins[kNumPins];
+// Pin levels packed 64 to a word, so that ports read like registers.
+uint64_t levels[kNumPins / 64];
+std::vector<Interrupt> interrupts;
+std::function<void()> port_write_hook;
+uint64_t clock_offset_ns = 0;
+
+const auto kEpoch = std::chrono::steady_clock::now();
+
+unsigned index_of(int pin) { return static_cast<unsigned>(pin) % kNumPins; }
+
+Pin& pin_at(int pin) { return pins[index_of(pin)]; }
+
+bool level_of(int pin) {
+  unsigned index = index_of(pin);
+  return (levels[index / 64] >> (index % 64)) & 1;
+}
+
+void set_level(int pin, bool level) {
+  unsigned index = index_of(pin);
+  uint64_t bit = uint64_t{1} << (index % 64);
+  levels[index / 64] = level ? levels[index / 64] | bit
+                             : levels[index / 64] & ~bit;
+}
+
+}  // namespace
+
+uint64_t now_ns() {
+  auto elapsed = std::chrono::steady_clock::now() - kEpoch;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+             .count() +
+         clock_offset_ns;
+}
+
+void advance_clock(uint64_t us) { clock_offset_ns += us * 1000; }
+
+void attach_interrupt(int pin, int mode, std::function<void()> handler) {
+  interrupts.push_back({pin, mode, std::move(handler)});
+}
+
+void drive_input(int pin, bool level) {
+  if (level_of(pin) == level) {
+    return;
+  }
+  set_level(pin, level);
+  for (auto& irq : interrupts) {
+    if (irq.pin != pin) {
+      continue;
+    }
+    if (irq.mode == CHANGE || (irq.mode == RISING && level) ||
+        (irq.mode == FALLING && !level)) {
+      irq.handler();
+    }
+  }
+}
+
+uint64_t read_port(int word) { return levels[word % (kNumPins / 64)]; }
+
+void write_port(int word, uint64_t set, uint64_t clear) {
+  uint64_t now = now_ns();
+  uint64_t& level = levels[word % (kNumPins / 64)];
+  level = (level | set) & ~clear;
+  for (uint64_t touched = set | clear; touched != 0; touched &= touched - 1) {
+    Pin& p = pin_at(word * 64 + __builtin_ctzll(touched));
+    p.last_write_ns = now;
+    p.write_count++;
+  }
+  if (port_write_hook) {
+    port_write_hook();
+  }
+}
+
+void set_port_write_hook(std::function<void()> hook) {
+  port_write_hook = std::move(hook);
+}
+
+uint64_t last_write_ns(int pin) { return pin_at(pin).last_write_ns; }
+
+uint64_t write_count(int pin) { return pin_at(pin).write_count; }
+
+void reset_hw() {
+  for (auto& p : pins) {
+    p = Pin();
+  }
+  for (auto& word : levels) {
+    word = 0;
+  }
+  interrupts.clear();
+  port_write_hook = nullptr;
+}
+
+}  // namespace sim
+
+void pinMode(int pin, int mode) {
+  auto& p = sim::pin_at(pin);
+  p.mode = mode;
+  if (mode == INPUT_PULLUP || mode == OUTPUT_OPEN_DRAIN) {
+    sim::set_level(pin, true);
+  }
+}
+
+int digitalRead(int pin) { return sim::level_of(pin) ? HIGH : LOW; }
+
+void digitalWrite(int pin, int value) {
+  auto& p = sim::pin_at(pin);
+  sim::set_level(pin, value != LOW);
+  p.last_write_ns = sim::now_ns();
+  p.write_count++;
+}
+
+unsigned long millis() { return sim::now_ns() / 1000000; }
+
+unsigned long micros() { return sim::now_ns() / 1000; }
@@ -0,0 +1,66 @@
+#ifndef RELAY_CONTROLLER_NATIVE_SIM_HW_H_
+#define RELAY_CONTROLLER_NATIVE_SIM_HW_H_
+
+// Simulated GPIO and clock back ends for the native environment.
+//
+// Provides the small part of the Arduino API the relay graph touches, plus
+// hooks that let the benchmark drive inputs and observe output writes. Pin
+// numbers are not limited to the ESP32 range so that large channel counts
+// can be simulated.
+
+#include <cstdint>
+#include <functional>
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define OUTPUT_OPEN_DRAIN 0x13
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+unsigned long millis();
+unsigned long micros();
+
+namespace sim {
+
+constexpr int kNumPins = 4096;
+
+// Monotonic host time plus any virtual offset added with advance_clock().
+uint64_t now_ns();
+void advance_clock(uint64_t us);
+
+// Register an interrupt handler. Handlers run synchronously from
+// drive_input(), the way an ISR preempts the main loop on the device.
+void attach_interrupt(int pin, int mode, std::function<void()> handler);
+
+// Set the external level on an input pin and fire its interrupt handlers.
+void drive_input(int pin, bool level);
+
+// Port access for the bank-wide hal functions: 64 pins per word, pin n is
+// bit n % 64 of word n / 64. write_port() stamps every pin it writes with
+// the same time, like a single register store.
+uint64_t read_port(int word);
+void write_port(int word, uint64_t set, uint64_t clear);
+
+// Called after every write_port(), so that a simulated circuit can update
+// the inputs it drives, e.g. the columns of a button matrix.
+void set_port_write_hook(std::function<void()> hook);
+
+// Host time of the most recent write to a pin, or 0 if none.
+uint64_t last_write_ns(int pin);
+uint64_t write_count(int pin);
+
+// Forget all pin state and interrupt handlers.
+void reset_hw();
+
+}  // namespace sim
+
+#endif  // RELAY_CONTROLLER_NATIVE_SIM_HW_H_
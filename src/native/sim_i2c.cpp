@@ -0,0 +1,194 @@
+#include "native/sim_i2c.h"
+
+#include "native/sim_hw.h"
+
+namespace sim {
+
+namespace {
+
+// MCP23017 registers with IOCON.BANK = 0.
+constexpr uint8_t kIodirA = 0x00;
+constexpr uint8_t kGpintenA = 0x04;
+constexpr uint8_t kGppuA = 0x0C;
+constexpr uint8_t kIntfA = 0x0E;
+constexpr uint8_t kIntcapA = 0x10;
+constexpr uint8_t kGpioA = 0x12;
+constexpr uint8_t kOlatA = 0x14;
+constexpr uint8_t kRegisters = 0x16;
+
+uint16_t pair(const uint8_t* registers, uint8_t reg) {
+  return static_cast<uint16_t>(registers[reg] | registers[reg + 1] << 8);
+}
+
+}  // namespace
+
+void SimExpander::set_input(int pin, bool level) {
+  uint16_t bit = 1u << pin;
+  uint16_t before = pin_levels();
+  external_ = level ? external_ | bit : external_ & ~bit;
+  uint16_t changed = before ^ pin_levels();
+  uint16_t watched;
+  if (model_ == Model::kMcp23017) {
+    watched = pair(registers_, kIodirA) & pair(registers_, kGpintenA);
+    if (changed & watched) {
+      registers_[kIntcapA] = static_cast<uint8_t>(before);
+      registers_[kIntcapA + 1] = static_cast<uint8_t>(before >> 8);
+    }
+  } else {
+    watched = latch_;
+  }
+  interrupt_flags_ |= changed & watched;
+  if (model_ == Model::kMcp23017) {
+    registers_[kIntfA] = static_cast<uint8_t>(interrupt_flags_);
+    registers_[kIntfA + 1] = static_cast<uint8_t>(interrupt_flags_ >> 8);
+  }
+  if (bus_ != nullptr) {
+    bus_->update_interrupt();
+  }
+}
+
+uint16_t SimExpander::output_pins() const {
+  if (model_ == Model::kMcp23017) {
+    return static_cast<uint16_t>(~pair(registers_, kIodirA));
+  }
+  return static_cast<uint16_t>(~latch_);
+}
+
+uint16_t SimExpander::output_levels() const {
+  if (model_ == Model::kMcp23017) {
+    return pair(registers_, kOlatA) & output_pins();
+  }
+  return 0;
+}
+
+uint16_t SimExpander::pin_levels() const {
+  if (model_ == Model::kMcp23017) {
+    uint16_t outputs = output_pins();
+    return (pair(registers_, kOlatA) & outputs) | (external_ & ~outputs);
+  }
+  return latch_ & external_;
+}
+
+uint8_t SimExpander::read_register(uint8_t reg) {
+  if (reg == kGpioA || reg == kGpioA + 1 || reg == kIntcapA ||
+      reg == kIntcapA + 1) {
+    // Reading a port clears its interrupt.
+    interrupt_flags_ &= (reg & 1) ? 0x00ff : 0xff00;
+    registers_[kIntfA + (reg & 1)] = 0;
+  }
+  if (reg == kGpioA || reg == kGpioA + 1) {
+    return static_cast<uint8_t>(pin_levels() >> (8 * (reg & 1)));
+  }
+  return registers_[reg];
+}
+
+void SimExpander::write_register(uint8_t reg, uint8_t value) {
+  if (reg == kGpioA || reg == kGpioA + 1) {
+    reg += kOlatA - kGpioA;
+  }
+  if (reg == kIntfA || reg == kIntfA + 1 || reg == kIntcapA ||
+      reg == kIntcapA + 1) {
+    return;
+  }
+  uint16_t before = output_levels();
+  registers_[reg] = value;
+  if (output_levels() != before) {
+    last_output_ns_ = now_ns();
+  }
+}
+
+bool SimExpander::write(const uint8_t* data, size_t length) {
+  if (model_ == Model::kPcf8575) {
+    // Each pair of bytes is a new latch value.
+    for (size_t i = 0; i + 1 < length; i += 2) {
+      uint16_t outputs_before = output_pins();
+      latch_ = static_cast<uint16_t>(data[i] | data[i + 1] << 8);
+      if (output_pins() != outputs_before) {
+        last_output_ns_ = now_ns();
+      }
+    }
+    interrupt_flags_ = 0;
+    return true;
+  }
+  if (length == 0) {
+    return true;
+  }
+  pointer_ = data[0] % kRegisters;
+  for (size_t i = 1; i < length; i++) {
+    write_register(pointer_, data[i]);
+    pointer_ = (pointer_ + 1) % kRegisters;
+  }
+  return true;
+}
+
+bool SimExpander::read(const uint8_t* out, size_t out_length, uint8_t* in,
+                       size_t in_length) {
+  if (model_ == Model::kPcf8575) {
+    uint16_t levels = pin_levels();
+    for (size_t i = 0; i < in_length; i++) {
+      in[i] = static_cast<uint8_t>(levels >> (8 * (i & 1)));
+    }
+    interrupt_flags_ = 0;
+    return true;
+  }
+  if (out_length > 0) {
+    write(out, out_length);
+  }
+  for (size_t i = 0; i < in_length; i++) {
+    in[i] = read_register(pointer_);
+    pointer_ = (pointer_ + 1) % kRegisters;
+  }
+  return true;
+}
+
+SimI2cBus::SimI2cBus(int interrupt_pin, uint32_t clock_hz)
+    : interrupt_pin_(interrupt_pin), clock_hz_(clock_hz) {
+  drive_input(interrupt_pin_, true);
+}
+
+void SimI2cBus::attach(uint8_t address, SimExpander* device) {
+  devices_[address % kAddresses] = device;
+  device->bus_ = this;
+}
+
+bool SimI2cBus::write(uint8_t address, const uint8_t* data, size_t length) {
+  count(length, false);
+  SimExpander* device = devices_[address % kAddresses];
+  bool ok = !nak_ && device != nullptr && device->write(data, length);
+  update_interrupt();
+  return ok;
+}
+
+bool SimI2cBus::write_read(uint8_t address, const uint8_t* out,
+                           size_t out_length, uint8_t* in, size_t in_length) {
+  count(out_length + in_length, out_length > 0);
+  SimExpander* device = devices_[address % kAddresses];
+  bool ok = !nak_ && device != nullptr &&
+            device->read(out, out_length, in, in_length);
+  update_interrupt();
+  return ok;
+}
+
+void SimI2cBus::reset_stats() {
+  transactions_ = 0;
+  bytes_ = 0;
+  wire_bits_ = 0;
+}
+
+void SimI2cBus::update_interrupt() {
+  bool asserted = false;
+  for (SimExpander* device : devices_) {
+    asserted |= device != nullptr && device->interrupt();
+  }
+  drive_input(interrupt_pin_, !asserted);
+}
+
+void SimI2cBus::count(size_t bytes, bool repeated_start) {
+  transactions_++;
+  bytes_ += bytes;
+  // Address and data bytes of 9 clocks each, start and stop, and a second
+  // address byte after a repeated start.
+  wire_bits_ += 9 * (bytes + 1) + 2 + (repeated_start ? 10 : 0);
+}
+
+}  // namespace sim
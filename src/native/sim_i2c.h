@@ -0,0 +1,96 @@
+#ifndef RELAY_CONTROLLER_NATIVE_SIM_I2C_H_
+#define RELAY_CONTROLLER_NATIVE_SIM_I2C_H_
+
+// Simulated I2C bus with MCP23017 and PCF8575 GPIO expanders, enough of
+// them for I2cExpanderBank and ExpanderButtons to run on the host.
+//
+// The expanders' interrupt outputs are wired together onto one simulated
+// GPIO, active low, as on the board. The bus counts transactions and bytes
+// and estimates the time they would take on the wire.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/i2c_bus.h"
+
+namespace sim {
+
+class SimI2cBus;
+
+class SimExpander {
+ public:
+  enum class Model { kMcp23017, kPcf8575 };
+
+  explicit SimExpander(Model model) : model_(model) {}
+
+  // Drive an input pin from outside, e.g. a button pulling it low.
+  void set_input(int pin, bool level);
+
+  // Levels of the pins configured as outputs, and which pins those are.
+  uint16_t output_levels() const;
+  uint16_t output_pins() const;
+  bool interrupt() const { return interrupt_flags_ != 0; }
+  // Host time of the last write that changed an output.
+  uint64_t last_output_ns() const { return last_output_ns_; }
+
+ private:
+  friend class SimI2cBus;
+
+  bool write(const uint8_t* data, size_t length);
+  bool read(const uint8_t* out, size_t out_length, uint8_t* in,
+            size_t in_length);
+  uint16_t pin_levels() const;
+  uint8_t read_register(uint8_t reg);
+  void write_register(uint8_t reg, uint8_t value);
+
+  Model model_;
+  SimI2cBus* bus_ = nullptr;
+  uint8_t registers_[0x16] = {};
+  uint8_t pointer_ = 0;
+  // PCF8575 latch; inputs are latched high.
+  uint16_t latch_ = 0xffff;
+  uint16_t external_ = 0xffff;
+  uint16_t interrupt_flags_ = 0;
+  uint64_t last_output_ns_ = 0;
+};
+
+class SimI2cBus : public relay_controller::I2cBus {
+ public:
+  explicit SimI2cBus(int interrupt_pin, uint32_t clock_hz = 400000);
+
+  void attach(uint8_t address, SimExpander* device);
+
+  bool write(uint8_t address, const uint8_t* data, size_t length) override;
+  bool write_read(uint8_t address, const uint8_t* out, size_t out_length,
+                  uint8_t* in, size_t in_length) override;
+
+  // While set, no device acknowledges, as if the bus were disturbed.
+  void set_nak(bool nak) { nak_ = nak; }
+
+  uint64_t transactions() const { return transactions_; }
+  uint64_t bytes() const { return bytes_; }
+  // Time the traffic so far would take on the wire, in nanoseconds.
+  uint64_t wire_ns() const { return wire_bits_ * 1000000000ull / clock_hz_; }
+  void reset_stats();
+
+ private:
+  friend class SimExpander;
+
+  static constexpr size_t kAddresses = 128;
+
+  // Pull the shared interrupt line low while any device asserts it.
+  void update_interrupt();
+  void count(size_t bytes, bool repeated_start);
+
+  int interrupt_pin_;
+  uint32_t clock_hz_;
+  SimExpander* devices_[kAddresses] = {};
+  uint64_t transactions_ = 0;
+  uint64_t bytes_ = 0;
+  uint64_t wire_bits_ = 0;
+  bool nak_ = false;
+};
+
+}  // namespace sim
+
+#endif  // RELAY_CONTROLLER_NATIVE_SIM_I2C_H_
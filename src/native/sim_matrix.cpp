@@ -0,0 +1,46 @@
+#include "native/sim_matrix.h"
+
+#include "native/sim_hw.h"
+
+namespace sim {
+
+SimMatrix::SimMatrix(const relay_controller::MatrixWiring& wiring)
+    : wiring_(wiring) {
+  set_port_write_hook([this]() { update(); });
+}
+
+void SimMatrix::set_key(int key, bool pressed) {
+  uint64_t bit = uint64_t{1} << key;
+  pressed_ = pressed ? pressed_ | bit : pressed_ & ~bit;
+  update();
+}
+
+void SimMatrix::update() {
+  uint32_t low_rows = 0;
+  for (size_t r = 0; r < wiring_.row_count; r++) {
+    if (!digitalRead(wiring_.rows[r])) {
+      low_rows |= 1u << r;
+    }
+  }
+  uint32_t low_columns = 0;
+  // Without diodes current flows both ways through a key, so a low row
+  // pulls down every row and column connected to it by pressed keys.
+  for (bool spreading = true; spreading;) {
+    spreading = false;
+    for (size_t r = 0; r < wiring_.row_count; r++) {
+      uint32_t keys = (pressed_ >> (r * 8)) & 0xff;
+      if ((low_rows >> r) & 1) {
+        spreading |= (keys & ~low_columns) != 0;
+        low_columns |= keys;
+      } else if (!wiring_.diodes && (keys & low_columns) != 0) {
+        low_rows |= 1u << r;
+        spreading = true;
+      }
+    }
+  }
+  for (size_t c = 0; c < wiring_.column_count; c++) {
+    drive_input(wiring_.columns[c], ((low_columns >> c) & 1) == 0);
+  }
+}
+
+}  // namespace sim
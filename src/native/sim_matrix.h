@@ -0,0 +1,33 @@
+#ifndef RELAY_CONTROLLER_NATIVE_SIM_MATRIX_H_
+#define RELAY_CONTROLLER_NATIVE_SIM_MATRIX_H_
+
+// Simulated button matrix for ButtonMatrix on the host. Whenever the row
+// pins are written, the column pins follow the keys held down: directly
+// with diodes, through any chain of pressed keys without, which is what
+// makes ghosts.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/button_matrix.h"
+
+namespace sim {
+
+class SimMatrix {
+ public:
+  // Hooks into sim port writes until reset_hw().
+  explicit SimMatrix(const relay_controller::MatrixWiring& wiring);
+
+  // Press or release key row * 8 + column.
+  void set_key(int key, bool pressed);
+
+ private:
+  void update();
+
+  relay_controller::MatrixWiring wiring_;
+  uint64_t pressed_ = 0;
+};
+
+}  // namespace sim
+
+#endif  // RELAY_CONTROLLER_NATIVE_SIM_MATRIX_H_
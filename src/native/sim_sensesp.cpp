@@ -0,0 +1,139 @@
+#include "native/sim_sensesp.h"
+
+#include <cstdarg>
+#include <cstring>
+
+namespace reactesp {
+
+EventLoop::Handle EventLoop::add_timed(uint32_t ms, bool repeat, Callback cb) {
+  uint64_t interval_us = static_cast<uint64_t>(ms) * 1000;
+  timed_events_.push_back(
+      {interval_us, micros() + interval_us, repeat, true, std::move(cb)});
+  return timed_events_.size() - 1;
+}
+
+void EventLoop::restart(Handle handle) {
+  TimedEvent& event = timed_events_[handle];
+  event.active = true;
+  event.due_us = micros() + event.interval_us;
+}
+
+void EventLoop::tick() {
+  uint64_t now = micros();
+  // Callbacks may add events, so index rather than iterate.
+  for (size_t i = 0; i < timed_events_.size(); i++) {
+    if (!timed_events_[i].active || timed_events_[i].due_us > now) {
+      continue;
+    }
+    if (timed_events_[i].repeat) {
+      timed_events_[i].due_us = now + timed_events_[i].interval_us;
+    } else {
+      timed_events_[i].active = false;
+    }
+    Callback cb = timed_events_[i].cb;
+    cb();
+  }
+  for (size_t i = 0; i < tick_events_.size(); i++) {
+    tick_events_[i]();
+  }
+  sim::signalk().send_pending();
+}
+
+void EventLoop::reset() {
+  tick_events_.clear();
+  timed_events_.clear();
+}
+
+}  // namespace reactesp
+
+namespace sensesp {
+
+reactesp::EventLoop* event_loop() {
+  static reactesp::EventLoop loop;
+  return &loop;
+}
+
+void debugD(const char* format, ...) {
+  char buffer[128];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+}
+
+}  // namespace sensesp
+
+namespace sim {
+
+void SignalK::queue_delta(const char* sk_path, const char* value) {
+  pending_.push_back({sk_path, value});
+}
+
+void SignalK::send_pending() {
+  if (pending_.empty()) {
+    return;
+  }
+  for (const auto& pending : pending_) {
+    std::string delta =
+        std::string(
+            "{\"updates\":[{\"source\":{\"label\":\"Light-Inside-Relays\"},"
+            "\"values\":[{\"path\":\"") +
+        pending.sk_path + "\",\"value\":" + pending.value + "}]}]}";
+    messages_sent_++;
+    bytes_sent_ += delta.size();
+    last_sent_ns_[pending.sk_path] = now_ns();
+  }
+  pending_.clear();
+}
+
+void SignalK::send_raw(const char* json, size_t length) {
+  static const char kPathKey[] = "\"path\":\"";
+  uint64_t now = now_ns();
+  messages_sent_++;
+  bytes_sent_ += length;
+  const char* end = json + length;
+  for (const char* p = strstr(json, kPathKey); p != nullptr && p < end;
+       p = strstr(p, kPathKey)) {
+    p += sizeof(kPathKey) - 1;
+    const char* quote = strchr(p, '"');
+    if (quote == nullptr) {
+      break;
+    }
+    last_sent_ns_[std::string(p, quote)] = now;
+    p = quote;
+  }
+}
+
+void SignalK::put(const std::string& sk_path, bool value) {
+  for (auto* listener : put_listeners_) {
+    if (listener->get_sk_path() == sk_path) {
+      listener->parse_value(sk_path, value);
+    }
+  }
+}
+
+uint64_t SignalK::last_sent_ns(const std::string& sk_path) const {
+  auto it = last_sent_ns_.find(sk_path);
+  return it == last_sent_ns_.end() ? 0 : it->second;
+}
+
+void SignalK::reset() {
+  pending_.clear();
+  put_listeners_.clear();
+  last_sent_ns_.clear();
+  messages_sent_ = 0;
+  bytes_sent_ = 0;
+}
+
+SignalK& signalk() {
+  static SignalK instance;
+  return instance;
+}
+
+void reset() {
+  sensesp::event_loop()->reset();
+  signalk().reset();
+  reset_hw();
+}
+
+}  // namespace sim
@@ -0,0 +1,334 @@
+#ifndef RELAY_CONTROLLER_NATIVE_SIM_SENSESP_H_
+#define RELAY_CONTROLLER_NATIVE_SIM_SENSESP_H_
+
+// Simulated SensESP for the native environment.
+//
+// Implements just the classes the relay graph uses, with the same names and
+// the same emit/notify behaviour, so that src/relay_graph.h compiles
+// unchanged on the host. Network I/O is replaced by an in-process Signal K
+// back end that serialises every delta and records when it was sent.
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "native/sim_hw.h"
+
+namespace reactesp {
+
+class EventLoop {
+ public:
+  using Callback = std::function<void()>;
+
+  // Timed events are identified by a handle so that they can be removed.
+  using Handle = size_t;
+
+  void onTick(Callback cb) { tick_events_.push_back(std::move(cb)); }
+  Handle onDelay(uint32_t delay_ms, Callback cb) {
+    return add_timed(delay_ms, false, std::move(cb));
+  }
+  Handle onRepeat(uint32_t interval_ms, Callback cb) {
+    return add_timed(interval_ms, true, std::move(cb));
+  }
+  void onInterrupt(int pin, int mode, Callback cb) {
+    sim::attach_interrupt(pin, mode, std::move(cb));
+  }
+  void remove(Handle handle) { timed_events_[handle].active = false; }
+
+  // Re-arm a timed event as if it had just been created. Saves the
+  // transforms below from piling up dead events on every input.
+  void restart(Handle handle);
+
+  void tick();
+  void reset();
+
+ private:
+  struct TimedEvent {
+    uint64_t interval_us;
+    uint64_t due_us;
+    bool repeat;
+    bool active;
+    Callback cb;
+  };
+
+  Handle add_timed(uint32_t ms, bool repeat, Callback cb);
+
+  std::vector<Callback> tick_events_;
+  std::vector<TimedEvent> timed_events_;
+};
+
+}  // namespace reactesp
+
+namespace sensesp {
+
+reactesp::EventLoop* event_loop();
+
+// Formats like the device logger but discards the text, so the hot path still
+// pays for the formatting.
+void debugD(const char* format, ...);
+
+class Observable {
+ public:
+  void attach(std::function<void()> observer) {
+    observers_.push_back(std::move(observer));
+  }
+  void notify() {
+    for (auto& observer : observers_) {
+      observer();
+    }
+  }
+
+ private:
+  std::vector<std::function<void()>> observers_;
+};
+
+template <typename T>
+class ValueConsumer {
+ public:
+  virtual ~ValueConsumer() = default;
+  virtual void set(const T& new_value) {}
+};
+
+template <typename T>
+class ValueProducer : virtual public Observable {
+ public:
+  virtual const T& get() const { return output_; }
+
+  void emit(const T& new_value) {
+    output_ = new_value;
+    notify();
+  }
+
+  template <typename VConsumer>
+  VConsumer* connect_to(VConsumer* consumer) {
+    attach([this, consumer]() { consumer->set(this->get()); });
+    return consumer;
+  }
+
+ protected:
+  T output_{};
+};
+
+template <typename IN, typename OUT>
+class Transform : public ValueConsumer<IN>, public ValueProducer<OUT> {};
+
+template <typename T>
+class LambdaConsumer : public ValueConsumer<T> {
+ public:
+  explicit LambdaConsumer(std::function<void(T)> function)
+      : function_(std::move(function)) {}
+  void set(const T& value) override { function_(value); }
+
+ private:
+  std::function<void(T)> function_;
+};
+
+class DigitalInputChange : public ValueProducer<bool> {
+ public:
+  DigitalInputChange(int pin, int pin_mode, int interrupt_type)
+      : pin_(pin) {
+    pinMode(pin_, pin_mode);
+    event_loop()->onInterrupt(pin_, interrupt_type,
+                              [this]() { triggered_ = true; });
+    event_loop()->onTick([this]() {
+      if (triggered_) {
+        triggered_ = false;
+        emit(digitalRead(pin_));
+      }
+    });
+  }
+
+ private:
+  int pin_;
+  volatile bool triggered_ = false;
+};
+
+class DigitalOutput : public Transform<bool, bool> {
+ public:
+  explicit DigitalOutput(int pin) : pin_(pin) { pinMode(pin_, OUTPUT); }
+  void set(const bool& new_value) override {
+    digitalWrite(pin_, new_value);
+    emit(new_value);
+  }
+
+ private:
+  int pin_;
+};
+
+template <typename T>
+class Debounce : public Transform<T, T> {
+ public:
+  explicit Debounce(int ms_min_delay) : ms_min_delay_(ms_min_delay) {}
+  void set(const T& new_value) override {
+    value_ = new_value;
+    if (scheduled_) {
+      event_loop()->restart(event_);
+      return;
+    }
+    scheduled_ = true;
+    event_ = event_loop()->onDelay(ms_min_delay_,
+                                   [this]() { this->emit(value_); });
+  }
+
+ private:
+  int ms_min_delay_;
+  bool scheduled_ = false;
+  T value_{};
+  reactesp::EventLoop::Handle event_ = 0;
+};
+
+template <typename IN, typename OUT>
+class Repeat : public Transform<IN, OUT> {
+ public:
+  explicit Repeat(long interval) : interval_(interval) {}
+  void set(const IN& input) override {
+    this->emit(input);
+    if (scheduled_) {
+      event_loop()->restart(event_);
+      return;
+    }
+    scheduled_ = true;
+    event_ = event_loop()->onRepeat(interval_, [this]() { this->notify(); });
+  }
+
+ private:
+  long interval_;
+  bool scheduled_ = false;
+  reactesp::EventLoop::Handle event_ = 0;
+};
+
+struct SKMetadata {
+  SKMetadata(const std::string& units, const std::string& display_name)
+      : units_(units), display_name_(display_name) {}
+  std::string units_;
+  std::string display_name_;
+};
+
+template <typename T>
+class SKOutput : public ValueConsumer<T> {
+ public:
+  SKOutput(const std::string& sk_path, const std::string& config_path,
+           std::shared_ptr<SKMetadata> metadata)
+      : sk_path_(sk_path),
+        config_path_(config_path),
+        metadata_(std::move(metadata)) {}
+  void set(const T& new_value) override;
+
+ private:
+  std::string sk_path_;
+  std::string config_path_;
+  std::shared_ptr<SKMetadata> metadata_;
+};
+
+// What SensESP matches a PUT against. The device passes the PUT's JSON
+// object to parse_value(); the simulation passes its path and value.
+class SKPutListener {
+ public:
+  explicit SKPutListener(const std::string& sk_path);
+  virtual ~SKPutListener() = default;
+  const std::string& get_sk_path() const { return sk_path_; }
+  virtual void parse_value(const std::string& path, bool value) = 0;
+
+ private:
+  std::string sk_path_;
+};
+
+template <typename T>
+class SKPutRequestListener : public SKPutListener, public ValueProducer<T> {
+ public:
+  explicit SKPutRequestListener(const std::string& sk_path)
+      : SKPutListener(sk_path) {}
+  void parse_value(const std::string& path, bool value) override {
+    this->emit(value);
+  }
+};
+
+class ConfigItemStub {
+ public:
+  ConfigItemStub* set_title(const char*) { return this; }
+  ConfigItemStub* set_description(const char*) { return this; }
+  ConfigItemStub* set_sort_order(int) { return this; }
+};
+
+template <typename T>
+ConfigItemStub* ConfigItem(T*) {
+  static ConfigItemStub item;
+  return &item;
+}
+
+}  // namespace sensesp
+
+namespace sim {
+
+// In-process stand-in for the Signal K websocket client and server.
+//
+// Queued deltas are serialised and "sent" on the next event loop tick, one
+// message per queued value, which is what the device does today.
+class SignalK {
+ public:
+  // sk_path and value must stay valid until the next send_pending().
+  void queue_delta(const char* sk_path, const char* value);
+  void send_pending();
+
+  // Send a complete delta message built by the caller. Every path in it is
+  // marked as sent.
+  void send_raw(const char* json, size_t length);
+
+  // Deliver a PUT to the listeners registered for sk_path. Listeners are
+  // matched one by one, like the device does.
+  void put(const std::string& sk_path, bool value);
+  void add_put_listener(sensesp::SKPutListener* listener) {
+    put_listeners_.push_back(listener);
+  }
+
+  // Host time at which the last delta for sk_path was sent, or 0.
+  uint64_t last_sent_ns(const std::string& sk_path) const;
+
+  uint64_t messages_sent() const { return messages_sent_; }
+  uint64_t bytes_sent() const { return bytes_sent_; }
+
+  void reset();
+
+ private:
+  struct Pending {
+    const char* sk_path;
+    const char* value;
+  };
+
+  std::vector<Pending> pending_;
+  std::vector<sensesp::SKPutListener*> put_listeners_;
+  std::unordered_map<std::string, uint64_t> last_sent_ns_;
+  uint64_t messages_sent_ = 0;
+  uint64_t bytes_sent_ = 0;
+};
+
+SignalK& signalk();
+
+// Drop every event, interrupt handler, pin state and Signal K listener so
+// that a new graph can be built from scratch.
+void reset();
+
+}  // namespace sim
+
+namespace sensesp {
+
+template <typename T>
+void SKOutput<T>::set(const T& new_value) {
+  static_assert(std::is_same<T, bool>::value,
+                "only boolean outputs are simulated");
+  sim::signalk().queue_delta(sk_path_.c_str(), new_value ? "true" : "false");
+}
+
+inline SKPutListener::SKPutListener(const std::string& sk_path)
+    : sk_path_(sk_path) {
+  sim::signalk().add_put_listener(this);
+}
+
+}  // namespace sensesp
+
+#endif  // RELAY_CONTROLLER_NATIVE_SIM_SENSESP_H_
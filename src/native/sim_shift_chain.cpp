@@ -0,0 +1,29 @@
+#include "native/sim_shift_chain.h"
+
+#include "native/sim_hw.h"
+
+namespace sim {
+
+bool SimShiftChain::transfer(const uint8_t* data, size_t length) {
+  if (length > kMaxRegisters) {
+    return false;
+  }
+  // The first byte ends up in the register farthest from the MCU.
+  for (size_t i = 0; i < length; i++) {
+    latched_[length - 1 - i] = data[i];
+  }
+  registers_ = length;
+  last_latch_ns_ = now_ns();
+  transfers_++;
+  // Eight clocks per byte, plus about one clock each for the latch
+  // going low and high again.
+  last_wire_ns_ = (8 * length + 2) * 1000000000ull / clock_hz_;
+  return true;
+}
+
+bool SimShiftChain::output(int pin) const {
+  return static_cast<size_t>(pin / 8) < registers_ &&
+         (latched_[pin / 8] >> (pin % 8)) & 1;
+}
+
+}  // namespace sim
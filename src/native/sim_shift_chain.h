@@ -0,0 +1,40 @@
+#ifndef RELAY_CONTROLLER_NATIVE_SIM_SHIFT_CHAIN_H_
+#define RELAY_CONTROLLER_NATIVE_SIM_SHIFT_CHAIN_H_
+
+// Simulated 74HC595 chain for ShiftRegisterOutput on the host. Latches each
+// transfer at once and estimates the time it would take on an SPI bus.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/shift_register_output.h"
+
+namespace sim {
+
+class SimShiftChain : public relay_controller::ShiftRegisterBus {
+ public:
+  static constexpr size_t kMaxRegisters = 16;
+
+  explicit SimShiftChain(uint32_t clock_hz = 10000000) : clock_hz_(clock_hz) {}
+
+  bool transfer(const uint8_t* data, size_t length) override;
+
+  // Level of output n of the chain, register 0 nearest the MCU.
+  bool output(int pin) const;
+  uint64_t last_latch_ns() const { return last_latch_ns_; }
+  uint64_t transfers() const { return transfers_; }
+  // Time the last transfer would take on the wire, in nanoseconds.
+  uint64_t last_wire_ns() const { return last_wire_ns_; }
+
+ private:
+  uint32_t clock_hz_;
+  uint8_t latched_[kMaxRegisters] = {};
+  size_t registers_ = 0;
+  uint64_t last_latch_ns_ = 0;
+  uint64_t transfers_ = 0;
+  uint64_t last_wire_ns_ = 0;
+};
+
+}  // namespace sim
+
+#endif  // RELAY_CONTROLLER_NATIVE_SIM_SHIFT_CHAIN_H_
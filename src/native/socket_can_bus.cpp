@@ -0,0 +1,83 @@
+#include "native/socket_can_bus.h"
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <linux/can.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace relay_controller {
+
+SocketCanBus::~SocketCanBus() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool SocketCanBus::open(const char* interface) {
+  int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (fd < 0) {
+    return false;
+  }
+  struct sockaddr_can address = {};
+  address.can_family = AF_CAN;
+  address.can_ifindex = if_nametoindex(interface);
+  if (address.can_ifindex == 0 ||
+      bind(fd, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) < 0 ||
+      fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+    close(fd);
+    return false;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  fd_ = fd;
+  return true;
+}
+
+bool SocketCanBus::send(const CanFrame& frame) {
+  struct can_frame out = {};
+  out.can_id = (frame.id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+  out.can_dlc = frame.length;
+  memcpy(out.data, frame.data, frame.length);
+  return fd_ >= 0 && write(fd_, &out, sizeof(out)) == sizeof(out);
+}
+
+bool SocketCanBus::receive(CanFrame* frame) {
+  struct can_frame in;
+  while (fd_ >= 0 && read(fd_, &in, sizeof(in)) == sizeof(in)) {
+    if ((in.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) !=
+            CAN_EFF_FLAG ||
+        in.can_dlc > 8) {
+      continue;
+    }
+    frame->id = in.can_id & CAN_EFF_MASK;
+    frame->length = in.can_dlc;
+    memcpy(frame->data, in.data, in.can_dlc);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace relay_controller
+
+#else
+
+namespace relay_controller {
+
+SocketCanBus::~SocketCanBus() = default;
+
+bool SocketCanBus::open(const char*) { return false; }
+
+bool SocketCanBus::send(const CanFrame&) { return false; }
+
+bool SocketCanBus::receive(CanFrame*) { return false; }
+
+}  // namespace relay_controller
+
+#endif
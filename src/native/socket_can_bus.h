@@ -0,0 +1,33 @@
+#ifndef RELAY_CONTROLLER_NATIVE_SOCKET_CAN_BUS_H_
+#define RELAY_CONTROLLER_NATIVE_SOCKET_CAN_BUS_H_
+
+// CanBus on a Linux SocketCAN interface, so that N2kSwitchBank can be run
+// against a virtual CAN bus (vcan) and real tools such as candump and
+// cansend. Frames a socket sends are seen by every other socket on the
+// interface but not by itself. Elsewhere open() always fails.
+
+#include "relay/can_bus.h"
+
+namespace relay_controller {
+
+class SocketCanBus : public CanBus {
+ public:
+  SocketCanBus() = default;
+  SocketCanBus(const SocketCanBus&) = delete;
+  SocketCanBus& operator=(const SocketCanBus&) = delete;
+  ~SocketCanBus() override;
+
+  // Bind to interface, e.g. "vcan0". Returns false if it does not exist
+  // or is down.
+  bool open(const char* interface);
+
+  bool send(const CanFrame& frame) override;
+  bool receive(CanFrame* frame) override;
+
+ private:
+  int fd_ = -1;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_NATIVE_SOCKET_CAN_BUS_H_
@@ -0,0 +1,234 @@
+#ifndef RELAY_CONTROLLER_RELAY_BANK_DEBOUNCER_H_
+#define RELAY_CONTROLLER_RELAY_BANK_DEBOUNCER_H_
+
+// Debounces every button of a bank from one read of the GPIO input
+// registers.
+//
+// Each input bit has a small counter stored "vertically": bit k of every
+// counter lives in plane k, so one pass of bitwise operations over the
+// planes advances all 64 counters of a word at once. A counter runs while
+// the sampled level differs from the debounced one and resets when it
+// doesn't; when it reaches that pin's limit the debounced level flips.
+//
+// Sampling alone misses a press that starts and ends while the event loop
+// is stalled. The edges EdgeCapture stamped during the stall still show
+// it, so they are debounced by their times as well: a level the pin held
+// for the debounce time between two edges, and never sampled, is reported
+// to the bank as a press and a release.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/channel_set.h"
+#include "relay/hal.h"
+#include "relay/relay_bank.h"
+
+namespace relay_controller {
+
+class VerticalCounterWord {
+ public:
+  static constexpr unsigned kPlanes = 5;
+  static constexpr unsigned kMaxSamples = (1u << kPlanes) - 1;
+
+  void reset(uint64_t level) {
+    stable_ = level;
+    for (auto& plane : count_) {
+      plane = 0;
+    }
+  }
+
+  // Number of consecutive differing samples before bit flips, 1 to
+  // kMaxSamples.
+  void set_limit(unsigned bit, unsigned samples) {
+    uint64_t mask = uint64_t{1} << bit;
+    for (unsigned k = 0; k < kPlanes; k++) {
+      if (samples & (1u << k)) {
+        limit_[k] |= mask;
+      } else {
+        limit_[k] &= ~mask;
+      }
+    }
+  }
+
+  // Feed one sample; returns the bits whose debounced level flipped.
+  uint64_t update(uint64_t sample) {
+    uint64_t differs = sample ^ stable_;
+
+    // Clear the counters of settled bits and add one to the others.
+    uint64_t carry = differs;
+    for (auto& plane : count_) {
+      plane &= differs;
+      uint64_t next_carry = plane & carry;
+      plane ^= carry;
+      carry = next_carry;
+    }
+
+    uint64_t reached = differs;
+    for (unsigned k = 0; k < kPlanes; k++) {
+      reached &= ~(count_[k] ^ limit_[k]);
+    }
+    stable_ ^= reached;
+    for (auto& plane : count_) {
+      plane &= ~reached;
+    }
+    return reached;
+  }
+
+  uint64_t stable() const { return stable_; }
+
+ private:
+  uint64_t stable_ = 0;
+  uint64_t count_[kPlanes] = {};
+  uint64_t limit_[kPlanes] = {};
+};
+
+template <size_t N>
+class BankDebouncer {
+ public:
+  static constexpr size_t kPins = hal::kPinWords * 64;
+
+  // Sample every sample_period_us and require debounce_ms of stable level
+  // on every button of bank.
+  void begin(const RelayBank<N>& bank, uint32_t debounce_ms,
+             uint32_t sample_period_us = 2000) {
+    sample_period_us_ = sample_period_us;
+    for (size_t i = 0; i < N; i++) {
+      uint16_t pin = bank.channel(i).pins().button;
+      if (pin == kNoPin) {
+        continue;
+      }
+      pin_of_channel_[i] = pin;
+      channel_of_pin_[pin] = static_cast<uint8_t>(i);
+      button_mask_[pin / 64] |= uint64_t{1} << (pin % 64);
+      set_debounce_ms(i, debounce_ms);
+    }
+    uint64_t sample[hal::kPinWords];
+    hal::read_inputs(sample);
+    for (size_t w = 0; w < hal::kPinWords; w++) {
+      words_[w].reset(sample[w] & button_mask_[w]);
+      edge_level_[w] = words_[w].stable();
+    }
+    last_sample_us_ = hal::now_us();
+  }
+
+  void set_debounce_ms(size_t channel, uint32_t debounce_ms) {
+    uint32_t samples =
+        sample_period_us_ == 0
+            ? 1
+            : (debounce_ms * 1000 + sample_period_us_ - 1) / sample_period_us_;
+    if (samples < 1) {
+      samples = 1;
+    } else if (samples > VerticalCounterWord::kMaxSamples) {
+      samples = VerticalCounterWord::kMaxSamples;
+    }
+    uint16_t pin = pin_of_channel_[channel];
+    words_[pin / 64].set_limit(pin % 64, samples);
+    debounce_us_[channel] = samples * sample_period_us_;
+  }
+
+  // Raw edge from EdgeCapture. A press that survives debouncing is reported
+  // as happening at its first edge. A press held between two edges for the
+  // debounce time while the level samples still show the pin released was
+  // missed by sampling, and is reported by the next tick().
+  void handle_button(size_t channel, bool level, uint64_t stamp_us) {
+    uint16_t pin = pin_of_channel_[channel];
+    size_t w = pin / 64;
+    uint64_t bit = uint64_t{1} << (pin % 64);
+    if ((stamped_[w] & bit) == 0) {
+      stamped_[w] |= bit;
+      first_edge_us_[channel] = stamp_us;
+    }
+    bool previous = (edge_level_[w] & bit) != 0;
+    if (level == previous) {
+      return;
+    }
+    bool stable = (words_[w].stable() & bit) != 0;
+    if (previous != stable &&
+        stamp_us - last_edge_us_[channel] >= debounce_us_[channel]) {
+      if (missed_[channel] == 0) {
+        missed_press_us_[channel] = last_edge_us_[channel];
+      }
+      if (missed_[channel] < UINT8_MAX) {
+        missed_[channel]++;
+      }
+      missed_release_us_[channel] = stamp_us;
+      missed_channels_.set(channel);
+    }
+    edge_level_[w] ^= bit;
+    last_edge_us_[channel] = stamp_us;
+  }
+
+  // Report presses only the edges saw, then take a sample if one is due
+  // and hand clean edges to bank.
+  void tick(RelayBank<N>* bank) {
+    if (missed_channels_.any()) {
+      report_missed(bank);
+    }
+    uint64_t now = hal::now_us();
+    if (now - last_sample_us_ < sample_period_us_) {
+      return;
+    }
+    last_sample_us_ = now;
+
+    uint64_t sample[hal::kPinWords];
+    hal::read_inputs(sample);
+    for (size_t w = 0; w < hal::kPinWords; w++) {
+      uint64_t buttons = sample[w] & button_mask_[w];
+      // A bounce that settled back to the debounced level must not lend its
+      // time to the next real press.
+      stamped_[w] &= buttons ^ words_[w].stable();
+      uint64_t flipped = words_[w].update(buttons);
+      uint64_t stamped = stamped_[w];
+      stamped_[w] &= ~flipped;
+      while (flipped != 0) {
+        unsigned bit = __builtin_ctzll(flipped);
+        flipped &= flipped - 1;
+        unsigned channel = channel_of_pin_[w * 64 + bit];
+        uint64_t stamp =
+            (stamped >> bit) & 1 ? first_edge_us_[channel] : now;
+        bank->handle_button(channel, (words_[w].stable() >> bit) & 1, stamp);
+      }
+    }
+  }
+
+  // Presses seen only in the edges, as the loop was stalled through them.
+  uint32_t missed_presses() const { return missed_presses_; }
+
+ private:
+  void report_missed(RelayBank<N>* bank) {
+    missed_channels_.for_each([&](size_t channel) {
+      uint16_t pin = pin_of_channel_[channel];
+      bool stable = (words_[pin / 64].stable() >> (pin % 64)) & 1;
+      for (; missed_[channel] > 0; missed_[channel]--) {
+        bank->handle_button(channel, !stable, missed_press_us_[channel]);
+        bank->handle_button(channel, stable, missed_release_us_[channel]);
+        missed_presses_++;
+      }
+    });
+    missed_channels_.clear();
+  }
+
+  VerticalCounterWord words_[hal::kPinWords];
+  uint64_t button_mask_[hal::kPinWords] = {};
+  // Buttons whose first edge time is held in first_edge_us_.
+  uint64_t stamped_[hal::kPinWords] = {};
+  uint64_t first_edge_us_[N] = {};
+  // Each button's level after its last captured edge, and that edge's time.
+  uint64_t edge_level_[hal::kPinWords] = {};
+  uint64_t last_edge_us_[N] = {};
+  uint32_t debounce_us_[N] = {};
+  // Presses the edges showed and the samples did not, to report in tick().
+  ChannelSet<N> missed_channels_;
+  uint8_t missed_[N] = {};
+  uint64_t missed_press_us_[N] = {};
+  uint64_t missed_release_us_[N] = {};
+  uint32_t missed_presses_ = 0;
+  uint16_t pin_of_channel_[N] = {};
+  uint8_t channel_of_pin_[kPins] = {};
+  uint64_t last_sample_us_ = 0;
+  uint32_t sample_period_us_ = 2000;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_BANK_DEBOUNCER_H_
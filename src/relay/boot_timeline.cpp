@@ -0,0 +1,81 @@
+#include "relay/boot_timeline.h"
+
+#include "relay/hal.h"
+#include "relay/json_writer.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+const char* boot_stage_name(BootStage stage) {
+  switch (stage) {
+    case BootStage::kOutputsValid:
+      return "outputsValid";
+    case BootStage::kWifiUp:
+      return "wifiUp";
+    case BootStage::kFirstDelta:
+      return "firstDelta";
+  }
+  return "";
+}
+
+bool BootTimeline::store(BootStage stage) {
+  uint64_t now = hal::now_us();
+  uint32_t at = now == 0 ? 1 : static_cast<uint32_t>(now);
+  uint32_t expected = 0;
+  return stamps_[static_cast<size_t>(stage)].compare_exchange_strong(
+      expected, at, std::memory_order_relaxed);
+}
+
+void BootTimeline::mark(BootStage stage) {
+  if (store(stage)) {
+    trace_stamped();
+  }
+}
+
+void BootTimeline::stamp(BootStage stage) { store(stage); }
+
+void BootTimeline::trace_stamped() {
+  constexpr uint8_t kAll = (1u << kBootStages) - 1;
+  if (traced_ == kAll) {
+    return;
+  }
+  for (size_t i = 0; i < kBootStages; i++) {
+    BootStage stage = static_cast<BootStage>(i);
+    if ((traced_ & (1u << i)) == 0 && reached(stage)) {
+      traced_ |= 1u << i;
+      RELAY_TRACE(kBootStage, static_cast<uint32_t>(i), at_us(stage));
+    }
+  }
+}
+
+bool BootTimeline::complete() const {
+  for (size_t i = 0; i < kBootStages; i++) {
+    if (!reached(static_cast<BootStage>(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BootTimeline::publish(DeltaSink* sink, const char* firmware) const {
+  char buffer[384];
+  JsonWriter writer(buffer, sizeof(buffer));
+  writer.raw("{\"updates\":[{\"values\":[");
+  for (size_t i = 0; i < kBootStages; i++) {
+    BootStage stage = static_cast<BootStage>(i);
+    if (!reached(stage)) {
+      continue;
+    }
+    writer.raw("{\"path\":\"sensors.relaycontroller.boot.")
+        .raw(boot_stage_name(stage))
+        .raw("\",\"value\":")
+        .seconds(at_us(stage))
+        .raw("},");
+  }
+  writer.raw("{\"path\":\"sensors.relaycontroller.boot.firmware\",\"value\":")
+      .string(firmware)
+      .raw("}]}]}");
+  return writer.ok() && sink->send_delta(writer.c_str(), writer.length());
+}
+
+}  // namespace relay_controller
@@ -0,0 +1,70 @@
+#ifndef RELAY_CONTROLLER_RELAY_BOOT_TIMELINE_H_
+#define RELAY_CONTROLLER_RELAY_BOOT_TIMELINE_H_
+
+// When the device got through each stage of booting, in microseconds since
+// the application started, published once as one Signal K delta in
+// seconds:
+//
+//   sensors.relaycontroller.boot.outputsValid
+//   sensors.relaycontroller.boot.wifiUp
+//   sensors.relaycontroller.boot.firstDelta
+//   sensors.relaycontroller.boot.firmware
+//
+// The clock starts when the second stage bootloader hands over, so the
+// ROM and bootloader time since the reset itself, typically 250-300 ms on
+// the ESP32, comes on top of every figure.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/delta_sink.h"
+
+namespace relay_controller {
+
+enum class BootStage : uint8_t {
+  kOutputsValid,
+  kWifiUp,
+  kFirstDelta,
+};
+
+constexpr size_t kBootStages = 3;
+
+const char* boot_stage_name(BootStage stage);
+
+class BootTimeline {
+ public:
+  // Record that stage was reached now, and trace it along with any stage
+  // stamp() recorded. Only the first call per stage counts. Call from the
+  // event loop only: the trace ring has a single producer.
+  void mark(BootStage stage);
+  // Record that stage was reached now, from another task such as a WiFi
+  // event handler. Only the time is stored; the event loop traces it on
+  // its next mark() or trace_stamped().
+  void stamp(BootStage stage);
+  // Trace the stages stamp() recorded. Event loop only.
+  void trace_stamped();
+
+  bool reached(BootStage stage) const { return at_us(stage) != 0; }
+  uint32_t at_us(BootStage stage) const {
+    return stamps_[static_cast<size_t>(stage)].load(std::memory_order_relaxed);
+  }
+  bool complete() const;
+
+  // Send every stage with firmware, which identifies the build. Returns
+  // false if the delta could not be sent.
+  bool publish(DeltaSink* sink, const char* firmware) const;
+
+ private:
+  // Store now as the time of stage unless it has one. False if it had.
+  bool store(BootStage stage);
+
+  // 0 until the stage is reached.
+  std::atomic<uint32_t> stamps_[kBootStages] = {};
+  // Stages already traced, one bit each. Event loop only.
+  uint8_t traced_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_BOOT_TIMELINE_H_
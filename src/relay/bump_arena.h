@@ -0,0 +1,115 @@
+#ifndef RELAY_CONTROLLER_RELAY_BUMP_ARENA_H_
+#define RELAY_CONTROLLER_RELAY_BUMP_ARENA_H_
+
+// Bump allocator for objects that are created in setup() and live until
+// reboot.
+//
+// The SensESP objects behind the relays (outputs, PUT listeners, consumers,
+// config items) never go away, so there is no reason for them to sit in the
+// general heap between WiFi and JSON buffers that come and go. An arena
+// hands them out back to back from one block reserved at boot and never
+// frees anything. If the block runs out, objects fall back to the heap and
+// the arena counts them, so an undersized arena shows up in the report
+// instead of failing.
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace relay_controller {
+
+class BumpArena {
+ public:
+  BumpArena(void* storage, size_t capacity)
+      : storage_(static_cast<uint8_t*>(storage)), capacity_(capacity) {}
+
+  BumpArena(const BumpArena&) = delete;
+  BumpArena& operator=(const BumpArena&) = delete;
+
+  // size bytes aligned to alignment, or nullptr if they do not fit.
+  void* allocate(size_t size, size_t alignment) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(storage_);
+    uintptr_t start = (base + used_ + alignment - 1) & ~(alignment - 1);
+    size_t end = start - base + size;
+    if (end > capacity_) {
+      return nullptr;
+    }
+    used_ = end;
+    allocations_++;
+    return reinterpret_cast<void*>(start);
+  }
+
+  // Construct a T in the arena, or on the heap once the arena is full. The
+  // object is never destroyed.
+  template <typename T, typename... Args>
+  T* make(Args&&... args) {
+    void* p = allocate(sizeof(T), alignof(T));
+    if (p == nullptr) {
+      overflows_++;
+      return new T(std::forward<Args>(args)...);
+    }
+    return new (p) T(std::forward<Args>(args)...);
+  }
+
+  bool contains(const void* p) const {
+    auto* byte = static_cast<const uint8_t*>(p);
+    return byte >= storage_ && byte < storage_ + capacity_;
+  }
+
+  size_t capacity() const { return capacity_; }
+  size_t used() const { return used_; }
+  uint32_t allocations() const { return allocations_; }
+  // Objects that did not fit and went to the heap instead.
+  uint32_t overflows() const { return overflows_; }
+
+ private:
+  uint8_t* storage_;
+  size_t capacity_;
+  size_t used_ = 0;
+  uint32_t allocations_ = 0;
+  uint32_t overflows_ = 0;
+};
+
+// Standard allocator over a BumpArena, for std::allocate_shared() and the
+// like. Deallocation only returns memory that overflowed to the heap.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(BumpArena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if (void* p = arena_->allocate(n * sizeof(T), alignof(T))) {
+      return static_cast<T*>(p);
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t) {
+    if (!arena_->contains(p)) {
+      ::operator delete(p);
+    }
+  }
+
+  BumpArena* arena() const { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+ private:
+  BumpArena* arena_;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_BUMP_ARENA_H_
@@ -0,0 +1,103 @@
+#include "relay/button_matrix.h"
+
+namespace relay_controller {
+
+void ButtonMatrix::begin(const MatrixWiring& wiring) {
+  wiring_ = wiring;
+  for (size_t r = 0; r < wiring_.row_count; r++) {
+    uint8_t pin = wiring_.rows[r];
+    hal::configure_open_drain(pin);
+    row_pins_[pin / 64] |= uint64_t{1} << (pin % 64);
+  }
+  for (size_t c = 0; c < wiring_.column_count; c++) {
+    hal::configure_input_pullup(wiring_.columns[c]);
+  }
+  settle();
+  // Keys of a ghost rectangle read released until it clears.
+  levels_ = ~uint64_t{0};
+  scan();
+}
+
+void ButtonMatrix::drive_rows(uint64_t low_rows_mask) {
+  uint64_t set[hal::kPinWords];
+  uint64_t clear[hal::kPinWords] = {};
+  for (size_t w = 0; w < hal::kPinWords; w++) {
+    set[w] = row_pins_[w];
+  }
+  for (size_t r = 0; r < wiring_.row_count; r++) {
+    if ((low_rows_mask >> r) & 1) {
+      uint8_t pin = wiring_.rows[r];
+      uint64_t bit = uint64_t{1} << (pin % 64);
+      set[pin / 64] &= ~bit;
+      clear[pin / 64] |= bit;
+    }
+  }
+  hal::write_outputs(set, clear);
+}
+
+// Bit c is set while column c is pulled low.
+uint8_t ButtonMatrix::read_columns() {
+  uint64_t inputs[hal::kPinWords];
+  hal::read_inputs(inputs);
+  uint8_t low = 0;
+  for (size_t c = 0; c < wiring_.column_count; c++) {
+    uint8_t pin = wiring_.columns[c];
+    if (((inputs[pin / 64] >> (pin % 64)) & 1) == 0) {
+      low |= static_cast<uint8_t>(1u << c);
+    }
+  }
+  return low;
+}
+
+void ButtonMatrix::settle() {
+  if (wiring_.settle_us == 0) {
+    return;
+  }
+  uint64_t start = hal::now_us();
+  while (hal::now_us() - start < wiring_.settle_us) {
+  }
+}
+
+bool ButtonMatrix::any_pressed() {
+  drive_rows((1u << wiring_.row_count) - 1);
+  settle();
+  bool pressed = read_columns() != 0;
+  drive_rows(0);
+  settle();
+  return pressed;
+}
+
+uint64_t ButtonMatrix::scan() {
+  uint8_t pressed[MatrixWiring::kMaxLines] = {};
+  for (size_t r = 0; r < wiring_.row_count; r++) {
+    drive_rows(uint64_t{1} << r);
+    settle();
+    pressed[r] = read_columns();
+  }
+  drive_rows(0);
+
+  uint64_t ghosts = 0;
+  if (!wiring_.diodes) {
+    for (size_t a = 0; a < wiring_.row_count; a++) {
+      for (size_t b = a + 1; b < wiring_.row_count; b++) {
+        uint8_t shared = pressed[a] & pressed[b];
+        if ((shared & (shared - 1)) != 0) {
+          ghosts |= static_cast<uint64_t>(shared) << (a * 8) |
+                    static_cast<uint64_t>(shared) << (b * 8);
+        }
+      }
+    }
+  }
+  uint64_t levels = ~uint64_t{0};
+  for (size_t r = 0; r < wiring_.row_count; r++) {
+    levels &= ~(static_cast<uint64_t>(pressed[r]) << (r * 8));
+  }
+  if (ghosts != 0) {
+    ghost_scans_++;
+    levels = (levels & ~ghosts) | (levels_ & ghosts);
+  }
+  levels_ = levels;
+  return levels;
+}
+
+}  // namespace relay_controller
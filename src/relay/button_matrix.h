@@ -0,0 +1,77 @@
+#ifndef RELAY_CONTROLLER_RELAY_BUTTON_MATRIX_H_
+#define RELAY_CONTROLLER_RELAY_BUTTON_MATRIX_H_
+
+// Up to 8 x 8 buttons on a row/column matrix: 64 buttons on 16 GPIOs.
+//
+// Rows are open-drain outputs, columns inputs with pull-ups. A scan pulls
+// one row low at a time and reads every column with one read of the input
+// register. Key k is row k / 8, column k % 8; its level reads like a button
+// on a GPIO, low while pressed.
+//
+// With a diode in series with every key, any combination of keys reads
+// correctly (n-key rollover). Without them, three keys pressed on the
+// corners of a rectangle make the fourth read pressed too. A scan that
+// finds such a rectangle keeps the previous level of its four keys until
+// it is gone, so a ghost never switches a relay.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/hal.h"
+#include "relay/input_stage.h"
+
+namespace relay_controller {
+
+struct MatrixWiring {
+  static constexpr size_t kMaxLines = 8;
+
+  uint8_t rows[kMaxLines];
+  uint8_t columns[kMaxLines];
+  size_t row_count;
+  size_t column_count;
+  // Every key has a diode from its column to its row.
+  bool diodes;
+  // Time the columns need to rise back to high through their pull-ups after
+  // a row is released, before the next row is read.
+  uint32_t settle_us;
+};
+
+class ButtonMatrix : public InputStage {
+ public:
+  static constexpr size_t kMaxKeys =
+      MatrixWiring::kMaxLines * MatrixWiring::kMaxLines;
+
+  // Configure the lines and take a first scan. Call before RelayBank::begin()
+  // when the bank reads its buttons through this stage.
+  void begin(const MatrixWiring& wiring);
+
+  // The lines are set up by begin().
+  void configure_input(int key) override {}
+  // Level of key in the last scan.
+  bool read_input(int key) override { return (levels_ >> key) & 1; }
+
+  // Pull every row low at once and report whether any column follows: one
+  // read that tells an idle matrix from one with a key down.
+  bool any_pressed();
+
+  // Read every key. Bit k of the result is the level of key k, low while
+  // pressed; keys of a ghost rectangle keep their level from the last scan.
+  uint64_t scan();
+
+  // Scans that found a ghost rectangle.
+  uint32_t ghost_scans() const { return ghost_scans_; }
+
+ private:
+  void drive_rows(uint64_t low_rows_mask);
+  uint8_t read_columns();
+  void settle();
+
+  MatrixWiring wiring_ = {};
+  uint64_t row_pins_[hal::kPinWords] = {};
+  uint64_t levels_ = ~uint64_t{0};
+  uint32_t ghost_scans_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_BUTTON_MATRIX_H_
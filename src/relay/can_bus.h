@@ -0,0 +1,33 @@
+#ifndef RELAY_CONTROLLER_RELAY_CAN_BUS_H_
+#define RELAY_CONTROLLER_RELAY_CAN_BUS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace relay_controller {
+
+// One CAN frame with a 29-bit identifier, the only kind NMEA 2000 uses.
+struct CanFrame {
+  uint32_t id;
+  uint8_t length;
+  uint8_t data[8];
+};
+
+// A CAN controller on a 250 kbit/s bus: TWAI on the device, SocketCAN or
+// sim::SimCanBus on the host. Neither call blocks, and frames with 11-bit
+// identifiers are never received.
+class CanBus {
+ public:
+  virtual ~CanBus() = default;
+
+  // Queue frame for sending. Returns false if the queue is full or the
+  // controller is off the bus.
+  virtual bool send(const CanFrame& frame) = 0;
+
+  // Take the oldest received frame. Returns false if there is none.
+  virtual bool receive(CanFrame* frame) = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_CAN_BUS_H_
@@ -0,0 +1,76 @@
+#ifndef RELAY_CONTROLLER_RELAY_CHANNEL_SET_H_
+#define RELAY_CONTROLLER_RELAY_CHANNEL_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace relay_controller {
+
+// Fixed-size set of channel indices, one bit per channel.
+template <size_t N>
+class ChannelSet {
+ public:
+  static constexpr size_t kWords = (N + 31) / 32;
+
+  void set(size_t channel) { words_[channel / 32] |= bit(channel); }
+  void reset(size_t channel) { words_[channel / 32] &= ~bit(channel); }
+  void assign(size_t channel, bool value) {
+    value ? set(channel) : reset(channel);
+  }
+  bool test(size_t channel) const {
+    return (words_[channel / 32] & bit(channel)) != 0;
+  }
+  void clear() {
+    for (auto& word : words_) {
+      word = 0;
+    }
+  }
+  bool any() const {
+    for (auto word : words_) {
+      if (word != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+  size_t count() const {
+    size_t members = 0;
+    for (auto word : words_) {
+      members += __builtin_popcount(word);
+    }
+    return members;
+  }
+
+  ChannelSet& operator|=(const ChannelSet& other) {
+    for (size_t w = 0; w < kWords; w++) {
+      words_[w] |= other.words_[w];
+    }
+    return *this;
+  }
+
+  // Call f(channel) for every member, lowest first.
+  template <typename F>
+  void for_each(F f) const {
+    for (size_t w = 0; w < kWords; w++) {
+      uint32_t word = words_[w];
+      while (word != 0) {
+        size_t channel = w * 32 + __builtin_ctz(word);
+        word &= word - 1;
+        f(channel);
+      }
+    }
+  }
+
+  uint32_t word(size_t index) const { return words_[index]; }
+  const uint32_t* words() const { return words_; }
+  void set_word(size_t index, uint32_t value) { words_[index] = value; }
+
+ private:
+  static uint32_t bit(size_t channel) { return uint32_t{1} << (channel % 32); }
+
+  uint32_t words_[kWords] = {};
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_CHANNEL_SET_H_
@@ -0,0 +1,389 @@
+#ifndef RELAY_CONTROLLER_RELAY_CHANNEL_TABLE_H_
+#define RELAY_CONTROLLER_RELAY_CHANNEL_TABLE_H_
+
+// Compile-time checks and strings for a constexpr table of ChannelSpecs.
+//
+// The channel table in main.cpp is the one place pins and Signal K paths
+// are written down. The predicates here let it static_assert that every pin
+// exists on the target chip, that relays and LEDs are not on input-only or
+// flash pins, and that no pin or path is used twice. ChannelNames<N> holds
+// the per-channel config paths and UI titles, generated by the compiler and
+// stored in flash.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/button_matrix.h"
+#include "relay/hal.h"
+#include "relay/relay_bank.h"
+
+#ifdef ARDUINO
+#include <esp_bit_defs.h>
+#include <sdkconfig.h>
+#include <soc/soc_caps.h>
+#endif
+
+namespace relay_controller {
+
+namespace board {
+
+#ifdef ARDUINO
+constexpr uint64_t kValidPins = SOC_GPIO_VALID_GPIO_MASK;
+constexpr uint64_t kOutputPins = SOC_GPIO_VALID_OUTPUT_GPIO_MASK;
+// GPIOs wired to the SPI flash on common modules.
+#if defined(CONFIG_IDF_TARGET_ESP32)
+constexpr uint64_t kFlashPins = 0x3FULL << 6;  // GPIO 6-11
+#elif defined(CONFIG_IDF_TARGET_ESP32C3)
+constexpr uint64_t kFlashPins = 0x3FULL << 12;  // GPIO 12-17
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+constexpr uint64_t kFlashPins = 0x7FULL << 26;  // GPIO 26-32
+#else
+constexpr uint64_t kFlashPins = 0;
+#endif
+#endif
+
+// pin exists on the target and is not taken by the flash.
+constexpr bool pin_exists(uint16_t pin) {
+#ifdef ARDUINO
+  return pin < 64 && ((kValidPins & ~kFlashPins) >> pin & 1) != 0;
+#else
+  return pin < hal::kPinWords * 64;
+#endif
+}
+
+// pin exists and can drive an output.
+constexpr bool pin_can_output(uint16_t pin) {
+#ifdef ARDUINO
+  return pin_exists(pin) && (kOutputPins >> pin & 1) != 0;
+#else
+  return pin_exists(pin);
+#endif
+}
+
+}  // namespace board
+
+// Every button pin other than kNoPin exists.
+template <size_t N>
+constexpr bool buttons_valid(const ChannelSpec (&table)[N]) {
+  for (size_t i = 0; i < N; i++) {
+    if (table[i].pins.button != kNoPin &&
+        !board::pin_exists(table[i].pins.button)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Every relay pin, and every LED pin other than kNoPin, can drive an output.
+template <size_t N>
+constexpr bool outputs_valid(const ChannelSpec (&table)[N]) {
+  for (size_t i = 0; i < N; i++) {
+    if (!board::pin_can_output(table[i].pins.relay) ||
+        (table[i].pins.led != kNoPin &&
+         !board::pin_can_output(table[i].pins.led))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The channels that have a status LED.
+template <size_t N>
+constexpr size_t led_count(const ChannelSpec (&table)[N]) {
+  size_t leds = 0;
+  for (size_t i = 0; i < N; i++) {
+    leds += table[i].pins.led != kNoPin;
+  }
+  return leds;
+}
+
+// Every pin is one of the 16 of each of chips I2C expanders.
+template <size_t N>
+constexpr bool expander_pins_valid(const ChannelSpec (&table)[N],
+                                   size_t chips) {
+  for (size_t i = 0; i < N; i++) {
+    if (table[i].pins.button >= chips * 16 ||
+        table[i].pins.relay >= chips * 16 ||
+        (table[i].pins.led != kNoPin && table[i].pins.led >= chips * 16)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Relays are on a chain of 74HC595s rather than on GPIOs: every relay pin
+// is one of the registers * 8 outputs and used once, there are no LEDs,
+// and no button pin is used twice.
+template <size_t N>
+constexpr bool shift_register_pins_valid(const ChannelSpec (&table)[N],
+                                         size_t registers) {
+  for (size_t a = 0; a < N; a++) {
+    if (table[a].pins.relay >= registers * 8 || table[a].pins.led != kNoPin) {
+      return false;
+    }
+    for (size_t b = a + 1; b < N; b++) {
+      if (table[a].pins.relay == table[b].pins.relay ||
+          (table[a].pins.button != kNoPin &&
+           table[a].pins.button == table[b].pins.button)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Rows can drive an output, columns exist, there are at most 8 of each and
+// no line is used twice.
+constexpr bool matrix_wiring_valid(const MatrixWiring& wiring) {
+  if (wiring.row_count > MatrixWiring::kMaxLines ||
+      wiring.column_count > MatrixWiring::kMaxLines) {
+    return false;
+  }
+  uint16_t lines[2 * MatrixWiring::kMaxLines] = {};
+  size_t count = 0;
+  for (size_t r = 0; r < wiring.row_count; r++) {
+    if (!board::pin_can_output(wiring.rows[r])) {
+      return false;
+    }
+    lines[count++] = wiring.rows[r];
+  }
+  for (size_t c = 0; c < wiring.column_count; c++) {
+    if (!board::pin_exists(wiring.columns[c])) {
+      return false;
+    }
+    lines[count++] = wiring.columns[c];
+  }
+  for (size_t a = 0; a < count; a++) {
+    for (size_t b = a + 1; b < count; b++) {
+      if (lines[a] == lines[b]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Every button other than kNoPin is a key of the matrix, row * 8 + column.
+template <size_t N>
+constexpr bool matrix_keys_valid(const ChannelSpec (&table)[N],
+                                 const MatrixWiring& wiring) {
+  for (size_t i = 0; i < N; i++) {
+    uint16_t key = table[i].pins.button;
+    if (key != kNoPin &&
+        (key / 8 >= wiring.row_count || key % 8 >= wiring.column_count)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// No pin appears twice, across buttons, relays and LEDs.
+template <size_t N>
+constexpr bool pins_unique(const ChannelSpec (&table)[N]) {
+  uint16_t pins[3 * N] = {};
+  size_t count = 0;
+  for (size_t i = 0; i < N; i++) {
+    if (table[i].pins.button != kNoPin) {
+      pins[count++] = table[i].pins.button;
+    }
+    pins[count++] = table[i].pins.relay;
+    if (table[i].pins.led != kNoPin) {
+      pins[count++] = table[i].pins.led;
+    }
+  }
+  for (size_t a = 0; a < count; a++) {
+    for (size_t b = a + 1; b < count; b++) {
+      if (pins[a] == pins[b]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// No channel uses pin. For tables whose relays are register outputs rather
+// than GPIOs, pass gpio_relays = false to check buttons and LEDs only.
+template <size_t N>
+constexpr bool pin_unused(const ChannelSpec (&table)[N], uint16_t pin,
+                          bool gpio_relays = true) {
+  for (size_t i = 0; i < N; i++) {
+    if (table[i].pins.button == pin || table[i].pins.led == pin ||
+        (gpio_relays && table[i].pins.relay == pin)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// pin is none of pins.
+template <size_t N>
+constexpr bool pin_unused(const uint16_t (&pins)[N], uint16_t pin) {
+  for (size_t i = 0; i < N; i++) {
+    if (pins[i] == pin) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// pin is not a row or column of wiring.
+constexpr bool matrix_pin_unused(const MatrixWiring& wiring, uint16_t pin) {
+  for (size_t i = 0; i < wiring.row_count; i++) {
+    if (wiring.rows[i] == pin) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < wiring.column_count; i++) {
+    if (wiring.columns[i] == pin) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// No two channels publish on the same Signal K path.
+template <size_t N>
+constexpr bool sk_paths_unique(const ChannelSpec (&table)[N]) {
+  for (size_t a = 0; a < N; a++) {
+    for (size_t b = a + 1; b < N; b++) {
+      const char* p = table[a].sk_path;
+      const char* q = table[b].sk_path;
+      while (*p != '\0' && *p == *q) {
+        p++;
+        q++;
+      }
+      if (*p == *q) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// A string built at compile time. Running past Size while building one is
+// an error in constant evaluation, so a name that does not fit fails the
+// build rather than being cut short.
+template <size_t Size>
+struct FixedString {
+  char chars[Size] = {};
+
+  constexpr const char* c_str() const { return chars; }
+};
+
+// prefix, the decimal number, then suffix.
+template <size_t Size>
+constexpr FixedString<Size> numbered_string(const char* prefix, size_t number,
+                                            const char* suffix) {
+  FixedString<Size> out;
+  size_t length = 0;
+  for (const char* p = prefix; *p != '\0'; p++) {
+    out.chars[length++] = *p;
+  }
+  size_t digits = 1;
+  for (size_t n = number; n >= 10; n /= 10) {
+    digits++;
+  }
+  for (size_t i = digits, n = number; i > 0; i--, n /= 10) {
+    out.chars[length + i - 1] = static_cast<char>('0' + n % 10);
+  }
+  length += digits;
+  for (const char* p = suffix; *p != '\0'; p++) {
+    out.chars[length++] = *p;
+  }
+  out.chars[length] = '\0';
+  return out;
+}
+
+// The strings the web UI shows for each channel, numbered from 1.
+template <size_t N>
+struct ChannelNames {
+  // "/Control/Relay<n>/Value"
+  FixedString<24> config_path[N];
+  // "Relay <n> Configuration"
+  FixedString<24> title[N];
+  // "Control relay state for relay <n>"
+  FixedString<40> metadata_title[N];
+};
+
+template <size_t N>
+constexpr ChannelNames<N> make_channel_names() {
+  ChannelNames<N> names;
+  for (size_t i = 0; i < N; i++) {
+    names.config_path[i] =
+        numbered_string<24>("/Control/Relay", i + 1, "/Value");
+    names.title[i] = numbered_string<24>("Relay ", i + 1, " Configuration");
+    names.metadata_title[i] =
+        numbered_string<40>("Control relay state for relay ", i + 1, "");
+  }
+  return names;
+}
+
+// Signal K paths "<prefix><n><suffix>" numbered from 1, for tables too long
+// to write out by hand.
+template <size_t N>
+struct NumberedPaths {
+  FixedString<64> path[N];
+};
+
+template <size_t N>
+constexpr NumberedPaths<N> make_numbered_paths(const char* prefix,
+                                               const char* suffix) {
+  NumberedPaths<N> paths;
+  for (size_t i = 0; i < N; i++) {
+    paths.path[i] = numbered_string<64>(prefix, i + 1, suffix);
+  }
+  return paths;
+}
+
+template <size_t N>
+struct ChannelTable {
+  ChannelSpec specs[N];
+};
+
+// N channels on I2cExpanderBank pins, eight to a chip: channel i has its
+// relay on port A bit i % 8 of chip i / 8, its button on the same bit of
+// port B, and no LED. paths must be a constexpr variable, as the table
+// points into it.
+template <size_t N>
+constexpr ChannelTable<N> make_expander_table(const NumberedPaths<N>& paths) {
+  ChannelTable<N> table{};
+  for (size_t i = 0; i < N; i++) {
+    uint16_t relay = static_cast<uint16_t>(i / 8 * 16 + i % 8);
+    table.specs[i] = {{static_cast<uint16_t>(relay + 8), kNoPin, relay},
+                      paths.path[i].c_str()};
+  }
+  return table;
+}
+
+// N channels with their relays on outputs 0 to N - 1 of a 74HC595 chain
+// and no LEDs. The first channels get the GPIO buttons in buttons, the
+// rest are only switched remotely.
+template <size_t N, size_t B>
+constexpr ChannelTable<N> make_shift_register_table(
+    const NumberedPaths<N>& paths, const uint16_t (&buttons)[B]) {
+  ChannelTable<N> table{};
+  for (size_t i = 0; i < N; i++) {
+    table.specs[i] = {{i < B ? buttons[i] : kNoPin, kNoPin,
+                       static_cast<uint16_t>(i)},
+                      paths.path[i].c_str()};
+  }
+  return table;
+}
+
+// As make_shift_register_table(), with the button of channel i on key i of
+// a ButtonMatrix.
+template <size_t N>
+constexpr ChannelTable<N> make_shift_register_matrix_table(
+    const NumberedPaths<N>& paths) {
+  ChannelTable<N> table{};
+  for (size_t i = 0; i < N; i++) {
+    table.specs[i] = {{static_cast<uint16_t>(i), kNoPin,
+                       static_cast<uint16_t>(i)},
+                      paths.path[i].c_str()};
+  }
+  return table;
+}
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_CHANNEL_TABLE_H_
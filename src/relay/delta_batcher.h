@@ -0,0 +1,379 @@
+#ifndef RELAY_CONTROLLER_RELAY_DELTA_BATCHER_H_
+#define RELAY_CONTROLLER_RELAY_DELTA_BATCHER_H_
+
+// Publishes the state of every relay in one Signal K delta.
+//
+// Changes and heartbeats only mark their channel. Once the oldest mark is
+// window_us old, all marked paths go out together in a single message with
+// one updates[] entry, carrying each relay's state at that moment.
+//
+// The message is not built from scratch each time: a DeltaTemplate holds
+// every channel's entry, serialised in begin(), and only values and the
+// timestamp are patched. When every channel is due, as on a heartbeat,
+// the template itself is sent.
+//
+// The marks double as the outbox while the sink is offline: however many
+// changes and heartbeats a channel sees, it stays one bit, and its value
+// is read when the delta is built, so the latest one wins. Once the sink
+// is connected again every channel is sent in one delta, as the server
+// may have missed anything, and the usual cadence carries on from there.
+//
+// With a PublishLimiter, a channel out of tokens is held back when its
+// delta goes out and joins the first flush after its next token, with
+// whatever state it has by then. The limiter's flapping notices go out as
+// Signal K notifications on notifications.<path>.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/channel_set.h"
+#include "relay/delta_sink.h"
+#include "relay/delta_template.h"
+#include "relay/hal.h"
+#include "relay/json_writer.h"
+#include "relay/publish_limiter.h"
+#include "relay/relay_bank.h"
+#include "relay/sk_timestamp.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+// Told which channels each delta carried, e.g. to time relay-to-delta.
+template <size_t N>
+class DeltaSentObserver {
+ public:
+  virtual ~DeltaSentObserver() = default;
+  virtual void on_delta_sent(const ChannelSet<N>& channels,
+                             uint64_t sent_us) = 0;
+};
+
+template <size_t N, size_t BufferSize = 1024>
+class DeltaBatcher : public RelayObserver {
+ public:
+  DeltaBatcher(RelayBank<N>* bank, DeltaSink* sink, uint32_t window_us)
+      : bank_(bank), sink_(sink), window_us_(window_us) {}
+
+  // Publish channel on path instead of the bank's default sk_path. path must
+  // outlive the batcher.
+  void set_path(size_t channel, const char* path) { paths_[channel] = path; }
+
+  void set_sent_observer(DeltaSentObserver<N>* observer) {
+    sent_observer_ = observer;
+  }
+
+  // Rate-limit every channel, see PublishLimiter.
+  void set_limiter(PublishLimiter<N>* limiter) { limiter_ = limiter; }
+
+  void begin() {
+    for (size_t i = 0; i < N; i++) {
+      if (paths_[i] == nullptr) {
+        paths_[i] = bank_->channel(i).sk_path();
+      }
+    }
+    // Paths too long for one message are written out on every flush.
+    template_.begin(paths_);
+    bank_->add_observer(this);
+  }
+
+  void on_relay_event(const RelayEvent& event) override {
+    if (held_.test(event.channel.index())) {
+      coalesced_++;
+      if (event.stamp_us > held_stamp_us_) {
+        held_stamp_us_ = event.stamp_us;
+      }
+      return;
+    }
+    if (pending_.test(event.channel.index())) {
+      coalesced_++;
+    }
+    if (!pending_.any()) {
+      first_pending_us_ = hal::now_us();
+      newest_stamp_us_ = event.stamp_us;
+    } else if (event.stamp_us > newest_stamp_us_) {
+      newest_stamp_us_ = event.stamp_us;
+    }
+    pending_.set(event.channel.index());
+  }
+
+  // Flush if the window has passed or held channels are due, or replay
+  // everything once the sink is back. Call once per event loop tick.
+  void tick() {
+    uint64_t now = hal::now_us();
+    if (offline_) {
+      if (now - failed_us_ >= window_us_ && sink_->connected()) {
+        replay();
+      }
+      return;
+    }
+    if (limiter_ != nullptr) {
+      limiter_->tick(now);
+      send_notices();
+      if (held_.any() && now >= release_us_) {
+        release_held();
+        flush();
+        return;
+      }
+    }
+    if (pending_.any() && now - first_pending_us_ >= window_us_) {
+      flush();
+    }
+  }
+
+  // Send every marked channel now, but for those the limiter holds back.
+  // If the sink is not connected, they stay marked until it is.
+  void flush() {
+    if (!pending_.any()) {
+      return;
+    }
+    if (!sink_->connected()) {
+      go_offline(pending_.count());
+      return;
+    }
+    if (limiter_ != nullptr) {
+      hold_back();
+    }
+    send_pending();
+  }
+
+  uint32_t deltas_sent() const { return deltas_sent_; }
+  uint32_t values_sent() const { return values_sent_; }
+  // Changes and heartbeats folded into a channel that was already marked
+  // or held back.
+  uint32_t coalesced() const { return coalesced_; }
+  // Times a channel was held back for want of a token.
+  uint32_t held_back() const { return held_back_; }
+  uint32_t notifications_sent() const { return notifications_sent_; }
+  // Reconnections after which the full state was sent.
+  uint32_t replays() const { return replays_; }
+  bool online() const { return !offline_; }
+
+ private:
+  static constexpr const char* kClose = "]}]}";
+  static constexpr size_t kCloseLength = 4;
+
+  void send_pending() {
+    if (!pending_.any()) {
+      return;
+    }
+    if (template_.ok() && pending_.count() == N) {
+      pending_.for_each([&](size_t channel) {
+        template_.set_value(channel, bank_->state(channel));
+      });
+      size_t length;
+      const char* json = template_.message(newest_stamp_us_, &length);
+      send(json, length, pending_, N);
+      return;
+    }
+    ChannelSet<N> remaining = pending_;
+    while (remaining.any()) {
+      ChannelSet<N> sent;
+      JsonWriter writer(buffer_, BufferSize);
+      begin_delta(&writer);
+      size_t values = 0;
+      remaining.for_each([&](size_t channel) {
+        size_t mark = writer.length();
+        if (values > 0) {
+          writer.raw(",");
+        }
+        append_value(&writer, channel);
+        // Leave room to close the message; the rest goes in the next one.
+        if (!writer.ok() || writer.length() + kCloseLength >= BufferSize) {
+          writer.truncate(mark);
+          return;
+        }
+        sent.set(channel);
+        values++;
+      });
+      if (values == 0) {
+        // A single path longer than the buffer can never be sent.
+        remaining.for_each([&](size_t channel) { pending_.reset(channel); });
+        return;
+      }
+      writer.raw(kClose);
+      if (!send(writer.c_str(), writer.length(), sent, values)) {
+        return;
+      }
+      sent.for_each([&](size_t channel) { remaining.reset(channel); });
+    }
+  }
+
+  // Move the channels that are out of tokens from pending to held.
+  void hold_back() {
+    uint64_t now = hal::now_us();
+    pending_.for_each([&](size_t channel) {
+      if (!limiter_->take(channel, now)) {
+        pending_.reset(channel);
+        held_.set(channel);
+        held_back_++;
+      }
+    });
+    if (!held_.any()) {
+      return;
+    }
+    if (newest_stamp_us_ > held_stamp_us_) {
+      held_stamp_us_ = newest_stamp_us_;
+    }
+    release_us_ = UINT64_MAX;
+    held_.for_each([&](size_t channel) {
+      uint64_t due = limiter_->next_token_us(channel);
+      release_us_ = due < release_us_ ? due : release_us_;
+    });
+  }
+
+  void release_held() {
+    if (!pending_.any() || held_stamp_us_ > newest_stamp_us_) {
+      newest_stamp_us_ = held_stamp_us_;
+    }
+    if (!pending_.any()) {
+      first_pending_us_ = hal::now_us();
+    }
+    pending_ |= held_;
+    held_.clear();
+    held_stamp_us_ = 0;
+  }
+
+  // One Signal K notification per channel that started or stopped
+  // flapping.
+  void send_notices() {
+    if (!limiter_->notices().any() || !sink_->connected()) {
+      return;
+    }
+    limiter_->notices().for_each([&](size_t channel) {
+      JsonWriter writer(buffer_, BufferSize);
+      writer.raw("{\"updates\":[{\"values\":[{\"path\":\"notifications.")
+          .escaped(paths_[channel])
+          .raw("\",\"value\":");
+      if (limiter_->flapping(channel)) {
+        writer.raw("{\"state\":\"warn\",\"method\":[\"visual\"],")
+            .raw("\"message\":\"Relay flapping: over ")
+            .unsigned_integer(limiter_->flap_changes())
+            .raw(" changes in ")
+            .unsigned_integer(limiter_->flap_window_us() / 1000000)
+            .raw(" s, state published every ")
+            .seconds(limiter_->interval_us())
+            .raw(" s at most\"}");
+      } else {
+        writer.raw("{\"state\":\"normal\",\"method\":[],")
+            .raw("\"message\":\"Relay steady\"}");
+      }
+      writer.raw("}]}]}");
+      if (!writer.ok()) {
+        limiter_->clear_notice(channel);
+        return;
+      }
+      if (sink_->send_delta(writer.c_str(), writer.length())) {
+        limiter_->clear_notice(channel);
+        notifications_sent_++;
+      }
+    });
+  }
+
+  void begin_delta(JsonWriter* writer) {
+    if (template_.ok()) {
+      size_t length;
+      const char* header = template_.header(newest_stamp_us_, &length);
+      writer->raw(header, length);
+      return;
+    }
+    char timestamp[kSKTimestampSize];
+    writer->raw("{\"updates\":[{");
+    if (format_sk_timestamp(newest_stamp_us_, timestamp, sizeof(timestamp))) {
+      writer->raw("\"timestamp\":\"").raw(timestamp).raw("\",");
+    }
+    writer->raw("\"values\":[");
+  }
+
+  void append_value(JsonWriter* writer, size_t channel) {
+    bool on = bank_->state(channel);
+    if (template_.ok()) {
+      template_.set_value(channel, on);
+      size_t length;
+      const char* entry = template_.entry(channel, &length);
+      writer->raw(entry, length);
+      return;
+    }
+    writer->raw("{\"path\":")
+        .string(paths_[channel])
+        .raw(",\"value\":")
+        .boolean(on)
+        .raw("}");
+  }
+
+  // Hand one message to the sink and unmark the channels it carried.
+  bool send(const char* json, size_t length, const ChannelSet<N>& sent,
+            size_t values) {
+    if (!sink_->send_delta(json, length)) {
+      go_offline(values);
+      return false;
+    }
+    RELAY_TRACE(kDeltaSent, values, length);
+    deltas_sent_++;
+    values_sent_ += values;
+    if (sent_observer_ != nullptr) {
+      sent_observer_->on_delta_sent(sent, hal::now_us());
+    }
+    sent.for_each([&](size_t channel) { pending_.reset(channel); });
+    return true;
+  }
+
+  void go_offline(size_t values) {
+    RELAY_TRACE(kDeltaFailed, values);
+    failed_us_ = hal::now_us();
+    if (!offline_) {
+      offline_ = true;
+      offline_since_us_ = failed_us_;
+    }
+  }
+
+  // Send the state of every channel as it is now, held back or not.
+  void replay() {
+    for (size_t i = 0; i < N; i++) {
+      pending_.set(i);
+    }
+    held_.clear();
+    held_stamp_us_ = 0;
+    uint64_t now = hal::now_us();
+    newest_stamp_us_ = now;
+    offline_ = false;
+    if (!sink_->connected()) {
+      go_offline(N);
+      return;
+    }
+    send_pending();
+    if (!offline_) {
+      replays_++;
+      RELAY_TRACE(kDeltaReplay, N, (now - offline_since_us_) / 1000);
+    }
+  }
+
+  RelayBank<N>* bank_;
+  DeltaSink* sink_;
+  DeltaSentObserver<N>* sent_observer_ = nullptr;
+  PublishLimiter<N>* limiter_ = nullptr;
+  uint32_t window_us_;
+  const char* paths_[N] = {};
+  ChannelSet<N> pending_;
+  uint64_t first_pending_us_ = 0;
+  // The update carries the time of the most recent change it reports.
+  uint64_t newest_stamp_us_ = 0;
+  uint32_t deltas_sent_ = 0;
+  uint32_t values_sent_ = 0;
+  uint32_t coalesced_ = 0;
+  uint32_t replays_ = 0;
+  uint32_t held_back_ = 0;
+  uint32_t notifications_sent_ = 0;
+  // Channels waiting for a token, when the first one gets it, and the
+  // newest change among them.
+  ChannelSet<N> held_;
+  uint64_t release_us_ = 0;
+  uint64_t held_stamp_us_ = 0;
+  bool offline_ = false;
+  uint64_t offline_since_us_ = 0;
+  uint64_t failed_us_ = 0;
+  DeltaTemplate<N, BufferSize> template_;
+  char buffer_[BufferSize];
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_DELTA_BATCHER_H_
@@ -0,0 +1,23 @@
+#ifndef RELAY_CONTROLLER_RELAY_DELTA_SINK_H_
+#define RELAY_CONTROLLER_RELAY_DELTA_SINK_H_
+
+#include <cstddef>
+
+namespace relay_controller {
+
+// Where finished delta messages go: the websocket on the device, the
+// simulated server on the host.
+class DeltaSink {
+ public:
+  virtual ~DeltaSink() = default;
+  // Send one complete delta. Returns false if it could not be sent.
+  virtual bool send_delta(const char* json, size_t length) = 0;
+
+  // Whether send_delta() can get through right now. Asked on every tick
+  // while offline, so it must be cheap.
+  virtual bool connected() { return true; }
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_DELTA_SINK_H_
@@ -0,0 +1,124 @@
+#ifndef RELAY_CONTROLLER_RELAY_DELTA_TEMPLATE_H_
+#define RELAY_CONTROLLER_RELAY_DELTA_TEMPLATE_H_
+
+// A Signal K delta with the value of every channel of a bank, serialised
+// once.
+//
+// begin() escapes the paths and writes the whole message. From then on a
+// value is five bytes patched in place, "true " or "false", and the
+// timestamp 24 bytes. The header ends where the values start, so the delta
+// without a timestamp, sent while the clock is not set, is a suffix of the
+// same text. Publishing every channel formats nothing, and a delta for
+// some of them is copied together from their entries.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "relay/json_writer.h"
+#include "relay/sk_timestamp.h"
+
+namespace relay_controller {
+
+template <size_t N, size_t Size>
+class DeltaTemplate {
+ public:
+  // Serialise the delta for paths[0] to paths[N - 1]. Returns false if it
+  // does not fit in Size bytes.
+  bool begin(const char* const* paths) {
+    JsonWriter writer(text_, Size);
+    writer.raw(kStampedHeader);
+    for (size_t i = 0; i < N; i++) {
+      if (i > 0) {
+        writer.raw(",", 1);
+      }
+      entry_[i] = static_cast<uint32_t>(writer.length());
+      writer.raw("{\"path\":").string(paths[i]).raw(",\"value\":");
+      value_[i] = static_cast<uint32_t>(writer.length());
+      writer.raw("false}");
+    }
+    writer.raw(kClose);
+    length_ = writer.length();
+    ok_ = writer.ok();
+    return ok_;
+  }
+
+  bool ok() const { return ok_; }
+
+  void set_value(size_t channel, bool on) {
+    memcpy(text_ + value_[channel], on ? "true " : "false", kValueLength);
+  }
+
+  // The entry of channel, {"path":...,"value":...}, with its current value.
+  const char* entry(size_t channel, size_t* length) const {
+    *length = value_[channel] + kValueLength + 1 - entry_[channel];
+    return text_ + entry_[channel];
+  }
+
+  // The start of the delta up to the first value, stamped with stamp_us.
+  const char* header(uint64_t stamp_us, size_t* length) {
+    size_t start = stamp(stamp_us);
+    *length = kHeaderLength - start;
+    return text_ + start;
+  }
+
+  // The delta with every channel, stamped with stamp_us.
+  const char* message(uint64_t stamp_us, size_t* length) {
+    size_t start = stamp(stamp_us);
+    *length = length_ - start;
+    return text_ + start;
+  }
+
+ private:
+  static constexpr char kStampedHeader[] =
+      "{\"updates\":[{\"timestamp\":\"0000-00-00T00:00:00.000Z\","
+      "\"values\":[";
+  static constexpr char kPlainHeader[] = "{\"updates\":[{\"values\":[";
+  static constexpr char kClose[] = "]}]}";
+  static constexpr size_t kHeaderLength = sizeof(kStampedHeader) - 1;
+  static constexpr size_t kPlainLength = sizeof(kPlainHeader) - 1;
+  static constexpr size_t kTimestampOffset =
+      sizeof("{\"updates\":[{\"timestamp\":\"") - 1;
+  static constexpr size_t kValueLength = 5;
+
+  // Write the timestamp, or the header without one, and return where the
+  // delta starts. Within the same second only the milliseconds change.
+  size_t stamp(uint64_t stamp_us) {
+    uint64_t wall_us = sk_wall_time_us(stamp_us);
+    if (wall_us == 0) {
+      memcpy(text_ + kHeaderLength - kPlainLength, kPlainHeader,
+             kPlainLength);
+      stamped_second_ = 0;
+      return kHeaderLength - kPlainLength;
+    }
+    uint64_t second = wall_us / 1000000;
+    if (second != stamped_second_) {
+      char timestamp[kSKTimestampSize];
+      format_sk_wall_time(wall_us, timestamp);
+      memcpy(text_, kStampedHeader, kHeaderLength);
+      memcpy(text_ + kTimestampOffset, timestamp, kSKTimestampSize - 1);
+      stamped_second_ = second;
+    } else {
+      // "...T12:34:56.789Z": the three digits before the Z.
+      char* millis = text_ + kTimestampOffset + kSKTimestampSize - 5;
+      uint32_t ms = wall_us / 1000 % 1000;
+      millis[0] = static_cast<char>('0' + ms / 100);
+      millis[1] = static_cast<char>('0' + ms / 10 % 10);
+      millis[2] = static_cast<char>('0' + ms % 10);
+    }
+    return 0;
+  }
+
+  char text_[Size];
+  size_t length_ = 0;
+  bool ok_ = false;
+  // The second the timestamp in text_ is in, or 0 if it has none.
+  uint64_t stamped_second_ = 0;
+  // Offsets of each channel's entry and of its value in text_.
+  uint32_t entry_[N] = {};
+  uint32_t value_[N] = {};
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_DELTA_TEMPLATE_H_
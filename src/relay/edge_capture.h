@@ -0,0 +1,79 @@
+#ifndef RELAY_CONTROLLER_RELAY_EDGE_CAPTURE_H_
+#define RELAY_CONTROLLER_RELAY_EDGE_CAPTURE_H_
+
+// Interrupt-driven button capture.
+//
+// A GPIO interrupt stamps every button edge with the time it happened and
+// pushes it into a lock-free ring. The event loop drains the ring into the
+// bank or a BankDebouncer. A press made while the loop is stuck in a WiFi
+// reconnect or an OTA write is acted on once the loop runs again, but
+// keeps the time it happened, and one that started and ended during the
+// stall is still found in its edges. Only a ring overflow loses edges.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/hal.h"
+#include "relay/relay_bank.h"
+#include "relay/spsc_ring.h"
+
+namespace relay_controller {
+
+struct ButtonEdge {
+  uint64_t stamp_us;
+  uint16_t channel;
+  bool level;
+};
+
+template <size_t N, size_t RingSize = 64>
+class EdgeCapture {
+ public:
+  // Attach an edge interrupt to the button of every channel in bank.
+  void begin(const RelayBank<N>& bank) {
+    for (size_t i = 0; i < N; i++) {
+      contexts_[i] = {this, static_cast<uint16_t>(i),
+                      bank.channel(i).pins().button};
+      if (contexts_[i].pin == kNoPin) {
+        continue;
+      }
+      hal::attach_edge_interrupt(contexts_[i].pin, &EdgeCapture::on_edge,
+                                 &contexts_[i]);
+    }
+  }
+
+  // Hand every captured edge, oldest first, to sink->handle_button(). The
+  // sink is the bank itself or a debouncer in front of it.
+  template <typename Sink>
+  void drain(Sink* sink) {
+    ButtonEdge edge;
+    while (ring_.pop(&edge)) {
+      sink->handle_button(edge.channel, edge.level, edge.stamp_us);
+    }
+  }
+
+  uint32_t overflows() const { return ring_.overflows(); }
+  uint32_t high_water() const { return ring_.high_water(); }
+
+ private:
+  struct Context {
+    EdgeCapture* capture;
+    uint16_t channel;
+    uint16_t pin;
+  };
+
+  // All GPIO handlers are dispatched from the one GPIO interrupt, so they
+  // never run concurrently and together form the ring's single producer.
+  static void RELAY_ISR_ATTR on_edge(void* arg) {
+    auto* context = static_cast<Context*>(arg);
+    ButtonEdge edge{hal::isr_now_us(), context->channel,
+                    hal::isr_read_pin(context->pin)};
+    context->capture->ring_.push(edge);
+  }
+
+  SpscRing<ButtonEdge, RingSize> ring_;
+  Context contexts_[N];
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_EDGE_CAPTURE_H_
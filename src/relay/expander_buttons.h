@@ -0,0 +1,178 @@
+#ifndef RELAY_CONTROLLER_RELAY_EXPANDER_BUTTONS_H_
+#define RELAY_CONTROLLER_RELAY_EXPANDER_BUTTONS_H_
+
+// Buttons on an I2cExpanderBank, read only when the expanders' shared
+// interrupt line says something changed.
+//
+// The interrupt stamps the first edge; the event loop then samples every
+// sample period and debounces with the same vertical counters as
+// BankDebouncer until every button has settled, and goes back to leaving
+// the bus alone. An idle bank costs no I2C traffic at all.
+//
+// A sample reads only the chips whose buttons are still settling, and the
+// others one by one while the interrupt line stays low. Reading a chip
+// clears its interrupt, so once the line is high every chip not read has
+// the levels it had when last read. A press thus costs about half the
+// chips to find it, then one read per sample.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/bank_debouncer.h"
+#include "relay/hal.h"
+#include "relay/i2c_expander.h"
+#include "relay/relay_bank.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class ExpanderButtons {
+ public:
+  static constexpr size_t kWords = I2cExpanderBank::kPinWords;
+
+  // Follow the buttons of bank, which are pins of expander, whose open-drain
+  // interrupt output is wired to interrupt_pin. Call after bank.begin().
+  void begin(const RelayBank<N>& bank, I2cExpanderBank* expander,
+             int interrupt_pin, uint32_t debounce_ms,
+             uint32_t sample_period_us = 2000) {
+    expander_ = expander;
+    interrupt_pin_ = interrupt_pin;
+    sample_period_us_ = sample_period_us;
+    uint32_t samples =
+        sample_period_us == 0
+            ? 1
+            : (debounce_ms * 1000 + sample_period_us - 1) / sample_period_us;
+    if (samples < 1) {
+      samples = 1;
+    } else if (samples > VerticalCounterWord::kMaxSamples) {
+      samples = VerticalCounterWord::kMaxSamples;
+    }
+    for (size_t i = 0; i < N; i++) {
+      uint16_t pin = bank.channel(i).pins().button;
+      if (pin == kNoPin) {
+        continue;
+      }
+      channel_of_pin_[pin] = static_cast<uint8_t>(i);
+      button_mask_[pin / 64] |= uint64_t{1} << (pin % 64);
+      words_[pin / 64].set_limit(pin % 64, samples);
+    }
+    expander_->read_inputs(levels_);
+    for (size_t w = 0; w < kWords; w++) {
+      words_[w].reset(levels_[w] & button_mask_[w]);
+    }
+    hal::configure_input_pullup(interrupt_pin);
+    hal::attach_edge_interrupt(interrupt_pin, &ExpanderButtons::on_interrupt,
+                               this);
+  }
+
+  // Read and debounce the buttons if the interrupt fired or they are still
+  // settling, and hand clean levels to sink->handle_button(), stamped with
+  // the interrupt that started it.
+  template <typename Sink>
+  void tick(Sink* sink) {
+    uint64_t now = hal::now_us();
+    if (!active_) {
+      // The line stays low until the chips are read, so a level check also
+      // catches an edge that came before the handler was attached.
+      bool fired = interrupted_.exchange(false, std::memory_order_acquire);
+      if (!fired && hal::read_pin(interrupt_pin_)) {
+        return;
+      }
+      active_ = true;
+      episode_us_ = fired ? interrupt_us_ : now;
+      next_sample_us_ = now;
+    }
+    if (static_cast<int64_t>(now - next_sample_us_) < 0) {
+      return;
+    }
+    next_sample_us_ = now + sample_period_us_;
+
+    if (!read_changed_chips()) {
+      return;
+    }
+    bool settled = true;
+    for (size_t w = 0; w < kWords; w++) {
+      uint64_t buttons = levels_[w] & button_mask_[w];
+      uint64_t flipped = words_[w].update(buttons);
+      while (flipped != 0) {
+        unsigned bit = __builtin_ctzll(flipped);
+        flipped &= flipped - 1;
+        sink->handle_button(channel_of_pin_[w * 64 + bit],
+                            (words_[w].stable() >> bit) & 1, episode_us_);
+      }
+      settled &= buttons == words_[w].stable();
+    }
+    if (settled) {
+      active_ = false;
+      interrupted_.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  // Chip reads so far, one transaction each.
+  uint32_t reads() const { return reads_; }
+
+ private:
+  // Bring levels_ up to date: the chips with buttons still settling first,
+  // then the others in turn until the interrupt line goes high. Returns
+  // false on a bus error.
+  bool read_changed_chips() {
+    uint64_t settling[kWords];
+    for (size_t w = 0; w < kWords; w++) {
+      settling[w] = (levels_[w] ^ words_[w].stable()) & button_mask_[w];
+    }
+    uint32_t read = 0;
+    bool ok = true;
+    for (size_t c = 0; c < expander_->chip_count(); c++) {
+      size_t first_pin = c * I2cExpanderBank::kPinsPerChip;
+      if (static_cast<uint16_t>(settling[first_pin / 64] >>
+                                (first_pin % 64)) != 0) {
+        ok &= read_chip(c);
+        read |= 1u << c;
+      }
+    }
+    for (size_t c = 0; c < expander_->chip_count(); c++) {
+      if (hal::read_pin(interrupt_pin_)) {
+        break;
+      }
+      if ((read >> c & 1) == 0 && expander_->has_inputs(c)) {
+        ok &= read_chip(c);
+      }
+    }
+    return ok;
+  }
+
+  bool read_chip(size_t chip) {
+    reads_++;
+    return expander_->read_chip_inputs(chip, levels_);
+  }
+
+  static void RELAY_ISR_ATTR on_interrupt(void* arg) {
+    auto* self = static_cast<ExpanderButtons*>(arg);
+    // Active low; only the falling edge starts an episode.
+    if (!hal::isr_read_pin(self->interrupt_pin_) &&
+        !self->interrupted_.load(std::memory_order_relaxed)) {
+      self->interrupt_us_ = hal::isr_now_us();
+      self->interrupted_.store(true, std::memory_order_release);
+    }
+  }
+
+  I2cExpanderBank* expander_ = nullptr;
+  int interrupt_pin_ = -1;
+  uint32_t sample_period_us_ = 2000;
+  VerticalCounterWord words_[kWords];
+  // Every chip's input levels as last read.
+  uint64_t levels_[kWords] = {};
+  uint64_t button_mask_[kWords] = {};
+  uint8_t channel_of_pin_[I2cExpanderBank::kMaxPins] = {};
+  std::atomic<bool> interrupted_{false};
+  volatile uint64_t interrupt_us_ = 0;
+  bool active_ = false;
+  uint64_t episode_us_ = 0;
+  uint64_t next_sample_us_ = 0;
+  uint32_t reads_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_EXPANDER_BUTTONS_H_
@@ -0,0 +1,52 @@
+#ifndef RELAY_CONTROLLER_RELAY_GPIO_BANK_OUTPUT_H_
+#define RELAY_CONTROLLER_RELAY_GPIO_BANK_OUTPUT_H_
+
+#include <cstdint>
+
+#include "relay/hal.h"
+#include "relay/output_stage.h"
+
+namespace relay_controller {
+
+// Output stage for relays and LEDs wired straight to GPIOs.
+//
+// Staged levels collect in set/clear masks that commit() hands to the
+// GPIO_OUT_W1TS/W1TC registers, so a whole bank switches with a single
+// store per register instead of one digitalWrite() per pin.
+class GpioBankOutput : public OutputStage {
+ public:
+  void configure(int pin) override { hal::configure_output(pin); }
+
+  void stage(int pin, bool level) override {
+    uint64_t bit = uint64_t{1} << (pin % 64);
+    if (level) {
+      set_[pin / 64] |= bit;
+      clear_[pin / 64] &= ~bit;
+    } else {
+      clear_[pin / 64] |= bit;
+      set_[pin / 64] &= ~bit;
+    }
+    staged_ = true;
+  }
+
+  void commit() override {
+    if (!staged_) {
+      return;
+    }
+    hal::write_outputs(set_, clear_);
+    for (size_t w = 0; w < hal::kPinWords; w++) {
+      set_[w] = 0;
+      clear_[w] = 0;
+    }
+    staged_ = false;
+  }
+
+ private:
+  uint64_t set_[hal::kPinWords] = {};
+  uint64_t clear_[hal::kPinWords] = {};
+  bool staged_ = false;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_GPIO_BANK_OUTPUT_H_
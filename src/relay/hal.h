@@ -0,0 +1,82 @@
+#ifndef RELAY_CONTROLLER_RELAY_HAL_H_
+#define RELAY_CONTROLLER_RELAY_HAL_H_
+
+// Hardware access used by the relay engine.
+//
+// Implemented by src/esp32/hal_esp32.cpp on the device and by
+// src/native/hal_native.cpp on the host.
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef ARDUINO
+#include <esp_attr.h>
+// Code that runs in interrupt context must stay callable while the flash
+// cache is disabled, e.g. during an OTA write.
+#define RELAY_ISR_ATTR IRAM_ATTR
+#else
+#define RELAY_ISR_ATTR
+#endif
+
+// For helpers called from interrupt handlers, so that they end up in the
+// handler's IRAM section rather than in flash.
+#define RELAY_ISR_INLINE inline __attribute__((always_inline))
+
+namespace relay_controller {
+namespace hal {
+
+// Pin masks are arrays of kPinWords words; bit n of word[n / 64] is pin n.
+#ifdef ARDUINO
+// GPIO_IN_REG/GPIO_OUT_REG and, on chips with more than 32 GPIOs, their
+// second register.
+constexpr size_t kPinWords = 1;
+#else
+// 768 simulated pins: buttons, relays and LEDs of the 256 channel benchmark.
+constexpr size_t kPinWords = 12;
+#endif
+
+// Microseconds since boot.
+uint64_t now_us();
+
+// Microseconds since the Unix epoch, or 0 while the clock is not set.
+uint64_t wall_time_us();
+
+void configure_output(int pin);
+void configure_input_pullup(int pin);
+// An output that only pulls low and floats when written high.
+void configure_open_drain(int pin);
+
+void write_pin(int pin, bool level);
+bool read_pin(int pin);
+
+// Sample the level of every GPIO at once.
+void read_inputs(uint64_t* words);
+
+// Drive the pins in set high and those in clear low with as few register
+// writes as the chip allows, so that they switch together.
+void write_outputs(const uint64_t* set, const uint64_t* clear);
+
+using IsrHandler = void (*)(void* arg);
+
+// Call handler from interrupt context on every edge of pin.
+void attach_edge_interrupt(int pin, IsrHandler handler, void* arg);
+
+// Interrupt-safe versions of now_us() and read_pin().
+uint64_t isr_now_us();
+bool isr_read_pin(int pin);
+
+// State of the general-purpose heap, in bytes. A largest free block well
+// below free_bytes means the heap is fragmented.
+struct HeapStats {
+  size_t free_bytes;
+  size_t largest_free_block;
+  // The lowest free_bytes has been since boot.
+  size_t minimum_free_bytes;
+};
+
+HeapStats heap_stats();
+
+}  // namespace hal
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_HAL_H_
@@ -0,0 +1,100 @@
+#ifndef RELAY_CONTROLLER_RELAY_HEARTBEAT_WHEEL_H_
+#define RELAY_CONTROLLER_RELAY_HEARTBEAT_WHEEL_H_
+
+// One heartbeat schedule for every channel of a bank.
+//
+// Heartbeats go out in batches at fixed multiples of the period, so all
+// channels refresh together and the event loop is woken once per period
+// instead of once per channel. Each channel's next batch lives in a small
+// timing wheel with one slot per upcoming batch. A channel that changes is
+// moved to the first batch at least one period away, which skips the
+// refresh its fresh value made redundant.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/channel_set.h"
+#include "relay/hal.h"
+#include "relay/relay_bank.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class HeartbeatWheel : public RelayObserver {
+ public:
+  // Same period as the Repeat<bool, bool>(10000) the graph used.
+  static constexpr uint64_t kDefaultPeriodUs = 10000000;
+
+  explicit HeartbeatWheel(RelayBank<N>* bank,
+                          uint64_t period_us = kDefaultPeriodUs)
+      : bank_(bank), period_us_(period_us) {}
+
+  // Schedule every channel for the next batch.
+  void begin() {
+    uint64_t now = hal::now_us();
+    next_batch_ = now / period_us_ + 1;
+    for (size_t i = 0; i < N; i++) {
+      schedule(i, next_batch_);
+    }
+    bank_->add_observer(this);
+  }
+
+  void on_relay_event(const RelayEvent& event) override {
+    if (event.source == ChangeSource::kHeartbeat) {
+      return;
+    }
+    // The first batch at least one period after the change.
+    uint64_t due = (hal::now_us() + period_us_ + period_us_ - 1) / period_us_;
+    schedule(event.channel.index(), due);
+  }
+
+  // Fire the batch if it is due. One comparison on all other ticks.
+  void tick() {
+    uint64_t now = hal::now_us();
+    if (now < next_batch_ * period_us_) {
+      return;
+    }
+    // Normally one batch is due; after a stall, take every one missed.
+    uint64_t current = now / period_us_;
+    ChannelSet<N> due;
+    for (uint64_t batch = next_batch_;
+         batch <= current && batch < next_batch_ + kSlots; batch++) {
+      due |= slots_[batch % kSlots];
+      slots_[batch % kSlots].clear();
+    }
+    next_batch_ = current + 1;
+    size_t count = 0;
+    due.for_each([&](size_t channel) {
+      schedule(channel, next_batch_);
+      bank_->refresh(channel, now);
+      count++;
+    });
+    RELAY_TRACE(kHeartbeat, count);
+    batches_fired_++;
+  }
+
+  uint32_t batches_fired() const { return batches_fired_; }
+
+ private:
+  // A change never pushes a channel more than two batches ahead, so four
+  // slots leave room for a batch that fires late.
+  static constexpr size_t kSlots = 4;
+
+  void schedule(size_t channel, uint64_t batch) {
+    slots_[slot_of_[channel]].reset(channel);
+    slot_of_[channel] = batch % kSlots;
+    slots_[slot_of_[channel]].set(channel);
+  }
+
+  RelayBank<N>* bank_;
+  uint64_t period_us_;
+  uint64_t next_batch_ = 0;
+  ChannelSet<N> slots_[kSlots];
+  uint8_t slot_of_[N] = {};
+  uint32_t batches_fired_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_HEARTBEAT_WHEEL_H_
@@ -0,0 +1,27 @@
+#ifndef RELAY_CONTROLLER_RELAY_I2C_BUS_H_
+#define RELAY_CONTROLLER_RELAY_I2C_BUS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace relay_controller {
+
+// An I2C master, Wire on the device and sim::SimI2cBus on the host. Every
+// call is one transaction.
+class I2cBus {
+ public:
+  virtual ~I2cBus() = default;
+
+  // Send data to address. Returns false if the device did not acknowledge.
+  virtual bool write(uint8_t address, const uint8_t* data, size_t length) = 0;
+
+  // Send out, unless out_length is 0, then read in_length bytes after a
+  // repeated start.
+  virtual bool write_read(uint8_t address, const uint8_t* out,
+                          size_t out_length, uint8_t* in,
+                          size_t in_length) = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_I2C_BUS_H_
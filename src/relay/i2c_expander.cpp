@@ -0,0 +1,185 @@
+#include "relay/i2c_expander.h"
+
+namespace relay_controller {
+
+namespace {
+
+// MCP23017 registers with IOCON.BANK = 0, port A first; sequential access
+// steps through A and B.
+constexpr uint8_t kIodir = 0x00;
+constexpr uint8_t kIocon = 0x0A;
+constexpr uint8_t kGpio = 0x12;
+constexpr uint8_t kOlat = 0x14;
+// INTA and INTB mirror each other and are open drain.
+constexpr uint8_t kIoconMirrorOpenDrain = 0x44;
+
+uint8_t low(uint16_t value) { return static_cast<uint8_t>(value); }
+uint8_t high(uint16_t value) { return static_cast<uint8_t>(value >> 8); }
+
+}  // namespace
+
+I2cExpanderBank::I2cExpanderBank(I2cBus* bus, Model model,
+                                 uint8_t first_address, size_t chips)
+    : bus_(bus),
+      model_(model),
+      first_address_(first_address),
+      chips_(chips < kMaxChips ? chips : kMaxChips) {}
+
+bool I2cExpanderBank::begin() {
+  bool ok = true;
+  for (size_t c = 0; c < chips_; c++) {
+    if (model_ == Model::kMcp23017) {
+      uint8_t burst[] = {kIocon, kIoconMirrorOpenDrain};
+      ok &= check(bus_->write(address(c), burst, sizeof(burst)));
+    } else {
+      uint8_t levels[2];
+      ok &= check(bus_->write_read(address(c), nullptr, 0, levels, 2));
+    }
+  }
+  return ok;
+}
+
+void I2cExpanderBank::configure(int pin) {
+  Chip& chip = chip_[pin / kPinsPerChip];
+  uint16_t bit = 1u << (pin % kPinsPerChip);
+  chip.outputs |= bit;
+  chip.inputs &= ~bit;
+  chip.output_config_dirty = true;
+}
+
+void I2cExpanderBank::stage(int pin, bool level) {
+  Chip& chip = chip_[pin / kPinsPerChip];
+  uint16_t bit = 1u << (pin % kPinsPerChip);
+  chip.staged = level ? chip.staged | bit : chip.staged & ~bit;
+}
+
+void I2cExpanderBank::configure_input(int pin) {
+  Chip& chip = chip_[pin / kPinsPerChip];
+  uint16_t bit = 1u << (pin % kPinsPerChip);
+  chip.inputs |= bit;
+  chip.outputs &= ~bit;
+  chip.input_config_dirty = true;
+  chip.levels_stale = true;
+}
+
+bool I2cExpanderBank::read_input(int pin) {
+  size_t c = pin / kPinsPerChip;
+  Chip& chip = chip_[c];
+  if (chip.input_config_dirty && write_config(c)) {
+    chip.input_config_dirty = false;
+  }
+  if (chip.levels_stale && read_levels(c)) {
+    chip.levels_stale = false;
+  }
+  return (chip.levels >> (pin % kPinsPerChip)) & 1;
+}
+
+void I2cExpanderBank::flush() {
+  for (size_t c = 0; c < chips_; c++) {
+    Chip& chip = chip_[c];
+    if (chip.output_config_dirty) {
+      // Latch the levels first, so that a pin turning into an output
+      // starts at its staged level.
+      if (write_outputs(c)) {
+        chip.applied_outputs = chip.outputs;
+        if (write_config(c)) {
+          chip.output_config_dirty = false;
+          chip.input_config_dirty = false;
+        }
+      }
+    } else if (((chip.staged ^ chip.written) & chip.outputs) != 0) {
+      // written only follows staged once a write is acknowledged, so a
+      // failed one is tried again on the next flush.
+      write_outputs(c);
+    }
+  }
+}
+
+bool I2cExpanderBank::read_inputs(uint64_t* words) {
+  for (size_t w = 0; w < kPinWords; w++) {
+    words[w] = 0;
+  }
+  bool ok = true;
+  for (size_t c = 0; c < chips_; c++) {
+    if (chip_[c].inputs == 0) {
+      continue;
+    }
+    ok &= read_chip_inputs(c, words);
+  }
+  return ok;
+}
+
+bool I2cExpanderBank::read_chip_inputs(size_t c, uint64_t* words) {
+  bool ok = read_levels(c);
+  size_t first_pin = c * kPinsPerChip;
+  uint64_t& word = words[first_pin / 64];
+  unsigned shift = first_pin % 64;
+  word = (word & ~(uint64_t{0xffff} << shift)) |
+         uint64_t{chip_[c].levels} << shift;
+  return ok;
+}
+
+bool I2cExpanderBank::write_outputs(size_t c) {
+  Chip& chip = chip_[c];
+  bool ok;
+  if (model_ == Model::kMcp23017) {
+    uint8_t burst[] = {kOlat, low(chip.staged), high(chip.staged)};
+    ok = bus_->write(address(c), burst, sizeof(burst));
+  } else {
+    // Everything that is not a driven output is latched high, which makes
+    // it an input.
+    uint16_t latch =
+        (chip.staged & chip.outputs) | static_cast<uint16_t>(~chip.outputs);
+    uint8_t burst[] = {low(latch), high(latch)};
+    ok = bus_->write(address(c), burst, sizeof(burst));
+  }
+  if (check(ok)) {
+    chip.written = chip.staged;
+  }
+  return ok;
+}
+
+bool I2cExpanderBank::write_config(size_t c) {
+  Chip& chip = chip_[c];
+  if (model_ == Model::kPcf8575) {
+    // Direction is only a matter of the latch, which write_outputs() sets.
+    // Inputs are latched high from power-on.
+    return true;
+  }
+  uint16_t direction = static_cast<uint16_t>(~chip.applied_outputs);
+  // IODIR, IPOL, GPINTEN, DEFVAL, INTCON, IOCON and GPPU in one burst:
+  // inputs get a pull-up and interrupt on any change.
+  uint8_t burst[] = {kIodir,
+                     low(direction),
+                     high(direction),
+                     0,
+                     0,
+                     low(chip.inputs),
+                     high(chip.inputs),
+                     0,
+                     0,
+                     0,
+                     0,
+                     kIoconMirrorOpenDrain,
+                     kIoconMirrorOpenDrain,
+                     low(chip.inputs),
+                     high(chip.inputs)};
+  return check(bus_->write(address(c), burst, sizeof(burst)));
+}
+
+bool I2cExpanderBank::read_levels(size_t c) {
+  uint8_t levels[2];
+  bool ok;
+  if (model_ == Model::kMcp23017) {
+    uint8_t reg = kGpio;
+    ok = bus_->write_read(address(c), &reg, 1, levels, 2);
+  } else {
+    ok = bus_->write_read(address(c), nullptr, 0, levels, 2);
+  }
+  if (check(ok)) {
+    chip_[c].levels = static_cast<uint16_t>(levels[0] | levels[1] << 8);
+  }
+  return ok;
+}
+
+}  // namespace relay_controller
@@ -0,0 +1,113 @@
+#ifndef RELAY_CONTROLLER_RELAY_I2C_EXPANDER_H_
+#define RELAY_CONTROLLER_RELAY_I2C_EXPANDER_H_
+
+// Relays, LEDs and buttons on 16-bit I2C GPIO expanders.
+//
+// Up to eight MCP23017 or PCF8575 chips at consecutive addresses give 128
+// pins, numbered chip * 16 + bit with port A (P0x) in bits 0-7. Output
+// changes are only staged by commit(); flush() writes every chip that has
+// changes in one burst, so all the relays switched in a tick cost one
+// transaction per chip. read_inputs() reads each chip in one transaction,
+// read_chip_inputs() just one of them.
+//
+// The chips keep their outputs through a reset of the ESP32, and begin()
+// writes the output latches before turning pins into outputs, so restored
+// relays do not glitch at boot.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/i2c_bus.h"
+#include "relay/input_stage.h"
+#include "relay/output_stage.h"
+
+namespace relay_controller {
+
+class I2cExpanderBank : public OutputStage, public InputStage {
+ public:
+  enum class Model : uint8_t {
+    // Registers, a pull-up and interrupt enable per pin.
+    kMcp23017,
+    // Quasi-bidirectional pins: an input is an output latched high.
+    kPcf8575,
+  };
+
+  static constexpr size_t kMaxChips = 8;
+  static constexpr size_t kPinsPerChip = 16;
+  static constexpr size_t kMaxPins = kMaxChips * kPinsPerChip;
+  static constexpr size_t kPinWords = (kMaxPins + 63) / 64;
+
+  I2cExpanderBank(I2cBus* bus, Model model, uint8_t first_address,
+                  size_t chips);
+
+  // Check that every chip answers and route the interrupt outputs of both
+  // ports to one open-drain line, so that all chips can share one GPIO.
+  // Returns false if a chip is missing.
+  bool begin();
+
+  void configure(int pin) override;
+  void stage(int pin, bool level) override;
+  // Nothing is written until flush().
+  void commit() override {}
+
+  void configure_input(int pin) override;
+  bool read_input(int pin) override;
+
+  // Write the staged outputs of every chip whose outputs differ from what it
+  // last acknowledged, one burst per chip, so a write the chip did not
+  // acknowledge is repeated. Call once per event loop tick, after the
+  // reactions that switch relays.
+  void flush();
+
+  // Read every chip's input levels, one transaction per chip, into words:
+  // bit n of words[n / 64] is pin n. Returns false on a bus error.
+  bool read_inputs(uint64_t* words);
+  // Read one chip's input levels, one transaction, into its bits of words,
+  // leaving the other chips' bits alone. Returns false on a bus error.
+  bool read_chip_inputs(size_t chip, uint64_t* words);
+
+  size_t chip_count() const { return chips_; }
+  bool has_inputs(size_t chip) const { return chip_[chip].inputs != 0; }
+  size_t pin_count() const { return chips_ * kPinsPerChip; }
+  uint32_t bus_errors() const { return bus_errors_; }
+
+ private:
+  struct Chip {
+    uint16_t outputs = 0;
+    uint16_t inputs = 0;
+    // The outputs the direction register has been written with.
+    uint16_t applied_outputs = 0;
+    uint16_t staged = 0;
+    // The levels the chip last acknowledged.
+    uint16_t written = 0;
+    uint16_t levels = 0xffff;
+    // configure() or configure_input() changed a pin since the last write.
+    bool output_config_dirty = false;
+    bool input_config_dirty = false;
+    bool levels_stale = true;
+  };
+
+  uint8_t address(size_t chip) const {
+    return static_cast<uint8_t>(first_address_ + chip);
+  }
+  bool write_outputs(size_t chip);
+  bool write_config(size_t chip);
+  bool read_levels(size_t chip);
+  bool check(bool ok) {
+    if (!ok) {
+      bus_errors_++;
+    }
+    return ok;
+  }
+
+  I2cBus* bus_;
+  Model model_;
+  uint8_t first_address_;
+  size_t chips_;
+  Chip chip_[kMaxChips];
+  uint32_t bus_errors_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_I2C_EXPANDER_H_
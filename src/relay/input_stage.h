@@ -0,0 +1,20 @@
+#ifndef RELAY_CONTROLLER_RELAY_INPUT_STAGE_H_
+#define RELAY_CONTROLLER_RELAY_INPUT_STAGE_H_
+
+namespace relay_controller {
+
+// Reads the button pins of a RelayBank when it begins. Buttons are then
+// followed by a capture front end, EdgeCapture and BankDebouncer for GPIOs,
+// ExpanderButtons for an I2C expander or MatrixButtons for a ButtonMatrix.
+class InputStage {
+ public:
+  virtual ~InputStage() = default;
+
+  // Make pin an input with a pull-up.
+  virtual void configure_input(int pin) = 0;
+  virtual bool read_input(int pin) = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_INPUT_STAGE_H_
@@ -0,0 +1,27 @@
+#ifndef RELAY_CONTROLLER_RELAY_JOURNAL_FLASH_H_
+#define RELAY_CONTROLLER_RELAY_JOURNAL_FLASH_H_
+
+#include <cstddef>
+
+namespace relay_controller {
+
+// A region of NOR flash as a StateJournal sees it: erased bytes read 0xff,
+// writes can only clear bits, and erasing works a whole sector at a time.
+//
+// Implemented on a data partition on the device and by sim::SimFlash on
+// the host.
+class JournalFlash {
+ public:
+  virtual ~JournalFlash() = default;
+
+  virtual size_t sector_size() const = 0;
+  virtual size_t sector_count() const = 0;
+
+  virtual bool read(size_t offset, void* data, size_t length) = 0;
+  virtual bool write(size_t offset, const void* data, size_t length) = 0;
+  virtual bool erase_sector(size_t sector) = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_JOURNAL_FLASH_H_
@@ -0,0 +1,105 @@
+#ifndef RELAY_CONTROLLER_RELAY_JSON_WRITER_H_
+#define RELAY_CONTROLLER_RELAY_JSON_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace relay_controller {
+
+// Appends JSON text to a caller-owned buffer without allocating.
+//
+// Once something does not fit, the writer stays failed and every further
+// append is ignored; check ok() before using the text.
+class JsonWriter {
+ public:
+  JsonWriter(char* buffer, size_t size) : buffer_(buffer), size_(size) {
+    terminate();
+  }
+
+  // Append text as is.
+  JsonWriter& raw(const char* text) { return raw(text, strlen(text)); }
+  JsonWriter& raw(const char* text, size_t length) {
+    if (ok_ && length_ + length < size_) {
+      memcpy(buffer_ + length_, text, length);
+      length_ += length;
+    } else {
+      ok_ = false;
+    }
+    terminate();
+    return *this;
+  }
+
+  // Append text as a quoted JSON string.
+  JsonWriter& string(const char* text) {
+    return raw("\"", 1).escaped(text).raw("\"", 1);
+  }
+
+  // Append text escaped for use inside a JSON string, without the quotes.
+  JsonWriter& escaped(const char* text) {
+    for (const char* p = text; *p != '\0'; p++) {
+      if (*p == '"' || *p == '\\') {
+        raw("\\", 1);
+      }
+      raw(p, 1);
+    }
+    return *this;
+  }
+
+  JsonWriter& boolean(bool value) {
+    return value ? raw("true", 4) : raw("false", 5);
+  }
+
+  JsonWriter& unsigned_integer(uint64_t value) {
+    char digits[20];
+    size_t count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    while (count > 0) {
+      raw(&digits[--count], 1);
+    }
+    return *this;
+  }
+
+  // Append a duration in microseconds as seconds, the Signal K unit.
+  JsonWriter& seconds(uint64_t us) {
+    unsigned_integer(us / 1000000).raw(".", 1);
+    uint32_t fraction = us % 1000000;
+    for (uint32_t scale = 100000; scale > 0; scale /= 10) {
+      char digit = static_cast<char>('0' + fraction / scale % 10);
+      raw(&digit, 1);
+    }
+    return *this;
+  }
+
+  // Drop everything after length, e.g. to back out a partial value.
+  void truncate(size_t length) {
+    if (length <= length_) {
+      length_ = length;
+      ok_ = true;
+      terminate();
+    }
+  }
+
+  bool ok() const { return ok_; }
+  size_t length() const { return length_; }
+  const char* c_str() const { return buffer_; }
+
+ private:
+  void terminate() {
+    if (size_ > 0) {
+      buffer_[length_] = '\0';
+    }
+  }
+
+  char* buffer_;
+  size_t size_;
+  size_t length_ = 0;
+  bool ok_ = true;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_JSON_WRITER_H_
@@ -0,0 +1,119 @@
+#ifndef RELAY_CONTROLLER_RELAY_LATENCY_HISTOGRAM_H_
+#define RELAY_CONTROLLER_RELAY_LATENCY_HISTOGRAM_H_
+
+// Fixed-bucket, log-scale latency histogram.
+//
+// Each power of two is split into four buckets, so a percentile read back
+// from the histogram is within 25% of the true value, while 100 buckets
+// cover 0 us to 67 s. Recording a sample is a count-leading-zeros and an
+// increment; nothing allocates.
+//
+// Buckets count in 16 bits, 212 bytes per histogram. When one would
+// overflow, every bucket is halved, so the percentiles decay: they keep
+// their shape, and older samples weigh half as much as newer ones after
+// each halving. count() and max_us() are not decayed; count() is every
+// sample ever recorded, in 32 bits.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace relay_controller {
+
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 2;
+  static constexpr uint32_t kSubBuckets = 1 << kSubBucketBits;
+  // Samples at or above 2^kRangeBits us land in the last bucket.
+  static constexpr int kRangeBits = 26;
+  static constexpr size_t kBuckets =
+      (kRangeBits - kSubBucketBits + 1) * kSubBuckets;
+
+  void record(uint64_t us) {
+    uint32_t value = us >= kLimit ? kLimit - 1 : static_cast<uint32_t>(us);
+    size_t bucket = bucket_of(value);
+    if (counts_[bucket] == UINT16_MAX) {
+      halve();
+    }
+    counts_[bucket]++;
+    weight_++;
+    recorded_++;
+    if (value > max_us_) {
+      max_us_ = value;
+    }
+  }
+
+  // Nearest-rank percentile, p in [0, 100], as the upper bound of the
+  // bucket it falls in. 0 if nothing has been recorded.
+  uint32_t percentile(uint32_t p) const {
+    if (weight_ == 0) {
+      return 0;
+    }
+    uint64_t rank = (static_cast<uint64_t>(weight_) * p + 99) / 100;
+    if (rank == 0) {
+      rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        uint32_t upper = upper_bound(i);
+        return upper < max_us_ ? upper : max_us_;
+      }
+    }
+    return max_us_;
+  }
+
+  // Samples recorded since the last clear(), halved or not.
+  uint32_t count() const { return recorded_; }
+  uint32_t max_us() const { return max_us_; }
+  uint32_t bucket_count(size_t bucket) const { return counts_[bucket]; }
+
+  void clear() {
+    for (auto& count : counts_) {
+      count = 0;
+    }
+    weight_ = 0;
+    recorded_ = 0;
+    max_us_ = 0;
+  }
+
+  static constexpr uint32_t lower_bound(size_t bucket) {
+    return bucket < kSubBuckets
+               ? static_cast<uint32_t>(bucket)
+               : (kSubBuckets + bucket % kSubBuckets)
+                     << (bucket / kSubBuckets - 1);
+  }
+  static constexpr uint32_t upper_bound(size_t bucket) {
+    return bucket + 1 < kBuckets ? lower_bound(bucket + 1) - 1 : kLimit - 1;
+  }
+
+ private:
+  static constexpr uint32_t kLimit = uint32_t{1} << kRangeBits;
+
+  void halve() {
+    weight_ = 0;
+    for (auto& count : counts_) {
+      count /= 2;
+      weight_ += count;
+    }
+  }
+
+  static size_t bucket_of(uint32_t value) {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    int top_bit = 31 - __builtin_clz(value);
+    uint32_t sub = (value >> (top_bit - kSubBucketBits)) & (kSubBuckets - 1);
+    return (top_bit - kSubBucketBits + 1) * kSubBuckets + sub;
+  }
+
+  uint16_t counts_[kBuckets] = {};
+  // The sum of counts_, which percentile() ranks against.
+  uint32_t weight_ = 0;
+  uint32_t recorded_ = 0;
+  uint32_t max_us_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,244 @@
+#ifndef RELAY_CONTROLLER_RELAY_LATENCY_MONITOR_H_
+#define RELAY_CONTROLLER_RELAY_LATENCY_MONITOR_H_
+
+// Latency histograms for the three legs of a relay change:
+//
+//   edgeToRelay   button edge seen by the ISR -> relay written
+//   putToRelay    PUT handed to the bank -> relay written
+//   relayToDelta  relay written -> delta carrying it sent
+//
+// The monitor observes the bank, which notifies right after the outputs are
+// committed, so the time of the notification is the time of the write. The
+// edge and PUT times are the stamps the change carries.
+//
+// One set of histograms covers the whole bank. A set takes 636 bytes, so
+// only Tracked channels, the first ones unless track() picks others, get
+// their own as well; the others cost kBytesPerChannel each.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/channel_set.h"
+#include "relay/delta_batcher.h"
+#include "relay/hal.h"
+#include "relay/json_writer.h"
+#include "relay/latency_histogram.h"
+#include "relay/relay_bank.h"
+
+namespace relay_controller {
+
+enum class LatencyLeg : uint8_t { kEdgeToRelay, kPutToRelay, kRelayToDelta };
+
+constexpr size_t kLatencyLegs = 3;
+
+constexpr size_t kDefaultTrackedChannels = 8;
+
+inline const char* latency_leg_name(LatencyLeg leg) {
+  switch (leg) {
+    case LatencyLeg::kEdgeToRelay:
+      return "edgeToRelay";
+    case LatencyLeg::kPutToRelay:
+      return "putToRelay";
+    case LatencyLeg::kRelayToDelta:
+      return "relayToDelta";
+  }
+  return "";
+}
+
+template <size_t N, size_t BufferSize = 1024,
+          size_t Tracked = (N < kDefaultTrackedChannels
+                                ? N
+                                : kDefaultTrackedChannels)>
+class LatencyMonitor : public RelayObserver, public DeltaSentObserver<N> {
+ public:
+  static constexpr const char* kPathPrefix = "sensors.relaycontroller.latency.";
+  static constexpr size_t kTracked = Tracked;
+  // Every channel's write time and histogram slot, tracked or not.
+  static constexpr size_t kBytesPerChannel = sizeof(uint32_t) + 1;
+  static constexpr size_t kBytesPerTrackedChannel =
+      kLatencyLegs * sizeof(LatencyHistogram);
+
+  explicit LatencyMonitor(RelayBank<N>* bank) : bank_(bank) {
+    for (auto& slot : slot_of_) {
+      slot = kNotTracked;
+    }
+  }
+
+  // Give channel histograms of its own. Call before begin(). False once
+  // Tracked channels have them.
+  bool track(size_t channel) {
+    if (slot_of_[channel] != kNotTracked) {
+      return true;
+    }
+    if (tracked_ == Tracked) {
+      return false;
+    }
+    slot_of_[channel] = static_cast<uint8_t>(tracked_);
+    channel_of_[tracked_++] = static_cast<uint16_t>(channel);
+    return true;
+  }
+
+  // Start observing the bank, tracking the first channels if track() was
+  // not called. Pass the monitor to DeltaBatcher::set_sent_observer() as
+  // well to time relayToDelta.
+  void begin() {
+    if (tracked_ == 0) {
+      for (size_t channel = 0; channel < Tracked; channel++) {
+        track(channel);
+      }
+    }
+    bank_->add_observer(this);
+  }
+
+  void on_relay_event(const RelayEvent& event) override {
+    LatencyLeg leg;
+    if (event.source == ChangeSource::kButton) {
+      leg = LatencyLeg::kEdgeToRelay;
+    } else if (event.source == ChangeSource::kRemote) {
+      leg = LatencyLeg::kPutToRelay;
+    } else {
+      return;
+    }
+    uint64_t now = hal::now_us();
+    size_t channel = event.channel.index();
+    record(channel, leg, now - event.stamp_us);
+    // Only differences are taken, so the time may wrap.
+    written_us_[channel] = static_cast<uint32_t>(now);
+    awaiting_delta_.set(channel);
+  }
+
+  void on_delta_sent(const ChannelSet<N>& channels,
+                     uint64_t sent_us) override {
+    channels.for_each([&](size_t channel) {
+      if (awaiting_delta_.test(channel)) {
+        awaiting_delta_.reset(channel);
+        record(channel, LatencyLeg::kRelayToDelta,
+               static_cast<uint32_t>(sent_us) - written_us_[channel]);
+      }
+    });
+  }
+
+  // A tracked channel's histogram, or nullptr for a channel without one.
+  const LatencyHistogram* histogram(size_t channel, LatencyLeg leg) const {
+    uint8_t slot = slot_of_[channel];
+    return slot == kNotTracked
+               ? nullptr
+               : &histograms_[slot][static_cast<size_t>(leg)];
+  }
+  // Every channel's samples together.
+  const LatencyHistogram& bank_histogram(LatencyLeg leg) const {
+    return bank_histograms_[static_cast<size_t>(leg)];
+  }
+
+  size_t tracked() const { return tracked_; }
+  size_t tracked_channel(size_t slot) const { return channel_of_[slot]; }
+
+  // Send p50, p99 and max of every leg that has samples, in seconds, as
+  // sensors.relaycontroller.latency.all.<leg>.<stat> for the bank and
+  // sensors.relaycontroller.latency.relay<n>.<leg>.<stat> for each tracked
+  // channel. One delta each. Returns the number of deltas sent.
+  size_t publish(DeltaSink* sink) {
+    size_t sent = publish_set(sink, bank_histograms_, 0);
+    for (size_t slot = 0; slot < tracked_; slot++) {
+      sent += publish_set(sink, histograms_[slot], channel_of_[slot] + 1);
+    }
+    return sent;
+  }
+
+  // Write one histogram as a JSON object in microseconds: count, p50, p99,
+  // max and the non-empty buckets as [upper bound, count] pairs.
+  static void write_histogram(JsonWriter* writer, const LatencyHistogram& h) {
+    writer->raw("{\"count\":")
+        .unsigned_integer(h.count())
+        .raw(",\"p50\":")
+        .unsigned_integer(h.percentile(50))
+        .raw(",\"p99\":")
+        .unsigned_integer(h.percentile(99))
+        .raw(",\"max\":")
+        .unsigned_integer(h.max_us())
+        .raw(",\"buckets\":[");
+    bool first = true;
+    for (size_t i = 0; i < LatencyHistogram::kBuckets; i++) {
+      if (h.bucket_count(i) == 0) {
+        continue;
+      }
+      writer->raw(first ? "[" : ",[")
+          .unsigned_integer(LatencyHistogram::upper_bound(i))
+          .raw(",")
+          .unsigned_integer(h.bucket_count(i))
+          .raw("]");
+      first = false;
+    }
+    writer->raw("]}");
+  }
+
+ private:
+  static constexpr uint8_t kNotTracked = UINT8_MAX;
+  static_assert(Tracked <= N && Tracked < kNotTracked,
+                "tracked channels are numbered in a uint8_t");
+
+  void record(size_t channel, LatencyLeg leg, uint64_t us) {
+    bank_histograms_[static_cast<size_t>(leg)].record(us);
+    uint8_t slot = slot_of_[channel];
+    if (slot != kNotTracked) {
+      histograms_[slot][static_cast<size_t>(leg)].record(us);
+    }
+  }
+
+  // relay is the channel number from 1, or 0 for the whole bank.
+  size_t publish_set(DeltaSink* sink,
+                     const LatencyHistogram (&set)[kLatencyLegs],
+                     size_t relay) {
+    JsonWriter writer(buffer_, BufferSize);
+    writer.raw("{\"updates\":[{\"values\":[");
+    size_t values = 0;
+    for (size_t leg = 0; leg < kLatencyLegs; leg++) {
+      const LatencyHistogram& h = set[leg];
+      if (h.count() == 0) {
+        continue;
+      }
+      const char* name = latency_leg_name(static_cast<LatencyLeg>(leg));
+      write_value(&writer, &values, relay, name, "p50", h.percentile(50));
+      write_value(&writer, &values, relay, name, "p99", h.percentile(99));
+      write_value(&writer, &values, relay, name, "max", h.max_us());
+    }
+    writer.raw("]}]}");
+    return values > 0 && writer.ok() &&
+                   sink->send_delta(writer.c_str(), writer.length())
+               ? 1
+               : 0;
+  }
+
+  static void write_value(JsonWriter* writer, size_t* values, size_t relay,
+                          const char* leg, const char* stat, uint32_t us) {
+    writer->raw(*values == 0 ? "{\"path\":\"" : ",{\"path\":\"")
+        .raw(kPathPrefix);
+    if (relay == 0) {
+      writer->raw("all");
+    } else {
+      writer->raw("relay").unsigned_integer(relay);
+    }
+    writer->raw(".")
+        .raw(leg)
+        .raw(".")
+        .raw(stat)
+        .raw("\",\"value\":")
+        .seconds(us)
+        .raw("}");
+    (*values)++;
+  }
+
+  RelayBank<N>* bank_;
+  LatencyHistogram bank_histograms_[kLatencyLegs];
+  LatencyHistogram histograms_[Tracked][kLatencyLegs];
+  uint16_t channel_of_[Tracked] = {};
+  size_t tracked_ = 0;
+  uint8_t slot_of_[N];
+  uint32_t written_us_[N] = {};
+  ChannelSet<N> awaiting_delta_;
+  char buffer_[BufferSize];
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_LATENCY_MONITOR_H_
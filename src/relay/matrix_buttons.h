@@ -0,0 +1,110 @@
+#ifndef RELAY_CONTROLLER_RELAY_MATRIX_BUTTONS_H_
+#define RELAY_CONTROLLER_RELAY_MATRIX_BUTTONS_H_
+
+// Buttons of a bank on a ButtonMatrix, scanned from the event loop.
+//
+// Every scan period an idle matrix costs one read with all rows pulled low.
+// Once a key is down the matrix is scanned row by row and debounced with
+// the same vertical counters as BankDebouncer until every key has settled,
+// and clean levels go to the bank like those of GPIO buttons.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/bank_debouncer.h"
+#include "relay/button_matrix.h"
+#include "relay/hal.h"
+#include "relay/relay_bank.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class MatrixButtons {
+ public:
+  // Follow the buttons of bank, which are keys of matrix, looking every
+  // scan_period_us. Call after bank.begin().
+  void begin(const RelayBank<N>& bank, ButtonMatrix* matrix,
+             uint32_t debounce_ms, uint32_t scan_period_us = 2000) {
+    matrix_ = matrix;
+    scan_period_us_ = scan_period_us;
+    uint32_t samples =
+        scan_period_us == 0
+            ? 1
+            : (debounce_ms * 1000 + scan_period_us - 1) / scan_period_us;
+    if (samples < 1) {
+      samples = 1;
+    } else if (samples > VerticalCounterWord::kMaxSamples) {
+      samples = VerticalCounterWord::kMaxSamples;
+    }
+    for (size_t i = 0; i < N; i++) {
+      uint16_t key = bank.channel(i).pins().button;
+      if (key == kNoPin) {
+        continue;
+      }
+      channel_of_key_[key] = static_cast<uint8_t>(i);
+      button_mask_ |= uint64_t{1} << key;
+      keys_.set_limit(key, samples);
+    }
+    uint64_t levels = 0;
+    for (size_t k = 0; k < ButtonMatrix::kMaxKeys; k++) {
+      levels |= static_cast<uint64_t>(matrix_->read_input(k)) << k;
+    }
+    keys_.reset(levels & button_mask_);
+    next_scan_us_ = hal::now_us();
+  }
+
+  // Scan if one is due and hand clean levels to sink->handle_button(),
+  // stamped with the scan that first saw a key move.
+  template <typename Sink>
+  void tick(Sink* sink) {
+    uint64_t now = hal::now_us();
+    if (static_cast<int64_t>(now - next_scan_us_) < 0) {
+      return;
+    }
+    next_scan_us_ = now + scan_period_us_;
+    // Nothing pressed and nothing being released: nothing to debounce.
+    if (!active_ && keys_.stable() == button_mask_) {
+      idle_checks_++;
+      if (!matrix_->any_pressed()) {
+        return;
+      }
+    }
+
+    uint64_t keys = matrix_->scan() & button_mask_;
+    scans_++;
+    if (!active_ && keys != keys_.stable()) {
+      active_ = true;
+      episode_us_ = now;
+    }
+    uint64_t flipped = keys_.update(keys);
+    while (flipped != 0) {
+      unsigned key = __builtin_ctzll(flipped);
+      flipped &= flipped - 1;
+      sink->handle_button(channel_of_key_[key], (keys_.stable() >> key) & 1,
+                          episode_us_);
+    }
+    if (keys == keys_.stable()) {
+      active_ = false;
+    }
+  }
+
+  // Full scans and all-rows idle checks so far.
+  uint32_t scans() const { return scans_; }
+  uint32_t idle_checks() const { return idle_checks_; }
+
+ private:
+  ButtonMatrix* matrix_ = nullptr;
+  uint32_t scan_period_us_ = 2000;
+  VerticalCounterWord keys_;
+  uint64_t button_mask_ = 0;
+  uint8_t channel_of_key_[ButtonMatrix::kMaxKeys] = {};
+  bool active_ = false;
+  uint64_t episode_us_ = 0;
+  uint64_t next_scan_us_ = 0;
+  uint32_t scans_ = 0;
+  uint32_t idle_checks_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_MATRIX_BUTTONS_H_
@@ -0,0 +1,39 @@
+#include "relay/memory_report.h"
+
+#include "relay/hal.h"
+#include "relay/json_writer.h"
+
+namespace relay_controller {
+
+namespace {
+
+constexpr const char* kPathPrefix = "sensors.relaycontroller.memory.";
+
+void write_value(JsonWriter* writer, bool first, const char* name,
+                 uint64_t value) {
+  writer->raw(first ? "{\"path\":\"" : ",{\"path\":\"")
+      .raw(kPathPrefix)
+      .raw(name)
+      .raw("\",\"value\":")
+      .unsigned_integer(value)
+      .raw("}");
+}
+
+}  // namespace
+
+bool publish_memory_report(const BumpArena& arena, DeltaSink* sink) {
+  hal::HeapStats heap = hal::heap_stats();
+  char buffer[512];
+  JsonWriter writer(buffer, sizeof(buffer));
+  writer.raw("{\"updates\":[{\"values\":[");
+  write_value(&writer, true, "heapFree", heap.free_bytes);
+  write_value(&writer, false, "heapLargestFreeBlock", heap.largest_free_block);
+  write_value(&writer, false, "heapMinimumFree", heap.minimum_free_bytes);
+  write_value(&writer, false, "arenaUsed", arena.used());
+  write_value(&writer, false, "arenaCapacity", arena.capacity());
+  write_value(&writer, false, "arenaOverflows", arena.overflows());
+  writer.raw("]}]}");
+  return writer.ok() && sink->send_delta(writer.c_str(), writer.length());
+}
+
+}  // namespace relay_controller
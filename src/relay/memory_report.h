@@ -0,0 +1,26 @@
+#ifndef RELAY_CONTROLLER_RELAY_MEMORY_REPORT_H_
+#define RELAY_CONTROLLER_RELAY_MEMORY_REPORT_H_
+
+// Heap and arena figures as one Signal K delta, in bytes:
+//
+//   sensors.relaycontroller.memory.heapFree
+//   sensors.relaycontroller.memory.heapLargestFreeBlock
+//   sensors.relaycontroller.memory.heapMinimumFree
+//   sensors.relaycontroller.memory.arenaUsed
+//   sensors.relaycontroller.memory.arenaCapacity
+//   sensors.relaycontroller.memory.arenaOverflows
+//
+// A largest free block that keeps shrinking while heapFree holds steady is
+// the signature of fragmentation.
+
+#include "relay/bump_arena.h"
+#include "relay/delta_sink.h"
+
+namespace relay_controller {
+
+// Returns false if the delta could not be sent.
+bool publish_memory_report(const BumpArena& arena, DeltaSink* sink);
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_MEMORY_REPORT_H_
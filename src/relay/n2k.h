@@ -0,0 +1,111 @@
+#ifndef RELAY_CONTROLLER_RELAY_N2K_H_
+#define RELAY_CONTROLLER_RELAY_N2K_H_
+
+// The parts of NMEA 2000 a binary switch bank needs: J1939 identifiers,
+// the NAME a device claims its address with, and the layout of the switch
+// bank PGNs. Everything the bank sends or reads fits in a single frame.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace relay_controller {
+namespace n2k {
+
+constexpr uint32_t kIsoRequest = 59904;
+constexpr uint32_t kIsoAddressClaim = 60928;
+constexpr uint32_t kSwitchBankStatus = 127501;
+constexpr uint32_t kSwitchBankControl = 127502;
+
+constexpr uint8_t kMaxAddress = 251;
+constexpr uint8_t kNullAddress = 254;
+constexpr uint8_t kGlobalAddress = 255;
+
+// A frame's identifier, unpacked.
+struct Header {
+  uint8_t priority;
+  uint32_t pgn;
+  uint8_t source;
+  // kGlobalAddress for PGNs that are always broadcast.
+  uint8_t destination;
+};
+
+// PGNs whose PDU format byte is below 240 are addressed; their low byte is
+// the destination.
+constexpr bool is_addressed(uint32_t pgn) { return (pgn >> 8 & 0xff) < 240; }
+
+constexpr uint32_t make_id(uint8_t priority, uint32_t pgn, uint8_t source,
+                           uint8_t destination = kGlobalAddress) {
+  uint32_t id = static_cast<uint32_t>(priority & 7) << 26 |
+                (pgn & 0x3ffff) << 8 | source;
+  if (is_addressed(pgn)) {
+    id = (id & ~0xff00u) | static_cast<uint32_t>(destination) << 8;
+  }
+  return id;
+}
+
+constexpr Header parse_id(uint32_t id) {
+  Header header = {static_cast<uint8_t>(id >> 26 & 7), id >> 8 & 0x3ffff,
+                   static_cast<uint8_t>(id), kGlobalAddress};
+  if (is_addressed(header.pgn)) {
+    header.destination = static_cast<uint8_t>(header.pgn);
+    header.pgn &= 0x3ff00;
+  }
+  return header;
+}
+
+// Fields of the 64-bit NAME. Of two devices claiming one address, the one
+// with the lower NAME keeps it.
+struct Name {
+  uint32_t unique_number;      // 21 bits, e.g. from the MAC address.
+  uint16_t manufacturer_code;  // 11 bits; 2046 when there is none.
+  uint8_t device_instance;
+  uint8_t device_function;
+  uint8_t device_class;
+  uint8_t system_instance;  // 4 bits.
+  uint8_t industry_group;   // 3 bits; 4 is marine.
+
+  // The NAME as sent, able to move to another address.
+  constexpr uint64_t value() const {
+    return (unique_number & 0x1fffffull) |
+           static_cast<uint64_t>(manufacturer_code & 0x7ff) << 21 |
+           static_cast<uint64_t>(device_instance) << 32 |
+           static_cast<uint64_t>(device_function) << 40 |
+           static_cast<uint64_t>(device_class & 0x7f) << 49 |
+           static_cast<uint64_t>(system_instance & 0xf) << 56 |
+           static_cast<uint64_t>(industry_group & 7) << 60 | 1ull << 63;
+  }
+};
+
+// A NAME's unique number from an ESP32 MAC as ESP.getEfuseMac() returns it,
+// first byte lowest. The first three bytes are Espressif's OUI, the same on
+// every board, so the number comes from the last three.
+constexpr uint32_t unique_number_from_mac(uint64_t mac) {
+  return static_cast<uint32_t>(mac >> 24) & 0x1fffff;
+}
+
+// Switch bank status and control: the bank instance, then a two-bit field
+// per switch, switch 1 in the low bits of the second byte.
+constexpr size_t kSwitchesPerBank = 28;
+
+enum SwitchField : uint8_t {
+  kSwitchOff = 0,
+  kSwitchOn = 1,
+  kSwitchError = 2,
+  // Status: the bank has no such switch. Control: leave it as it is.
+  kSwitchUnavailable = 3,
+};
+
+inline SwitchField switch_field(const uint8_t* data, size_t index) {
+  return static_cast<SwitchField>(data[1 + index / 4] >> (index % 4 * 2) & 3);
+}
+
+inline void set_switch_field(uint8_t* data, size_t index, SwitchField value) {
+  uint8_t& byte = data[1 + index / 4];
+  size_t shift = index % 4 * 2;
+  byte = static_cast<uint8_t>((byte & ~(3 << shift)) | value << shift);
+}
+
+}  // namespace n2k
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_N2K_H_
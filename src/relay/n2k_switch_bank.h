@@ -0,0 +1,218 @@
+#ifndef RELAY_CONTROLLER_RELAY_N2K_SWITCH_BANK_H_
+#define RELAY_CONTROLLER_RELAY_N2K_SWITCH_BANK_H_
+
+// The relays as NMEA 2000 binary switch banks, straight on the CAN bus, so
+// that N2K switch panels work without WiFi or a Signal K server.
+//
+// Relay n is switch n % 28 + 1 of bank first_instance + n / 28. Each bank
+// reports all its switches in one Binary Switch Bank Status frame, PGN
+// 127501, every period_us and on the tick one of them changes. Switch Bank
+// Control, PGN 127502, for one of the banks is applied with a single
+// RelayBank::set_group(), and the status frame that follows on the same
+// tick is its acknowledgement.
+//
+// begin() claims an address, PGN 60928, which is then defended against
+// devices with a higher NAME and given up for the next one otherwise,
+// also to a device with the same NAME. ISO
+// requests for the claim or the bank status are answered. Nothing longer
+// than one frame, such as product information, is sent.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "relay/can_bus.h"
+#include "relay/channel_set.h"
+#include "relay/hal.h"
+#include "relay/n2k.h"
+#include "relay/relay_bank.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class N2kSwitchBank : public RelayObserver {
+ public:
+  static constexpr size_t kBanks =
+      (N + n2k::kSwitchesPerBank - 1) / n2k::kSwitchesPerBank;
+  static constexpr uint8_t kDefaultAddress = 128;
+  static constexpr uint32_t kDefaultPeriodUs = 2000000;
+  // Frames read per tick, so that a busy bus cannot stall the loop.
+  static constexpr size_t kMaxFramesPerTick = 16;
+  // After a claim, others have this long to contest it before the bank
+  // sends anything else.
+  static constexpr uint64_t kClaimSettleUs = 250000;
+
+  N2kSwitchBank(RelayBank<N>* bank, CanBus* bus) : bank_(bank), bus_(bus) {}
+
+  void begin(const n2k::Name& name, uint8_t first_instance,
+             uint8_t address = kDefaultAddress,
+             uint32_t period_us = kDefaultPeriodUs) {
+    name_ = name.value();
+    first_instance_ = first_instance;
+    address_ = address > n2k::kMaxAddress ? kDefaultAddress : address;
+    period_us_ = period_us;
+    bank_->add_observer(this);
+    claim(hal::now_us());
+  }
+
+  void on_relay_event(const RelayEvent& event) override {
+    // Heartbeats change nothing; the bank has a period of its own.
+    if (event.source != ChangeSource::kHeartbeat) {
+      due_.set(event.channel.index() / n2k::kSwitchesPerBank);
+    }
+  }
+
+  // Handle received frames, then send the status of every bank that is
+  // due. Call once per event loop tick.
+  void tick() {
+    uint64_t now = hal::now_us();
+    CanFrame frame;
+    for (size_t i = 0; i < kMaxFramesPerTick && bus_->receive(&frame); i++) {
+      handle(frame, now);
+    }
+    if (address_ == n2k::kNullAddress || now - claimed_us_ < kClaimSettleUs) {
+      return;
+    }
+    if (now - last_period_us_ >= period_us_) {
+      last_period_us_ = now;
+      for (size_t b = 0; b < kBanks; b++) {
+        due_.set(b);
+      }
+    }
+    due_.for_each([&](size_t b) {
+      if (send_status(b)) {
+        due_.reset(b);
+      }
+    });
+  }
+
+  // kNullAddress if every address was taken by a device with a lower NAME.
+  uint8_t address() const { return address_; }
+  uint32_t address_changes() const { return address_changes_; }
+  uint32_t status_frames() const { return status_frames_; }
+  uint32_t control_frames() const { return control_frames_; }
+
+ private:
+  void handle(const CanFrame& frame, uint64_t now) {
+    n2k::Header header = n2k::parse_id(frame.id);
+    if (header.destination != n2k::kGlobalAddress &&
+        header.destination != address_) {
+      return;
+    }
+    if (header.pgn == n2k::kSwitchBankControl && frame.length == 8) {
+      apply_control(frame.data, header.source, now);
+    } else if (header.pgn == n2k::kIsoAddressClaim && frame.length == 8 &&
+               header.source == address_) {
+      uint64_t other = 0;
+      for (size_t i = 0; i < 8; i++) {
+        other |= static_cast<uint64_t>(frame.data[i]) << (8 * i);
+      }
+      contest(other, now);
+    } else if (header.pgn == n2k::kIsoRequest && frame.length >= 3) {
+      uint32_t pgn = frame.data[0] | frame.data[1] << 8 |
+                     static_cast<uint32_t>(frame.data[2]) << 16;
+      if (pgn == n2k::kIsoAddressClaim) {
+        send_claim();
+      } else if (pgn == n2k::kSwitchBankStatus) {
+        for (size_t b = 0; b < kBanks; b++) {
+          due_.set(b);
+        }
+      }
+    }
+  }
+
+  void apply_control(const uint8_t* data, uint8_t source, uint64_t now) {
+    size_t b = static_cast<uint8_t>(data[0] - first_instance_);
+    if (b >= kBanks) {
+      return;
+    }
+    ChannelSet<N> members;
+    ChannelSet<N> states;
+    size_t first = b * n2k::kSwitchesPerBank;
+    for (size_t s = 0; s < n2k::kSwitchesPerBank && first + s < N; s++) {
+      n2k::SwitchField field = n2k::switch_field(data, s);
+      if (field == n2k::kSwitchOn || field == n2k::kSwitchOff) {
+        members.set(first + s);
+        states.assign(first + s, field == n2k::kSwitchOn);
+      }
+    }
+    size_t changed =
+        bank_->set_group(members, states, ChangeSource::kRemote, now);
+    RELAY_TRACE(kN2kControl, data[0], source, changed);
+    control_frames_++;
+    // Acknowledge even when nothing changed.
+    due_.set(b);
+  }
+
+  // Someone else claimed our address with NAME other. A NAME equal to ours
+  // is another node, as the bus does not echo our own frames; neither can
+  // win, so give the address up rather than share it.
+  void contest(uint64_t other, uint64_t now) {
+    if (name_ < other) {
+      send_claim();
+      return;
+    }
+    address_changes_++;
+    if (address_changes_ > n2k::kMaxAddress) {
+      // Every address is taken: say so from the null address, and stop.
+      address_ = n2k::kNullAddress;
+      send_claim();
+      RELAY_TRACE(kN2kAddress, address_, address_changes_);
+      return;
+    }
+    address_ = address_ == n2k::kMaxAddress ? 0 : address_ + 1;
+    claim(now);
+  }
+
+  void claim(uint64_t now) {
+    claimed_us_ = now;
+    send_claim();
+    RELAY_TRACE(kN2kAddress, address_, address_changes_);
+  }
+
+  void send_claim() {
+    CanFrame frame = {n2k::make_id(6, n2k::kIsoAddressClaim, address_), 8,
+                      {}};
+    for (size_t i = 0; i < 8; i++) {
+      frame.data[i] = static_cast<uint8_t>(name_ >> (8 * i));
+    }
+    bus_->send(frame);
+  }
+
+  bool send_status(size_t b) {
+    CanFrame frame = {n2k::make_id(3, n2k::kSwitchBankStatus, address_), 8,
+                      {}};
+    memset(frame.data, 0xff, sizeof(frame.data));
+    frame.data[0] = static_cast<uint8_t>(first_instance_ + b);
+    size_t first = b * n2k::kSwitchesPerBank;
+    for (size_t s = 0; s < n2k::kSwitchesPerBank && first + s < N; s++) {
+      n2k::set_switch_field(
+          frame.data, s,
+          bank_->state(first + s) ? n2k::kSwitchOn : n2k::kSwitchOff);
+    }
+    if (!bus_->send(frame)) {
+      return false;
+    }
+    status_frames_++;
+    return true;
+  }
+
+  RelayBank<N>* bank_;
+  CanBus* bus_;
+  uint64_t name_ = 0;
+  uint8_t first_instance_ = 0;
+  uint8_t address_ = n2k::kNullAddress;
+  uint32_t period_us_ = kDefaultPeriodUs;
+  uint64_t claimed_us_ = 0;
+  uint64_t last_period_us_ = 0;
+  // Banks whose status is to be sent.
+  ChannelSet<kBanks> due_;
+  uint32_t address_changes_ = 0;
+  uint32_t status_frames_ = 0;
+  uint32_t control_frames_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_N2K_SWITCH_BANK_H_
@@ -0,0 +1,21 @@
+#ifndef RELAY_CONTROLLER_RELAY_OUTPUT_STAGE_H_
+#define RELAY_CONTROLLER_RELAY_OUTPUT_STAGE_H_
+
+namespace relay_controller {
+
+// Drives a set of output pins for a RelayBank.
+//
+// Levels are staged one pin at a time and reach the hardware together on
+// commit(), so that relays switched in one operation change at once.
+class OutputStage {
+ public:
+  virtual ~OutputStage() = default;
+
+  virtual void configure(int pin) = 0;
+  virtual void stage(int pin, bool level) = 0;
+  virtual void commit() = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_OUTPUT_STAGE_H_
@@ -0,0 +1,173 @@
+#ifndef RELAY_CONTROLLER_RELAY_PUBLISH_LIMITER_H_
+#define RELAY_CONTROLLER_RELAY_PUBLISH_LIMITER_H_
+
+// Per-channel limits on how often a relay's state is published, so that a
+// chattering input or an automation stuck in a PUT loop cannot turn into a
+// storm of deltas.
+//
+// Each channel has a token bucket holding up to burst tokens and refilled
+// at rate_per_s; every delta that carries the channel takes one. The
+// bucket is kept as microseconds of credit, one interval's worth per
+// token. DeltaBatcher holds a channel without a token back instead of
+// dropping it, and sends its state as it is by then once a token has come
+// in: the final state always goes out, only flips in between are lost.
+//
+// A channel is flapping once its relay changes more than flap_changes
+// times within one flap window, and steady again after a whole window with
+// at most half as many. Either way a notice is raised, which DeltaBatcher
+// publishes as a Signal K notification.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/channel_set.h"
+#include "relay/hal.h"
+#include "relay/relay_bank.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+struct PublishLimit {
+  // Sustained publishes per second and channel; 0 for no limit.
+  float rate_per_s = 2;
+  // Publishes that may go out back to back after a quiet spell.
+  uint32_t burst = 5;
+  uint32_t flap_changes = 20;
+  uint32_t flap_window_us = 10000000;
+};
+
+template <size_t N>
+class PublishLimiter : public RelayObserver {
+ public:
+  explicit PublishLimiter(RelayBank<N>* bank) : bank_(bank) {}
+
+  void begin(const PublishLimit& limit) {
+    // Anything slower than one per hour counts as one per hour.
+    interval_us_ = limit.rate_per_s <= 0 ? 0
+                   : limit.rate_per_s < 1 / 3600.0f
+                       ? 3600000000u
+                       : static_cast<uint32_t>(1000000 / limit.rate_per_s);
+    uint64_t capacity = static_cast<uint64_t>(interval_us_) *
+                        (limit.burst > 0 ? limit.burst : 1);
+    capacity_us_ = static_cast<uint32_t>(
+        capacity < UINT32_MAX ? capacity : UINT32_MAX);
+    flap_changes_ = limit.flap_changes;
+    flap_window_us_ = limit.flap_window_us;
+    uint64_t now = hal::now_us();
+    for (size_t i = 0; i < N; i++) {
+      buckets_[i] = {now, capacity_us_};
+      seen_.assign(i, bank_->state(i));
+    }
+    bank_->add_observer(this);
+  }
+
+  void on_relay_event(const RelayEvent& event) override {
+    size_t channel = event.channel.index();
+    bool on = bank_->state(channel);
+    if (seen_.test(channel) == on) {
+      return;
+    }
+    seen_.assign(channel, on);
+    uint64_t now = hal::now_us();
+    Flaps& flaps = flaps_[channel];
+    roll_window(channel, now);
+    flaps.changes++;
+    if (!flapping_.test(channel) && flaps.changes > flap_changes_) {
+      flapping_.set(channel);
+      notices_.set(channel);
+      flap_episodes_++;
+      RELAY_TRACE(kFlapStart, channel, flaps.changes,
+                  flap_window_us_ / 1000);
+    }
+  }
+
+  // Take a token for channel. Returns false if there is none left.
+  bool take(size_t channel, uint64_t now) {
+    if (interval_us_ == 0) {
+      return true;
+    }
+    Bucket& bucket = refill(channel, now);
+    if (bucket.credit_us < interval_us_) {
+      return false;
+    }
+    bucket.credit_us -= interval_us_;
+    return true;
+  }
+
+  // When channel will next have a token.
+  uint64_t next_token_us(size_t channel) const {
+    const Bucket& bucket = buckets_[channel];
+    if (bucket.credit_us >= interval_us_) {
+      return bucket.refilled_us;
+    }
+    return bucket.refilled_us + (interval_us_ - bucket.credit_us);
+  }
+
+  // Clear flapping channels that have calmed down. Call once per tick.
+  void tick(uint64_t now) {
+    flapping_.for_each([&](size_t channel) { roll_window(channel, now); });
+  }
+
+  bool flapping(size_t channel) const { return flapping_.test(channel); }
+  // Channels that started or stopped flapping since their last notice.
+  const ChannelSet<N>& notices() const { return notices_; }
+  void clear_notice(size_t channel) { notices_.reset(channel); }
+
+  uint32_t interval_us() const { return interval_us_; }
+  uint32_t flap_changes() const { return flap_changes_; }
+  uint32_t flap_window_us() const { return flap_window_us_; }
+  uint32_t flap_episodes() const { return flap_episodes_; }
+
+ private:
+  struct Bucket {
+    uint64_t refilled_us;
+    uint32_t credit_us;
+  };
+
+  struct Flaps {
+    uint64_t window_start_us = 0;
+    uint32_t changes = 0;
+  };
+
+  Bucket& refill(size_t channel, uint64_t now) {
+    Bucket& bucket = buckets_[channel];
+    uint64_t credit = bucket.credit_us + (now - bucket.refilled_us);
+    bucket.credit_us = static_cast<uint32_t>(
+        credit < capacity_us_ ? credit : capacity_us_);
+    bucket.refilled_us = now;
+    return bucket;
+  }
+
+  // Start a new flap window if the current one is over. A quiet channel's
+  // window starts with its next change.
+  void roll_window(size_t channel, uint64_t now) {
+    Flaps& flaps = flaps_[channel];
+    if (now - flaps.window_start_us < flap_window_us_) {
+      return;
+    }
+    if (flapping_.test(channel) && flaps.changes <= flap_changes_ / 2) {
+      flapping_.reset(channel);
+      notices_.set(channel);
+      RELAY_TRACE(kFlapEnd, channel);
+    }
+    flaps.window_start_us = now;
+    flaps.changes = 0;
+  }
+
+  RelayBank<N>* bank_;
+  uint32_t interval_us_ = 0;
+  uint32_t capacity_us_ = 0;
+  uint32_t flap_changes_ = 0;
+  uint32_t flap_window_us_ = 0;
+  Bucket buckets_[N] = {};
+  Flaps flaps_[N];
+  // The state each channel was last seen in, to tell changes from repeats.
+  ChannelSet<N> seen_;
+  ChannelSet<N> flapping_;
+  ChannelSet<N> notices_;
+  uint32_t flap_episodes_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_PUBLISH_LIMITER_H_
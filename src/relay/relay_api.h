@@ -0,0 +1,295 @@
+#ifndef RELAY_CONTROLLER_RELAY_RELAY_API_H_
+#define RELAY_CONTROLLER_RELAY_RELAY_API_H_
+
+// The relay bank as a small document API, for panels on the local network
+// that would rather not go through the Signal K server.
+//
+// The state document lists every relay, numbered from 1, as a bit mask in
+// hex, relay 1 in the lowest bit, and as an array:
+//
+//   {"relays":4,"sequence":17,"on":"5","states":[1,0,1,0]}
+//
+// sequence changes whenever a relay does. A request body is one of
+//
+//   {"on":"5"}              every relay to its bit
+//   {"on":"1","mask":"3"}   relays 1 and 2 only: 1 on, 2 off
+//   {"set":"1=on,3=off"}    the listed relays, in scene syntax
+//
+// and is applied with one RelayBank::set_group(), so every relay in it
+// switches at once and no reader ever sees half of it. Changes are
+// published to Signal K as usual.
+//
+// The web server runs in its own task, while the bank belongs to the event
+// loop. write_states() only takes a snapshot and is safe from any task; a
+// request is handed over with submit() and applied by tick().
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "relay/channel_set.h"
+#include "relay/hal.h"
+#include "relay/json_writer.h"
+#include "relay/relay_bank.h"
+#include "relay/relay_scene.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class RelayApi {
+ public:
+  struct Request {
+    ChannelSet<N> members;
+    ChannelSet<N> states;
+    uint64_t received_us = 0;
+  };
+
+  // Longest "set" list: every relay, "<n>=off,".
+  static constexpr size_t kMaxSpecLength = N * 8;
+  // Largest body parse() can accept, and largest document written.
+  static constexpr size_t kMaxBodyLength = kMaxSpecLength + 64;
+  static constexpr size_t kMaxDocumentLength = N * 2 + (N + 3) / 4 + 96;
+
+  explicit RelayApi(RelayBank<N>* bank) : bank_(bank) {}
+
+  // Read a request body. Returns false if it is malformed or names a relay
+  // that does not exist.
+  static bool parse(const char* body, size_t length, Request* out) {
+    Parser parser{body, body + length};
+    ChannelSet<N> mask;
+    bool has_on = false;
+    bool has_mask = false;
+    bool has_set = false;
+    if (!parser.consume('{')) {
+      return false;
+    }
+    do {
+      const char* key;
+      size_t key_length;
+      const char* value;
+      size_t value_length;
+      if (!parser.string(&key, &key_length) || !parser.consume(':') ||
+          !parser.string(&value, &value_length)) {
+        return false;
+      }
+      if (is_key(key, key_length, "on") && !has_on) {
+        has_on = parse_mask(value, value_length, &out->states);
+        if (!has_on) {
+          return false;
+        }
+      } else if (is_key(key, key_length, "mask") && !has_mask) {
+        has_mask = parse_mask(value, value_length, &mask);
+        if (!has_mask) {
+          return false;
+        }
+      } else if (is_key(key, key_length, "set") && !has_set) {
+        // RelayScene reads a terminated string.
+        char spec[kMaxSpecLength + 1];
+        if (value_length > kMaxSpecLength) {
+          return false;
+        }
+        memcpy(spec, value, value_length);
+        spec[value_length] = '\0';
+        RelayScene<N> scene;
+        if (!scene.parse(spec)) {
+          return false;
+        }
+        out->members = scene.members();
+        out->states = scene.states();
+        has_set = true;
+      } else {
+        return false;
+      }
+    } while (parser.consume(','));
+    if (!parser.consume('}') || !parser.at_end() ||
+        has_set == (has_on || has_mask) || (has_mask && !has_on)) {
+      return false;
+    }
+    if (has_on) {
+      out->members = mask;
+      if (!has_mask) {
+        for (size_t i = 0; i < N; i++) {
+          out->members.set(i);
+        }
+      }
+    }
+    return true;
+  }
+
+  // Hand request to the event loop. Returns false while the previous one
+  // has not been applied yet. Call from one task only, the web server.
+  bool submit(const Request& request) {
+    if (busy()) {
+      return false;
+    }
+    request_ = request;
+    submitted_.store(submitted_.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+    return true;
+  }
+
+  // Whether the last request submitted is still waiting for tick().
+  bool busy() const {
+    return applied_.load(std::memory_order_acquire) !=
+           submitted_.load(std::memory_order_relaxed);
+  }
+
+  // Relays the last applied request changed; valid once busy() is false.
+  size_t changed() const { return changed_; }
+
+  // Apply a submitted request. Call once per event loop tick.
+  void tick() {
+    uint32_t submitted = submitted_.load(std::memory_order_acquire);
+    if (submitted == applied_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    changed_ = bank_->set_group(request_.members, request_.states,
+                                ChangeSource::kRemote, request_.received_us);
+    RELAY_TRACE(kApiRequest, request_.members.count(), changed_);
+    requests_++;
+    applied_.store(submitted, std::memory_order_release);
+  }
+
+  // Write the state document. Returns false if the states could not be
+  // read consistently, or did not fit.
+  bool write_states(JsonWriter* writer) const {
+    writer->raw("{");
+    return write_document(writer);
+  }
+
+  // The state document after a request, with "changed" first.
+  bool write_result(JsonWriter* writer) const {
+    writer->raw("{\"changed\":").unsigned_integer(changed_).raw(",");
+    return write_document(writer);
+  }
+
+  uint32_t requests() const { return requests_; }
+
+ private:
+  bool write_document(JsonWriter* writer) const {
+    ChannelSet<N> states;
+    uint32_t sequence;
+    if (!bank_->states(&states, &sequence)) {
+      return false;
+    }
+    writer->raw("\"relays\":")
+        .unsigned_integer(N)
+        .raw(",\"sequence\":")
+        .unsigned_integer(sequence)
+        .raw(",\"on\":\"");
+    // Most significant digit first, without leading zeros.
+    bool started = false;
+    for (size_t digit = (N + 3) / 4; digit > 0; digit--) {
+      size_t bit = (digit - 1) * 4;
+      unsigned value = 0;
+      for (size_t b = 0; b < 4 && bit + b < N; b++) {
+        value |= static_cast<unsigned>(states.test(bit + b)) << b;
+      }
+      if (value != 0 || started || digit == 1) {
+        char hex = "0123456789abcdef"[value];
+        writer->raw(&hex, 1);
+        started = true;
+      }
+    }
+    writer->raw("\",\"states\":[");
+    for (size_t i = 0; i < N; i++) {
+      writer->raw(i == 0 ? "" : ",").raw(states.test(i) ? "1" : "0");
+    }
+    writer->raw("]}");
+    return writer->ok();
+  }
+
+  // Just enough JSON for the request bodies: an object of string values.
+  struct Parser {
+    const char* p;
+    const char* end;
+
+    void skip_spaces() {
+      while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        p++;
+      }
+    }
+    bool consume(char c) {
+      skip_spaces();
+      if (p < end && *p == c) {
+        p++;
+        return true;
+      }
+      return false;
+    }
+    bool at_end() {
+      skip_spaces();
+      return p == end;
+    }
+    // A string without escapes; none of the values need them.
+    bool string(const char** text, size_t* length) {
+      if (!consume('"')) {
+        return false;
+      }
+      *text = p;
+      while (p < end && *p != '"') {
+        if (*p == '\\') {
+          return false;
+        }
+        p++;
+      }
+      if (p == end) {
+        return false;
+      }
+      *length = p - *text;
+      p++;
+      return true;
+    }
+  };
+
+  static bool is_key(const char* key, size_t length, const char* name) {
+    return length == strlen(name) && memcmp(key, name, length) == 0;
+  }
+
+  // Hex digits, most significant first, bit 0 being relay 1.
+  static bool parse_mask(const char* text, size_t length, ChannelSet<N>* out) {
+    if (length > 2 && text[0] == '0' && (text[1] | 0x20) == 'x') {
+      text += 2;
+      length -= 2;
+    }
+    if (length == 0) {
+      return false;
+    }
+    ChannelSet<N> mask;
+    for (size_t i = 0; i < length; i++) {
+      char c = text[length - 1 - i];
+      unsigned value;
+      if (c >= '0' && c <= '9') {
+        value = c - '0';
+      } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+        value = (c | 0x20) - 'a' + 10;
+      } else {
+        return false;
+      }
+      for (size_t b = 0; b < 4; b++) {
+        if (((value >> b) & 1) == 0) {
+          continue;
+        }
+        if (i * 4 + b >= N) {
+          return false;
+        }
+        mask.set(i * 4 + b);
+      }
+    }
+    *out = mask;
+    return true;
+  }
+
+  RelayBank<N>* bank_;
+  Request request_;
+  std::atomic<uint32_t> submitted_{0};
+  std::atomic<uint32_t> applied_{0};
+  size_t changed_ = 0;
+  uint32_t requests_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_RELAY_API_H_
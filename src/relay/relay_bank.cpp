@@ -0,0 +1,150 @@
+#include "relay/relay_bank.h"
+
+#include "relay/gpio_bank_output.h"
+#include "relay/hal.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+namespace {
+
+GpioBankOutput gpio_output;
+
+class GpioInput : public InputStage {
+ public:
+  void configure_input(int pin) override { hal::configure_input_pullup(pin); }
+  bool read_input(int pin) override { return hal::read_pin(pin); }
+};
+
+GpioInput gpio_input;
+
+}  // namespace
+
+RelayBankBase::RelayBankBase(RelayChannel* channels, size_t size,
+                             std::atomic<uint32_t>* state_words,
+                             uint32_t* committed_words)
+    : shadow_(state_words, size),
+      channels_(channels),
+      size_(size),
+      relay_output_(&gpio_output),
+      led_output_(&gpio_output),
+      button_input_(&gpio_input),
+      committed_(committed_words) {}
+
+void RelayBankBase::begin(const ChannelSpec* specs, bool initial_state) {
+  begin_with_states(specs, nullptr, initial_state);
+}
+
+void RelayBankBase::begin_with_states(const ChannelSpec* specs,
+                                      const uint32_t* state_words,
+                                      bool default_state) {
+  uint64_t now = hal::now_us();
+  for (size_t i = 0; i < size_; i++) {
+    RelayChannel& channel = channels_[i];
+    channel.begin(static_cast<uint8_t>(i), specs[i].pins, specs[i].sk_path);
+    if (channel.pins_.button != kNoPin) {
+      button_input_->configure_input(channel.pins_.button);
+    }
+    relay_output_->configure(channel.pins_.relay);
+    if (channel.pins_.led != kNoPin) {
+      led_output_->configure(channel.pins_.led);
+    }
+  }
+  // Configure every pin before reading any, so that a stage that applies
+  // its configuration in bulk does so once.
+  for (size_t i = 0; i < size_; i++) {
+    RelayChannel& channel = channels_[i];
+    if (channel.pins_.button != kNoPin) {
+      channel.button_level_ = button_input_->read_input(channel.pins_.button);
+    }
+    bool on = state_words != nullptr ? (state_words[i / 32] >> (i % 32)) & 1
+                                     : default_state;
+    stage(i, on, now);
+  }
+  commit_outputs(true);
+  RELAY_TRACE(kBoot, size_);
+  for (size_t i = 0; i < size_; i++) {
+    notify(channels_[i], ChangeSource::kBoot, now);
+  }
+}
+
+void RelayBankBase::add_observer(RelayObserver* observer) {
+  observer->next_observer_ = observers_;
+  observers_ = observer;
+}
+
+bool RelayBankBase::set(size_t index, bool on, ChangeSource source,
+                        uint64_t stamp_us) {
+  bool changed = stage(index, on, stamp_us);
+  commit_outputs();
+  RELAY_TRACE(kRelaySet, index, on, static_cast<uint32_t>(source));
+  notify(channels_[index], source, stamp_us);
+  return changed;
+}
+
+bool RelayBankBase::toggle(size_t index, ChangeSource source,
+                           uint64_t stamp_us) {
+  // Flipped in place rather than read and set, so that a concurrent command
+  // cannot slip in between.
+  bool on = shadow_.toggle(index);
+  touch(index, stamp_us);
+  commit_outputs();
+  RELAY_TRACE(kRelaySet, index, on, static_cast<uint32_t>(source));
+  notify(channels_[index], source, stamp_us);
+  return true;
+}
+
+void RelayBankBase::handle_button(size_t index, bool level,
+                                  uint64_t stamp_us) {
+  RelayChannel& channel = channels_[index];
+  if (level == channel.button_level_) {
+    return;
+  }
+  channel.button_level_ = level;
+  RELAY_TRACE(kButton, index, level);
+  if (level == kToggleLevel) {
+    toggle(index, ChangeSource::kButton, stamp_us);
+  }
+}
+
+bool RelayBankBase::stage(size_t index, bool on, uint64_t stamp_us) {
+  touch(index, stamp_us);
+  return shadow_.assign(index, on);
+}
+
+void RelayBankBase::commit_outputs(bool all) {
+  for (size_t w = 0; w < shadow_.word_count(); w++) {
+    uint32_t current = shadow_.word(w);
+    uint32_t diff = current ^ committed_[w];
+    if (all) {
+      size_t channels = size_ - w * 32;
+      diff = channels >= 32 ? ~uint32_t{0} : (uint32_t{1} << channels) - 1;
+    }
+    committed_[w] = current;
+    while (diff != 0) {
+      size_t bit = __builtin_ctz(diff);
+      diff &= diff - 1;
+      const ChannelPins& pins = channels_[w * 32 + bit].pins_;
+      bool on = (current >> bit) & 1;
+      relay_output_->stage(pins.relay, on);
+      if (pins.led != kNoPin) {
+        led_output_->stage(pins.led, on);
+      }
+    }
+  }
+  relay_output_->commit();
+  if (led_output_ != relay_output_) {
+    led_output_->commit();
+  }
+}
+
+void RelayBankBase::notify(const RelayChannel& channel, ChangeSource source,
+                           uint64_t stamp_us) {
+  RelayEvent event{channel, source, stamp_us};
+  for (RelayObserver* observer = observers_; observer != nullptr;
+       observer = observer->next_observer_) {
+    observer->on_relay_event(event);
+  }
+}
+
+}  // namespace relay_controller
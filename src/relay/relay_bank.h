@@ -0,0 +1,191 @@
+#ifndef RELAY_CONTROLLER_RELAY_RELAY_BANK_H_
+#define RELAY_CONTROLLER_RELAY_RELAY_BANK_H_
+
+// Heap-free replacement for the per-channel SensESP graph.
+//
+// A RelayBank<N> holds every channel in a fixed array sized at compile time.
+// Declared as a static, all per-channel state lands in .bss, and nothing
+// allocates once begin() has run.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/channel_set.h"
+#include "relay/input_stage.h"
+#include "relay/output_stage.h"
+#include "relay/relay_channel.h"
+#include "relay/shadow_state.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+// One channel's pins and default Signal K path. Can be constexpr, so that
+// a whole table is checked at compile time; see channel_table.h.
+struct ChannelSpec {
+  ChannelPins pins;
+  const char* sk_path;
+};
+
+// The part of a bank that does not depend on its size.
+class RelayBankBase {
+ public:
+  // The toggle fires when the button pin reads this level. With INPUT_PULLUP
+  // that is the release, which is what the SensESP graph did.
+  static constexpr bool kToggleLevel = true;
+
+  RelayBankBase(const RelayBankBase&) = delete;
+  RelayBankBase& operator=(const RelayBankBase&) = delete;
+
+  size_t size() const { return size_; }
+  RelayChannel& channel(size_t index) { return channels_[index]; }
+  const RelayChannel& channel(size_t index) const { return channels_[index]; }
+
+  // A channel's commanded relay state.
+  bool state(size_t index) const { return shadow_.test(index); }
+  // Every relay state, with a sequence number that counts the updates.
+  const ShadowState& shadow() const { return shadow_; }
+
+  // Drive relays and LEDs through these stages instead of the GPIO bank
+  // output. Call before begin(); the stages must outlive the bank.
+  void set_output_stages(OutputStage* relays, OutputStage* leds) {
+    relay_output_ = relays;
+    led_output_ = leds;
+  }
+
+  // Read buttons through this stage instead of the GPIOs. Call before
+  // begin(); the stage must outlive the bank.
+  void set_input_stage(InputStage* buttons) { button_input_ = buttons; }
+
+  // Configure the pins of every channel and drive the relays to
+  // initial_state. specs must hold size() entries; the sk_path strings they
+  // point to must outlive the bank.
+  void begin(const ChannelSpec* specs, bool initial_state);
+
+  void add_observer(RelayObserver* observer);
+
+  // Drive a relay and its LED. Observers are notified even when the state
+  // does not change, so that a PUT is always answered with a delta. Returns
+  // true if the state changed.
+  bool set(size_t index, bool on, ChangeSource source, uint64_t stamp_us);
+  bool toggle(size_t index, ChangeSource source, uint64_t stamp_us);
+
+  // Feed a button level seen at stamp_us, e.g. by EdgeCapture. Repeated
+  // levels are ignored; the toggle carries stamp_us through to observers.
+  void handle_button(size_t index, bool level, uint64_t stamp_us);
+
+  // Re-announce a channel's unchanged state, e.g. from HeartbeatWheel.
+  void refresh(size_t index, uint64_t stamp_us) {
+    notify(channels_[index], ChangeSource::kHeartbeat, stamp_us);
+  }
+
+ protected:
+  // state_words and committed_words hold one bit per channel.
+  RelayBankBase(RelayChannel* channels, size_t size,
+                std::atomic<uint32_t>* state_words, uint32_t* committed_words);
+
+  // begin() with channel i starting in bit i of state_words, or in
+  // default_state if state_words is null.
+  void begin_with_states(const ChannelSpec* specs, const uint32_t* state_words,
+                         bool default_state);
+
+  // Update a channel's state without touching the hardware. Returns true if
+  // the state changed.
+  bool stage(size_t index, bool on, uint64_t stamp_us);
+  void touch(size_t index, uint64_t stamp_us) {
+    channels_[index].last_change_us_ = stamp_us;
+  }
+  // Write the relays and LEDs whose state differs from the last commit in
+  // one go, or every one if all is set. Call from one task at a time.
+  void commit_outputs(bool all = false);
+
+  ShadowState shadow_;
+  void notify(const RelayChannel& channel, ChangeSource source,
+              uint64_t stamp_us);
+
+ private:
+  RelayChannel* channels_;
+  size_t size_;
+  OutputStage* relay_output_;
+  OutputStage* led_output_;
+  InputStage* button_input_;
+  // The shadow words as the pins were last written.
+  uint32_t* committed_;
+  RelayObserver* observers_ = nullptr;
+};
+
+template <size_t N>
+class RelayBank : public RelayBankBase {
+ public:
+  static_assert(N > 0 && N <= 256, "channel indices are stored in a uint8_t");
+
+  static constexpr size_t kChannels = N;
+  static constexpr size_t kBytesPerChannel = sizeof(RelayChannel);
+
+  RelayBank()
+      : RelayBankBase(channels_, N, state_words_, committed_words_) {}
+
+  using RelayBankBase::begin;
+  // Start each channel in its bit of initial_states, e.g. as restored from
+  // a StateJournal.
+  void begin(const ChannelSpec* specs, const ChannelSet<N>& initial_states) {
+    begin_with_states(specs, initial_states.words(), false);
+  }
+
+  // Copy every relay state into out, consistent across channels, see
+  // ShadowState::snapshot().
+  bool states(ChannelSet<N>* out, uint32_t* sequence = nullptr) const {
+    uint32_t words[kWords];
+    if (!shadow_.snapshot(words, sequence)) {
+      return false;
+    }
+    for (size_t w = 0; w < kWords; w++) {
+      out->set_word(w, words[w]);
+    }
+    return true;
+  }
+
+  // Switch every channel in members to its bit in states with one commit,
+  // so that the whole group changes at the same moment. Returns the number
+  // of relays that changed.
+  size_t set_group(const ChannelSet<N>& members, const ChannelSet<N>& states,
+                   ChangeSource source, uint64_t stamp_us) {
+    size_t count = 0;
+    size_t changed = 0;
+    {
+      // One update across all words, so that no snapshot sees half a group.
+      ShadowState::Update update(&shadow_);
+      for (size_t w = 0; w < kWords; w++) {
+        changed += __builtin_popcount(
+            shadow_.apply_word(w, members.word(w), states.word(w)));
+      }
+    }
+    members.for_each([&](size_t i) {
+      count++;
+      touch(i, stamp_us);
+    });
+    commit_outputs();
+    RELAY_TRACE(kGroupSet, count, changed, static_cast<uint32_t>(source));
+    members.for_each(
+        [&](size_t i) { notify(this->channel(i), source, stamp_us); });
+    return changed;
+  }
+
+ private:
+  static constexpr size_t kWords = ChannelSet<N>::kWords;
+
+  RelayChannel channels_[N];
+  std::atomic<uint32_t> state_words_[kWords] = {};
+  uint32_t committed_words_[kWords] = {};
+};
+
+// Keep an eye on the bank's per-channel footprint: 24 bytes on the ESP32
+// and on a 64-bit host, plus two bits of shadow state. The stages around
+// the bank add their own, LatencyMonitor 5 bytes for instance, and the
+// boot log reports what each takes.
+static_assert(sizeof(RelayChannel) <= 16 + 2 * sizeof(void*),
+              "RelayChannel grew past its per-channel budget");
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_RELAY_BANK_H_
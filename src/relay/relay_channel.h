@@ -0,0 +1,80 @@
+#ifndef RELAY_CONTROLLER_RELAY_RELAY_CHANNEL_H_
+#define RELAY_CONTROLLER_RELAY_RELAY_CHANNEL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace relay_controller {
+
+// Where a relay state change came from.
+enum class ChangeSource : uint8_t {
+  kBoot,
+  kButton,
+  kRemote,
+  kHeartbeat,
+};
+
+// A button or LED pin of kNoPin means the channel has no button, i.e. is
+// only switched remotely, or no status LED.
+constexpr uint16_t kNoPin = 0xffff;
+
+struct ChannelPins {
+  uint16_t button;
+  uint16_t led;
+  uint16_t relay;
+};
+
+// Run-time state of one button -> relay -> LED -> Signal K channel. The
+// relay state itself is in the bank's ShadowState; see RelayBank::state().
+//
+// Channels are plain values owned by a RelayBank; they never allocate.
+class RelayChannel {
+ public:
+  void begin(uint8_t index, const ChannelPins& pins, const char* sk_path) {
+    index_ = index;
+    pins_ = pins;
+    sk_path_ = sk_path;
+  }
+
+  uint8_t index() const { return index_; }
+  const ChannelPins& pins() const { return pins_; }
+  const char* sk_path() const { return sk_path_; }
+
+  bool button_level() const { return button_level_; }
+  uint64_t last_change_us() const { return last_change_us_; }
+
+ private:
+  friend class RelayBankBase;
+
+  const char* sk_path_ = nullptr;
+  uint64_t last_change_us_ = 0;
+  ChannelPins pins_{};
+  uint8_t index_ = 0;
+  bool button_level_ = true;
+};
+
+// A relay state change or heartbeat as seen by RelayObservers.
+struct RelayEvent {
+  const RelayChannel& channel;
+  ChangeSource source;
+  // When the change was triggered, e.g. the button edge.
+  uint64_t stamp_us;
+};
+
+// Receives every relay change and heartbeat of a bank.
+//
+// Observers are linked into the bank intrusively so that registering one
+// does not allocate. They must outlive the bank.
+class RelayObserver {
+ public:
+  virtual ~RelayObserver() = default;
+  virtual void on_relay_event(const RelayEvent& event) = 0;
+
+ private:
+  friend class RelayBankBase;
+  RelayObserver* next_observer_ = nullptr;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_RELAY_CHANNEL_H_
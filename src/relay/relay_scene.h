@@ -0,0 +1,135 @@
+#ifndef RELAY_CONTROLLER_RELAY_RELAY_SCENE_H_
+#define RELAY_CONTROLLER_RELAY_RELAY_SCENE_H_
+
+// A named set of relay states that is applied as one group.
+//
+// Scenes are written as text so they can be edited in the web UI: a comma
+// separated list of "<relay number>=<on|off>" entries, with relays numbered
+// from 1 as they are in the UI, e.g. "1=on,2=on,4=off". Relays the scene does
+// not mention are left alone.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/channel_set.h"
+#include "relay/json_writer.h"
+#include "relay/relay_bank.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class RelayScene {
+ public:
+  // Replace the scene with the one spec describes. On a malformed spec the
+  // scene is left unchanged and false is returned.
+  bool parse(const char* spec) {
+    ChannelSet<N> members;
+    ChannelSet<N> states;
+    const char* p = spec;
+    while (*p != '\0') {
+      p = skip_spaces(p);
+      if (*p == '\0') {
+        break;
+      }
+      size_t number = 0;
+      const char* digits = p;
+      while (*p >= '0' && *p <= '9') {
+        number = number * 10 + (*p++ - '0');
+        if (number > N) {
+          return false;
+        }
+      }
+      if (p == digits || number == 0) {
+        return false;
+      }
+      p = skip_spaces(p);
+      if (*p++ != '=') {
+        return false;
+      }
+      p = skip_spaces(p);
+      bool on;
+      if (match(&p, "on")) {
+        on = true;
+      } else if (match(&p, "off")) {
+        on = false;
+      } else {
+        return false;
+      }
+      members.set(number - 1);
+      states.assign(number - 1, on);
+      p = skip_spaces(p);
+      if (*p == ',') {
+        p++;
+      } else if (*p != '\0') {
+        return false;
+      }
+    }
+    members_ = members;
+    states_ = states;
+    return true;
+  }
+
+  // Write the scene back out in the form parse() reads.
+  bool format(JsonWriter* writer) const {
+    bool first = true;
+    members_.for_each([&](size_t channel) {
+      char number[4];
+      size_t length = 0;
+      for (size_t n = channel + 1; n > 0; n /= 10) {
+        length++;
+      }
+      for (size_t n = channel + 1, i = length; i > 0; n /= 10) {
+        number[--i] = static_cast<char>('0' + n % 10);
+      }
+      number[length] = '\0';
+      writer->raw(first ? "" : ",")
+          .raw(number)
+          .raw(states_.test(channel) ? "=on" : "=off");
+      first = false;
+    });
+    return writer->ok();
+  }
+
+  // Switch the scene's relays as one group. With on false, every relay in
+  // the scene is switched off instead, so that a scene can be undone.
+  // Returns the number of relays that changed.
+  size_t apply(RelayBank<N>* bank, bool on, ChangeSource source,
+               uint64_t stamp_us) const {
+    if (!members_.any()) {
+      return 0;
+    }
+    return bank->set_group(members_, on ? states_ : ChannelSet<N>(), source,
+                           stamp_us);
+  }
+
+  const ChannelSet<N>& members() const { return members_; }
+  const ChannelSet<N>& states() const { return states_; }
+
+ private:
+  static const char* skip_spaces(const char* p) {
+    while (*p == ' ') {
+      p++;
+    }
+    return p;
+  }
+
+  static bool match(const char** p, const char* word) {
+    const char* q = *p;
+    while (*word != '\0') {
+      if ((*q | 0x20) != *word) {
+        return false;
+      }
+      q++;
+      word++;
+    }
+    *p = q;
+    return true;
+  }
+
+  ChannelSet<N> members_;
+  ChannelSet<N> states_;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_RELAY_SCENE_H_
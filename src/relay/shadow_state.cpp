@@ -0,0 +1,40 @@
+#include "relay/shadow_state.h"
+
+namespace relay_controller {
+
+uint32_t ShadowState::apply_word(size_t w, uint32_t members,
+                                 uint32_t states) {
+  Update update(this);
+  std::atomic<uint32_t>& word = words_[w];
+  uint32_t before = word.load(std::memory_order_relaxed);
+  uint32_t after;
+  do {
+    after = (before & ~members) | (states & members);
+  } while (before != after &&
+           !word.compare_exchange_weak(before, after,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed));
+  return before ^ after;
+}
+
+bool ShadowState::snapshot(uint32_t* out, uint32_t* sequence) const {
+  for (int attempt = 0; attempt < kSnapshotAttempts; attempt++) {
+    uint32_t before = sequence_.load(std::memory_order_acquire);
+    if (writers_.load(std::memory_order_acquire) != 0) {
+      continue;
+    }
+    for (size_t w = 0; w < word_count_; w++) {
+      out[w] = words_[w].load(std::memory_order_acquire);
+    }
+    if (writers_.load(std::memory_order_acquire) == 0 &&
+        sequence_.load(std::memory_order_acquire) == before) {
+      if (sequence != nullptr) {
+        *sequence = before;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace relay_controller
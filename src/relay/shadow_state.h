@@ -0,0 +1,95 @@
+#ifndef RELAY_CONTROLLER_RELAY_SHADOW_STATE_H_
+#define RELAY_CONTROLLER_RELAY_SHADOW_STATE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace relay_controller {
+
+// The commanded state of every relay in a bank, one bit per channel, and a
+// sequence number that counts the updates.
+//
+// This is the only copy of the relay states: toggles, PUTs, scenes,
+// heartbeats and the LEDs all read it, and RelayBank computes the pins to
+// write as the difference from the last committed words. Updates are
+// compare-and-swap on the word holding the channel, so command sources on
+// different tasks never lose each other's changes.
+//
+// The storage is owned by the caller, as RelayBank<N> sizes it.
+class ShadowState {
+ public:
+  ShadowState(std::atomic<uint32_t>* words, size_t channels)
+      : words_(words), word_count_((channels + 31) / 32) {}
+
+  size_t word_count() const { return word_count_; }
+
+  uint32_t word(size_t w) const {
+    return words_[w].load(std::memory_order_acquire);
+  }
+
+  bool test(size_t channel) const {
+    return (words_[channel / 32].load(std::memory_order_acquire) &
+            bit(channel)) != 0;
+  }
+
+  // Set a channel's state. Returns true if it changed.
+  bool assign(size_t channel, bool on) {
+    uint32_t mask = bit(channel);
+    return apply_word(channel / 32, mask, on ? mask : 0) != 0;
+  }
+
+  // Flip a channel's state and return the new one.
+  bool toggle(size_t channel) {
+    Update update(this);
+    uint32_t before = words_[channel / 32].fetch_xor(
+        bit(channel), std::memory_order_acq_rel);
+    return (before & bit(channel)) == 0;
+  }
+
+  // Give the members of word w the state of their bit in states. Returns the
+  // bits that changed.
+  uint32_t apply_word(size_t w, uint32_t members, uint32_t states);
+
+  // Copy every word into out as one consistent state, i.e. with no update
+  // half in the copy, and store the sequence number it belongs to. Returns
+  // false if an update was in flight on every attempt, e.g. because the
+  // task making it was preempted; try again later rather than spin.
+  bool snapshot(uint32_t* out, uint32_t* sequence = nullptr) const;
+
+  uint32_t sequence() const {
+    return sequence_.load(std::memory_order_acquire);
+  }
+
+  // Brackets an update. Updates nest, so holding one across several
+  // apply_word() calls keeps snapshot() from seeing only some of them.
+  class Update {
+   public:
+    explicit Update(ShadowState* state) : state_(state) {
+      state_->writers_.fetch_add(1, std::memory_order_acq_rel);
+    }
+    ~Update() {
+      state_->sequence_.fetch_add(1, std::memory_order_release);
+      state_->writers_.fetch_sub(1, std::memory_order_release);
+    }
+    Update(const Update&) = delete;
+    Update& operator=(const Update&) = delete;
+
+   private:
+    ShadowState* state_;
+  };
+
+ private:
+  static constexpr int kSnapshotAttempts = 8;
+
+  static uint32_t bit(size_t channel) { return uint32_t{1} << (channel % 32); }
+
+  std::atomic<uint32_t>* words_;
+  size_t word_count_;
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<uint32_t> writers_{0};
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_SHADOW_STATE_H_
@@ -0,0 +1,89 @@
+#ifndef RELAY_CONTROLLER_RELAY_SHIFT_REGISTER_OUTPUT_H_
+#define RELAY_CONTROLLER_RELAY_SHIFT_REGISTER_OUTPUT_H_
+
+// Relays on a chain of 74HC595 shift registers.
+//
+// Output pin n is Q(n % 8) of register n / 8, register 0 being the one
+// wired to the MCU. Changes are only staged by commit(); flush() shifts the
+// whole chain out in one transfer and latches it, so every relay switched
+// in a tick changes at the same moment for the cost of one SPI transfer.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/output_stage.h"
+
+namespace relay_controller {
+
+// Shifts bytes into the chain and latches them: SPI with DMA on the device,
+// sim::SimShiftChain on the host.
+class ShiftRegisterBus {
+ public:
+  virtual ~ShiftRegisterBus() = default;
+
+  // Shift out data, first byte first and MSB first, then latch. May return
+  // before the transfer has finished; the next call waits for it.
+  virtual bool transfer(const uint8_t* data, size_t length) = 0;
+};
+
+class ShiftRegisterOutput : public OutputStage {
+ public:
+  static constexpr size_t kMaxRegisters = 16;
+
+  ShiftRegisterOutput(ShiftRegisterBus* bus, size_t registers)
+      : bus_(bus),
+        registers_(registers < kMaxRegisters ? registers : kMaxRegisters) {}
+
+  // Every register output is an output.
+  void configure(int pin) override {}
+
+  void stage(int pin, bool level) override {
+    uint8_t bit = static_cast<uint8_t>(1u << (pin % 8));
+    uint8_t& byte = staged_[pin / 8];
+    byte = level ? byte | bit : byte & ~bit;
+  }
+
+  // Nothing is written until flush().
+  void commit() override {}
+
+  // Shift the chain out if anything changed since the last flush. The
+  // first call always does, as the registers power up with random
+  // contents. Call once per event loop tick, after the reactions that
+  // switch relays.
+  void flush() {
+    bool changed = !flushed_;
+    for (size_t r = 0; r < registers_; r++) {
+      changed |= staged_[r] != written_[r];
+    }
+    if (!changed) {
+      return;
+    }
+    // The byte for the far end of the chain goes first.
+    uint8_t frame[kMaxRegisters];
+    for (size_t r = 0; r < registers_; r++) {
+      frame[registers_ - 1 - r] = staged_[r];
+    }
+    if (bus_->transfer(frame, registers_)) {
+      for (size_t r = 0; r < registers_; r++) {
+        written_[r] = staged_[r];
+      }
+      flushed_ = true;
+      transfers_++;
+    }
+  }
+
+  size_t pin_count() const { return registers_ * 8; }
+  uint32_t transfers() const { return transfers_; }
+
+ private:
+  ShiftRegisterBus* bus_;
+  size_t registers_;
+  uint8_t staged_[kMaxRegisters] = {};
+  uint8_t written_[kMaxRegisters] = {};
+  bool flushed_ = false;
+  uint32_t transfers_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_SHIFT_REGISTER_OUTPUT_H_
@@ -0,0 +1,47 @@
+#include "relay/sk_timestamp.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "relay/hal.h"
+
+namespace relay_controller {
+
+bool format_sk_timestamp(uint64_t stamp_us, char* out, size_t size) {
+  if (size > 0) {
+    out[0] = '\0';
+  }
+  uint64_t wall_us = sk_wall_time_us(stamp_us);
+  if (wall_us == 0 || size < kSKTimestampSize) {
+    return false;
+  }
+  format_sk_wall_time(wall_us, out);
+  return true;
+}
+
+uint64_t sk_wall_time_us(uint64_t stamp_us) {
+  uint64_t wall_us = hal::wall_time_us();
+  // Move back from now to when the event happened.
+  uint64_t age_us = hal::now_us() - stamp_us;
+  if (wall_us != 0 && age_us < wall_us) {
+    wall_us -= age_us;
+  }
+  return wall_us;
+}
+
+void format_sk_wall_time(uint64_t wall_us, char* out) {
+  time_t seconds = static_cast<time_t>(wall_us / 1000000);
+  struct tm utc;
+  gmtime_r(&seconds, &utc);
+  // Room for any int the compiler thinks the fields might hold.
+  char text[64];
+  snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02d.%03uZ",
+           utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour,
+           utc.tm_min, utc.tm_sec,
+           static_cast<unsigned>(wall_us / 1000 % 1000));
+  memcpy(out, text, kSKTimestampSize - 1);
+  out[kSKTimestampSize - 1] = '\0';
+}
+
+}  // namespace relay_controller
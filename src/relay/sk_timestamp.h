@@ -0,0 +1,26 @@
+#ifndef RELAY_CONTROLLER_RELAY_SK_TIMESTAMP_H_
+#define RELAY_CONTROLLER_RELAY_SK_TIMESTAMP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace relay_controller {
+
+// Length of "2024-01-31T12:34:56.789Z" plus the terminator.
+constexpr size_t kSKTimestampSize = 25;
+
+// Format a time on the hal::now_us() scale as a Signal K (ISO 8601 UTC)
+// timestamp. Returns false, leaving out empty, while the wall clock has not
+// been set yet.
+bool format_sk_timestamp(uint64_t stamp_us, char* out, size_t size);
+
+// Wall clock time in microseconds since the epoch at stamp_us, or 0 while
+// the wall clock has not been set.
+uint64_t sk_wall_time_us(uint64_t stamp_us);
+
+// Format a wall clock time; out has room for kSKTimestampSize bytes.
+void format_sk_wall_time(uint64_t wall_us, char* out);
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_SK_TIMESTAMP_H_
@@ -0,0 +1,79 @@
+#ifndef RELAY_CONTROLLER_RELAY_SPSC_RING_H_
+#define RELAY_CONTROLLER_RELAY_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/hal.h"
+
+namespace relay_controller {
+
+// Lock-free single-producer/single-consumer ring buffer.
+//
+// push() may be called from an interrupt handler and pop() from the event
+// loop. Neither blocks nor allocates. When the ring is full, push() drops
+// the new item and counts it as an overflow rather than overwrite data the
+// consumer has not seen yet.
+template <typename T, size_t Capacity>
+class SpscRing {
+ public:
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+  // Producer side.
+  RELAY_ISR_INLINE bool push(const T& item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+    uint32_t used = head - tail;
+    if (used == Capacity) {
+      overflows_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    items_[head & kMask] = item;
+    head_.store(head + 1, std::memory_order_release);
+    if (used + 1 > high_water_.load(std::memory_order_relaxed)) {
+      high_water_.store(used + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Consumer side.
+  bool pop(T* item) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *item = items_[tail & kMask];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+  static constexpr size_t capacity() { return Capacity; }
+
+  // Items dropped because the ring was full.
+  uint32_t overflows() const {
+    return overflows_.load(std::memory_order_relaxed);
+  }
+  // Largest fill level seen since boot.
+  uint32_t high_water() const {
+    return high_water_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr uint32_t kMask = Capacity - 1;
+
+  T items_[Capacity];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> overflows_{0};
+  std::atomic<uint32_t> high_water_{0};
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_SPSC_RING_H_
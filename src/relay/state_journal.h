@@ -0,0 +1,291 @@
+#ifndef RELAY_CONTROLLER_RELAY_STATE_JOURNAL_H_
+#define RELAY_CONTROLLER_RELAY_STATE_JOURNAL_H_
+
+// Append-only journal of relay states in NOR flash, so that relays come
+// back the way they were after a power cut.
+//
+// Every change is appended as a 4-byte record to the active sector. When it
+// fills up, the journal moves on to the next sector, which starts with a
+// snapshot of every channel, so sectors are used round robin and wear is
+// spread evenly. A sector is erased well before it is needed, once the
+// active one is half full, so a rollover only writes. Each change costs 4
+// bytes plus its share of the snapshot, 4 * N bytes per sector.
+//
+// Restoring needs no full scan: a binary search finds the end of the
+// active sector, and reading backwards from there stops as soon as every
+// channel has been seen, at the latest at the snapshot.
+//
+// Flash writes happen in tick(), not when the relay switches, and at most
+// once per write interval, 1 s by default: a relay that changed several
+// times since the last write gets one record with its latest state. That
+// bounds the wear whatever the relays do: each channel costs at most one
+// record a second. One relay toggling without end thus costs about 85
+// sector erases a day, which spread over the four 4 KiB sectors of the
+// relaylog partition is over 12 years of 100000-cycle flash. A power cut
+// loses at most the changes of the last interval.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/channel_set.h"
+#include "relay/hal.h"
+#include "relay/journal_flash.h"
+#include "relay/relay_bank.h"
+#include "relay/trace.h"
+
+namespace relay_controller {
+
+template <size_t N>
+class StateJournal : public RelayObserver {
+ public:
+  static_assert(N <= 255, "channel 0xff would read as erased flash");
+
+  static constexpr uint32_t kDefaultWriteIntervalUs = 1000000;
+
+  // Find the newest sector and read the saved states. Returns true if a
+  // journal was found; channels it does not mention get default_state. A
+  // flash too small to hold two sectors of 2 * N records disables the
+  // journal. Call before RelayBank::begin(), which takes states().
+  bool begin(JournalFlash* flash, bool default_state) {
+    flash_ = flash;
+    uint64_t start = hal::now_us();
+    for (size_t i = 0; i < N; i++) {
+      states_.assign(i, default_state);
+    }
+    slots_ = (flash_->sector_size() - sizeof(SectorHeader)) / kRecordSize;
+    if (flash_->sector_count() < 2 || slots_ < 2 * N + 2) {
+      flash_ = nullptr;
+      return false;
+    }
+    for (size_t s = 0; s < flash_->sector_count(); s++) {
+      SectorHeader header;
+      if (flash_->read(s * flash_->sector_size(), &header, sizeof(header)) &&
+          header.magic == kMagic &&
+          (active_ == kNoSector || header.generation > generation_)) {
+        active_ = s;
+        generation_ = header.generation;
+      }
+    }
+    if (active_ == kNoSector) {
+      return false;
+    }
+    tail_ = find_tail();
+    ChannelSet<N> seen;
+    size_t remaining = N;
+    for (size_t slot = tail_; slot > 0 && remaining > 0; slot--) {
+      uint8_t channel;
+      bool on;
+      if (decode(read_slot(slot - 1), &channel, &on) && !seen.test(channel)) {
+        seen.set(channel);
+        states_.assign(channel, on);
+        journaled_.assign(channel, on);
+        remaining--;
+      }
+    }
+    known_ = seen;
+    restore_us_ = static_cast<uint32_t>(hal::now_us() - start);
+    RELAY_TRACE(kJournalRestore, N - remaining, active_, restore_us_);
+    return true;
+  }
+
+  // The states read by begin().
+  const ChannelSet<N>& states() const { return states_; }
+
+  // Start journaling bank's changes. Creates the journal if begin() found
+  // none.
+  void attach(RelayBank<N>* bank) {
+    bank_ = bank;
+    bank_->add_observer(this);
+    if (flash_ == nullptr) {
+      return;
+    }
+    for (size_t i = 0; i < N; i++) {
+      if (!known_.test(i) || journaled_.test(i) != bank_->state(i)) {
+        pending_.set(i);
+      }
+    }
+    if (active_ == kNoSector) {
+      start_sector(0, 1);
+    }
+  }
+
+  void on_relay_event(const RelayEvent& event) override {
+    if (event.source != ChangeSource::kHeartbeat &&
+        event.source != ChangeSource::kBoot) {
+      pending_.set(event.channel.index());
+    }
+  }
+
+  // Write the latest state of every channel that changed since the last
+  // write, unless that was less than the write interval ago. Call once per
+  // event loop tick.
+  void tick() {
+    if (flash_ == nullptr || !pending_.any()) {
+      return;
+    }
+    uint64_t now = hal::now_us();
+    if (static_cast<int64_t>(now - next_write_us_) < 0) {
+      return;
+    }
+    uint32_t written = changes_written_;
+    pending_.for_each([&](size_t channel) {
+      bool on = bank_->state(channel);
+      if (!known_.test(channel) || journaled_.test(channel) != on) {
+        append(static_cast<uint8_t>(channel), on);
+      }
+    });
+    pending_.clear();
+    // Changes that came back to the journaled state start no interval.
+    if (changes_written_ != written) {
+      next_write_us_ = now + write_interval_us_;
+    }
+  }
+
+  // The least time between two writes. 0 writes every change on the next
+  // tick.
+  void set_write_interval_us(uint32_t us) { write_interval_us_ = us; }
+
+  // Erase the next sector ahead of time. Erasing blocks for tens of
+  // milliseconds, so call it from a slow periodic reaction, not per tick.
+  void maintain() {
+    if (flash_ != nullptr && active_ != kNoSector && !next_erased_ &&
+        tail_ >= slots_ / 2) {
+      erase(next_sector());
+    }
+  }
+
+  uint32_t changes_written() const { return changes_written_; }
+  uint32_t bytes_written() const { return bytes_written_; }
+  uint32_t sectors_erased() const { return sectors_erased_; }
+  uint32_t restore_us() const { return restore_us_; }
+  bool enabled() const { return flash_ != nullptr; }
+
+ private:
+  struct SectorHeader {
+    uint32_t magic;
+    uint32_t generation;
+  };
+
+  static constexpr uint32_t kMagic = 0x314a5352;  // "RSJ1"
+  static constexpr size_t kRecordSize = 4;
+  static constexpr uint32_t kErased = 0xffffffff;
+  static constexpr size_t kNoSector = SIZE_MAX;
+
+  // channel, state, then a check of both; never all ones.
+  static uint32_t encode(uint8_t channel, bool on) {
+    uint32_t value = channel | (on ? 1u << 8 : 0u);
+    return value | (~value & 0xffff) << 16;
+  }
+  static bool decode(uint32_t record, uint8_t* channel, bool* on) {
+    uint32_t value = record & 0xffff;
+    if ((record >> 16) != (~value & 0xffff) || (value >> 8) > 1 ||
+        (value & 0xff) >= N) {
+      return false;
+    }
+    *channel = value & 0xff;
+    *on = (value >> 8) != 0;
+    return true;
+  }
+
+  size_t slot_offset(size_t sector, size_t slot) const {
+    return sector * flash_->sector_size() + sizeof(SectorHeader) +
+           slot * kRecordSize;
+  }
+
+  uint32_t read_slot(size_t slot) const {
+    uint32_t record = kErased;
+    flash_->read(slot_offset(active_, slot), &record, sizeof(record));
+    return record;
+  }
+
+  // Records are written in order, so the erased slots form a suffix.
+  size_t find_tail() const {
+    size_t low = 0;
+    size_t high = slots_;
+    while (low < high) {
+      size_t mid = low + (high - low) / 2;
+      if (read_slot(mid) == kErased) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    return low;
+  }
+
+  size_t next_sector() const { return (active_ + 1) % flash_->sector_count(); }
+
+  void erase(size_t sector) {
+    if (flash_->erase_sector(sector)) {
+      sectors_erased_++;
+      next_erased_ = true;
+    }
+  }
+
+  void append(uint8_t channel, bool on) {
+    if (tail_ == slots_) {
+      start_sector(next_sector(), generation_ + 1);
+      // The snapshot already holds the new state.
+      if (journaled_.test(channel) == on && known_.test(channel)) {
+        return;
+      }
+    }
+    uint32_t record = encode(channel, on);
+    if (flash_->write(slot_offset(active_, tail_), &record, sizeof(record))) {
+      tail_++;
+      bytes_written_ += sizeof(record);
+      changes_written_++;
+      journaled_.assign(channel, on);
+      known_.set(channel);
+    }
+  }
+
+  // Write a snapshot of every channel into sector, then the header that
+  // makes it the active one. Until the header is written the old sector
+  // stays current, so a power cut in between loses nothing.
+  void start_sector(size_t sector, uint32_t generation) {
+    if (!next_erased_ || sector != next_sector() || active_ == kNoSector) {
+      erase(sector);
+    }
+    for (size_t i = 0; i < N; i++) {
+      bool on = bank_->state(i);
+      uint32_t record = encode(static_cast<uint8_t>(i), on);
+      flash_->write(slot_offset(sector, i), &record, sizeof(record));
+      journaled_.assign(i, on);
+    }
+    SectorHeader header{kMagic, generation};
+    flash_->write(sector * flash_->sector_size(), &header, sizeof(header));
+    bytes_written_ += N * kRecordSize + sizeof(header);
+    for (size_t i = 0; i < N; i++) {
+      known_.set(i);
+    }
+    active_ = sector;
+    generation_ = generation;
+    tail_ = N;
+    next_erased_ = false;
+    RELAY_TRACE(kJournalRollover, sector, generation);
+  }
+
+  JournalFlash* flash_ = nullptr;
+  RelayBank<N>* bank_ = nullptr;
+  size_t slots_ = 0;
+  size_t active_ = kNoSector;
+  uint32_t generation_ = 0;
+  size_t tail_ = 0;
+  bool next_erased_ = false;
+  ChannelSet<N> states_;
+  // What the journal holds for each channel it has a record of.
+  ChannelSet<N> journaled_;
+  ChannelSet<N> known_;
+  ChannelSet<N> pending_;
+  uint32_t write_interval_us_ = kDefaultWriteIntervalUs;
+  uint64_t next_write_us_ = 0;
+  uint32_t changes_written_ = 0;
+  uint32_t bytes_written_ = 0;
+  uint32_t sectors_erased_ = 0;
+  uint32_t restore_us_ = 0;
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_STATE_JOURNAL_H_
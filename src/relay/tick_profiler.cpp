@@ -0,0 +1,139 @@
+#include "relay/tick_profiler.h"
+
+#include "relay/json_writer.h"
+
+namespace relay_controller {
+
+namespace {
+
+constexpr const char* kReactionPrefix =
+    "sensors.relaycontroller.eventLoop.reaction.";
+
+// Open {"path":"<prefix><name><suffix>","value": for the value to follow.
+void begin_value(JsonWriter* writer, size_t* values, const char* prefix,
+                 const char* name, const char* suffix = "") {
+  writer->raw(*values == 0 ? "{\"path\":\"" : ",{\"path\":\"")
+      .raw(prefix)
+      .raw(name)
+      .raw(suffix)
+      .raw("\",\"value\":");
+  (*values)++;
+}
+
+}  // namespace
+
+uint8_t TickProfiler::add_section(const char* name) {
+  if (section_count_ == kMaxSections) {
+    return kNoSection;
+  }
+  sections_[section_count_] = {name, 0, 0, 0};
+  return section_count_++;
+}
+
+void TickProfiler::record(uint8_t section, uint32_t elapsed_us) {
+  if (tick_sections_ < 0xff) {
+    tick_sections_++;
+  }
+  if (section == kNoSection) {
+    return;
+  }
+  Section& s = sections_[section];
+  s.calls++;
+  s.total_us += elapsed_us;
+  if (elapsed_us > s.max_us) {
+    s.max_us = elapsed_us;
+  }
+  if (elapsed_us >= tick_worst_us_) {
+    tick_worst_us_ = elapsed_us;
+    tick_worst_section_ = section;
+  }
+}
+
+void TickProfiler::finish_tick(uint32_t tick_us) {
+  tick_histogram_.record(tick_us);
+  if (tick_sections_ > max_sections_per_tick_) {
+    max_sections_per_tick_ = tick_sections_;
+  }
+  if (tick_us < overrun_us_) {
+    return;
+  }
+  overruns_++;
+  window_overruns_++;
+  if (overrun_handler_ != nullptr) {
+    const char* worst = tick_worst_section_ == kNoSection
+                            ? nullptr
+                            : sections_[tick_worst_section_].name;
+    overrun_handler_(tick_us, worst, tick_worst_us_);
+  }
+}
+
+bool TickProfiler::publish(DeltaSink* sink) {
+  if (!enabled_) {
+    return false;
+  }
+  JsonWriter writer(buffer_, sizeof(buffer_));
+  writer.raw("{\"updates\":[{\"values\":[");
+  size_t values = 0;
+  begin_value(&writer, &values, kPathPrefix, "tick.p50");
+  writer.seconds(tick_histogram_.percentile(50)).raw("}");
+  begin_value(&writer, &values, kPathPrefix, "tick.p99");
+  writer.seconds(tick_histogram_.percentile(99)).raw("}");
+  begin_value(&writer, &values, kPathPrefix, "tick.max");
+  writer.seconds(tick_histogram_.max_us()).raw("}");
+  begin_value(&writer, &values, kPathPrefix, "ticks");
+  writer.unsigned_integer(tick_histogram_.count()).raw("}");
+  begin_value(&writer, &values, kPathPrefix, "reactionsPerTick.max");
+  writer.unsigned_integer(max_sections_per_tick_).raw("}");
+  begin_value(&writer, &values, kPathPrefix, "overruns");
+  writer.unsigned_integer(overruns_).raw("}");
+
+  const Section* worst = nullptr;
+  for (size_t i = 0; i < section_count_; i++) {
+    const Section& s = sections_[i];
+    if (s.calls == 0) {
+      continue;
+    }
+    if (worst == nullptr || s.max_us > worst->max_us) {
+      worst = &s;
+    }
+    begin_value(&writer, &values, kReactionPrefix, s.name, ".max");
+    writer.seconds(s.max_us).raw("}");
+    begin_value(&writer, &values, kReactionPrefix, s.name, ".time");
+    writer.seconds(s.total_us).raw("}");
+  }
+  if (worst != nullptr) {
+    begin_value(&writer, &values, kPathPrefix, "worstReaction");
+    writer.string(worst->name).raw("}");
+  }
+
+  // Raise the notification while overruns keep happening; clear it once.
+  bool raise = window_overruns_ > 0;
+  if (raise || overrun_raised_) {
+    begin_value(&writer, &values, "", kOverrunPath);
+    writer.raw(raise ? "{\"state\":\"warn\",\"method\":[\"visual\"],"
+                       "\"message\":\"Event loop tick over budget\"}}"
+                     : "{\"state\":\"normal\",\"method\":[],"
+                       "\"message\":\"Event loop tick within budget\"}}");
+  }
+  writer.raw("]}]}");
+
+  if (!writer.ok() || !sink->send_delta(writer.c_str(), writer.length())) {
+    return false;
+  }
+  overrun_raised_ = raise;
+  clear_window();
+  return true;
+}
+
+void TickProfiler::clear_window() {
+  tick_histogram_.clear();
+  max_sections_per_tick_ = 0;
+  window_overruns_ = 0;
+  for (size_t i = 0; i < section_count_; i++) {
+    sections_[i].calls = 0;
+    sections_[i].max_us = 0;
+    sections_[i].total_us = 0;
+  }
+}
+
+}  // namespace relay_controller
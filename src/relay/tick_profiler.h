@@ -0,0 +1,136 @@
+#ifndef RELAY_CONTROLLER_RELAY_TICK_PROFILER_H_
+#define RELAY_CONTROLLER_RELAY_TICK_PROFILER_H_
+
+// Times event loop ticks and the reactions run inside them.
+//
+// loop() brackets each tick with begin_tick() and end_tick(). Reactions are
+// registered as named sections, either by wrapping the callback passed to
+// the event loop with profiled() or by running code through run(). For
+// every publishing window the profiler keeps a histogram of tick durations,
+// the most sections run in one tick and each section's calls, total and
+// worst time. A tick longer than the overrun threshold is counted and
+// reported to the overrun handler with the section that took longest.
+//
+// When disabled, run() and the tick brackets cost one branch each.
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "relay/delta_sink.h"
+#include "relay/hal.h"
+#include "relay/latency_histogram.h"
+
+namespace relay_controller {
+
+class TickProfiler {
+ public:
+  static constexpr size_t kMaxSections = 16;
+  static constexpr uint8_t kNoSection = 0xff;
+  static constexpr uint32_t kDefaultOverrunUs = 20000;
+  static constexpr const char* kPathPrefix =
+      "sensors.relaycontroller.eventLoop.";
+  static constexpr const char* kOverrunPath =
+      "notifications.relaycontroller.eventLoop.overrun";
+
+  // Called from end_tick() for every overrun. worst_section is nullptr if no
+  // section ran during the tick.
+  using OverrunHandler = void (*)(uint32_t tick_us, const char* worst_section,
+                                  uint32_t worst_us);
+
+  void set_enabled(bool enabled) { enabled_ = enabled; }
+  bool enabled() const { return enabled_; }
+  void set_overrun_us(uint32_t overrun_us) { overrun_us_ = overrun_us; }
+  uint32_t overrun_us() const { return overrun_us_; }
+  void set_overrun_handler(OverrunHandler handler) {
+    overrun_handler_ = handler;
+  }
+
+  // Register a section. name must outlive the profiler. Returns kNoSection,
+  // which run() times as part of the tick only, once the table is full.
+  uint8_t add_section(const char* name);
+
+  void begin_tick() {
+    if (enabled_) {
+      tick_start_us_ = hal::now_us();
+      tick_sections_ = 0;
+      tick_worst_section_ = kNoSection;
+      tick_worst_us_ = 0;
+    }
+  }
+  void end_tick() {
+    if (enabled_) {
+      finish_tick(static_cast<uint32_t>(hal::now_us() - tick_start_us_));
+    }
+  }
+
+  // Run f as an occurrence of section.
+  template <typename F>
+  void run(uint8_t section, F&& f) {
+    if (!enabled_) {
+      f();
+      return;
+    }
+    uint64_t start = hal::now_us();
+    f();
+    record(section, static_cast<uint32_t>(hal::now_us() - start));
+  }
+
+  // Register a section and return a callback that runs f inside it, for
+  // event_loop()->onTick() and friends.
+  template <typename F>
+  auto profiled(const char* name, F f) {
+    uint8_t section = add_section(name);
+    return [this, section, f = std::move(f)]() mutable { run(section, f); };
+  }
+
+  // Send the current window as one delta and start a new window:
+  // tick.p50/p99/max in seconds, ticks, reactionsPerTick.max, overruns
+  // since boot, worstReaction, and max and time per section. The overrun
+  // notification is raised while the window had overruns and cleared
+  // otherwise. Returns false if nothing could be sent.
+  bool publish(DeltaSink* sink);
+
+  // Forget the current window.
+  void clear_window();
+
+  const LatencyHistogram& tick_histogram() const { return tick_histogram_; }
+  uint32_t overruns() const { return overruns_; }
+  uint32_t window_overruns() const { return window_overruns_; }
+  uint8_t max_sections_per_tick() const { return max_sections_per_tick_; }
+
+ private:
+  struct Section {
+    const char* name;
+    uint32_t calls;
+    uint32_t max_us;
+    uint64_t total_us;
+  };
+
+  void record(uint8_t section, uint32_t elapsed_us);
+  void finish_tick(uint32_t tick_us);
+
+  bool enabled_ = true;
+  uint32_t overrun_us_ = kDefaultOverrunUs;
+  OverrunHandler overrun_handler_ = nullptr;
+
+  Section sections_[kMaxSections] = {};
+  uint8_t section_count_ = 0;
+
+  uint64_t tick_start_us_ = 0;
+  uint8_t tick_sections_ = 0;
+  uint8_t tick_worst_section_ = kNoSection;
+  uint32_t tick_worst_us_ = 0;
+
+  LatencyHistogram tick_histogram_;
+  uint8_t max_sections_per_tick_ = 0;
+  uint32_t overruns_ = 0;
+  uint32_t window_overruns_ = 0;
+  bool overrun_raised_ = false;
+
+  char buffer_[2048];
+};
+
+}  // namespace relay_controller
+
+#endif  // RELAY_CONTROLLER_RELAY_TICK_PROFILER_H_
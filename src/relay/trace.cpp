@@ -0,0 +1,39 @@
+#include "relay/trace.h"
+
+#include <cstring>
+
+namespace relay_controller {
+
+size_t TraceRing::snapshot(TraceDumpHeader* header, TraceRecord* out,
+                           size_t max) const {
+  uint32_t end = head_.load(std::memory_order_acquire);
+  uint32_t begin = end > kCapacity ? end - kCapacity : 0;
+  if (end - begin > max) {
+    begin = end - max;
+  }
+  for (uint32_t i = begin; i < end; i++) {
+    out[i - begin] = records_[i % kCapacity];
+  }
+  // The slot of the event being recorded now, and of any recorded since,
+  // may have been overwritten while copying.
+  uint32_t after = head_.load(std::memory_order_acquire);
+  uint32_t first_valid = after >= kCapacity ? after - kCapacity + 1 : 0;
+  size_t skip = first_valid > begin ? first_valid - begin : 0;
+  if (skip > end - begin) {
+    skip = end - begin;
+  }
+  size_t count = end - begin - skip;
+  if (skip > 0) {
+    memmove(out, out + skip, count * sizeof(TraceRecord));
+  }
+
+  memcpy(header->magic, "RTRC", 4);
+  header->version = kDumpVersion;
+  header->record_size = sizeof(TraceRecord);
+  header->count = static_cast<uint16_t>(count);
+  header->now_us = static_cast<uint32_t>(hal::now_us());
+  header->lost = end - count;
+  return count;
+}
+
+}  // namespace relay_controller
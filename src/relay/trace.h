@@ -0,0 +1,133 @@
+#ifndef RELAY_CONTROLLER_RELAY_TRACE_H_
+#define RELAY_CONTROLLER_RELAY_TRACE_H_
+
+// Binary event trace for the switching path.
+//
+// Instead of formatting a log line where something happens, RELAY_TRACE()
+// stores an event ID, a timestamp and up to three raw arguments in a ring
+// of fixed-size records. That takes a handful of stores whatever the log
+// level, so switching latency no longer depends on it. The text is put
+// back together on the host: tools/trace_decode.py reads the formats from
+// RELAY_TRACE_EVENTS below and decodes a dump fetched from
+// /api/relays/trace or printed on the serial console.
+//
+// Only the main loop records; a dump may be taken from another task.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "relay/hal.h"
+
+namespace relay_controller {
+
+// X(name, format). IDs are positions in this list, so only append; the
+// arguments fill the format's %u conversions in order. The first argument
+// is stored in 16 bits, the other two in 32.
+#define RELAY_TRACE_EVENTS(X)                                                 \
+  X(kBoot, "boot, %u channels")                                               \
+  X(kRelaySet, "relay %u -> %u, source %u")                                   \
+  X(kGroupSet, "group of %u relays, %u changed, source %u")                   \
+  X(kButton, "button %u level %u")                                            \
+  X(kPut, "PUT relay %u = %u")                                                \
+  X(kScene, "scene %u PUT %u, %u relays changed")                             \
+  X(kDeltaSent, "delta sent, %u values, %u bytes")                            \
+  X(kDeltaFailed, "delta not sent, %u values pending")                        \
+  X(kHeartbeat, "heartbeat batch, %u channels")                               \
+  X(kTickOverrun, "tick over %u ms budget: %u us, worst reaction %u us")      \
+  X(kEdgeOverflow, "button edge ring overflowed, %u lost")                    \
+  X(kJournalRestore, "journal restore, %u channels from sector %u, %u us")    \
+  X(kJournalRollover, "journal moved to sector %u, generation %u")            \
+  X(kBootStage, "boot stage %u reached at %u us")                             \
+  X(kDeltaReplay, "%u channels replayed after %u ms offline")                 \
+  X(kApiRequest, "local API request for %u relays, %u changed")               \
+  X(kN2kAddress, "N2K address %u claimed after %u changes")                   \
+  X(kN2kControl, "N2K control of bank %u from address %u, %u changed")        \
+  X(kFlapStart, "channel %u flapping, %u changes in %u ms")                   \
+  X(kFlapEnd, "channel %u steady again")
+
+enum class TraceEvent : uint16_t {
+#define RELAY_TRACE_ENUM(name, format) name,
+  RELAY_TRACE_EVENTS(RELAY_TRACE_ENUM)
+#undef RELAY_TRACE_ENUM
+};
+
+// One event as it sits in the ring and in a dump, little-endian.
+struct TraceRecord {
+  uint32_t stamp_us;  // Low 32 bits of hal::now_us().
+  uint16_t event;
+  uint16_t arg0;
+  uint32_t arg1;
+  uint32_t arg2;
+};
+
+static_assert(sizeof(TraceRecord) == 16, "the dump format expects 16 bytes");
+
+// Dump header, followed by count records, oldest first.
+struct TraceDumpHeader {
+  char magic[4];  // "RTRC"
+  uint8_t version;
+  uint8_t record_size;
+  uint16_t count;
+  uint32_t now_us;  // Low 32 bits of hal::now_us() when the dump was taken.
+  uint32_t lost;    // Events recorded since boot but not in the dump.
+};
+
+static_assert(sizeof(TraceDumpHeader) == 16, "the dump format is packed");
+
+class TraceRing {
+ public:
+  static constexpr size_t kCapacity = 256;
+  static constexpr uint8_t kDumpVersion = 1;
+
+  void record(TraceEvent event, uint32_t arg0, uint32_t arg1, uint32_t arg2) {
+    uint32_t index = head_.load(std::memory_order_relaxed);
+    TraceRecord& r = records_[index % kCapacity];
+    r.stamp_us = static_cast<uint32_t>(hal::now_us());
+    r.event = static_cast<uint16_t>(event);
+    r.arg0 = static_cast<uint16_t>(arg0);
+    r.arg1 = arg1;
+    r.arg2 = arg2;
+    head_.store(index + 1, std::memory_order_release);
+  }
+
+  // Copy the recorded events, oldest first, into out and fill header.
+  // Returns the number copied. Events overwritten while copying are left
+  // out.
+  size_t snapshot(TraceDumpHeader* header, TraceRecord* out,
+                  size_t max) const;
+
+  uint32_t recorded() const { return head_.load(std::memory_order_acquire); }
+
+ private:
+  TraceRecord records_[kCapacity] = {};
+  std::atomic<uint32_t> head_{0};
+};
+
+// The ring RELAY_TRACE() records into. Constant-initialized, so taking it
+// costs no guard check.
+inline TraceRing& trace_ring() {
+  static TraceRing ring;
+  return ring;
+}
+
+inline void trace(TraceEvent event, uint32_t arg0 = 0, uint32_t arg1 = 0,
+                  uint32_t arg2 = 0) {
+  trace_ring().record(event, arg0, arg1, arg2);
+}
+
+}  // namespace relay_controller
+
+// RELAY_TRACE(kRelaySet, index, on, source) records up to three integer
+// arguments. Define RELAY_TRACE_DISABLED to compile tracing out.
+#ifdef RELAY_TRACE_DISABLED
+#define RELAY_TRACE(event, ...) \
+  do {                          \
+  } while (0)
+#else
+#define RELAY_TRACE(event, ...)                                   \
+  ::relay_controller::trace(::relay_controller::TraceEvent::event, \
+                            ##__VA_ARGS__)
+#endif
+
+#endif  // RELAY_CONTROLLER_RELAY_TRACE_H_
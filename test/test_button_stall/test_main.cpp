@@ -0,0 +1,146 @@
+// Button presses through EdgeCapture and BankDebouncer while the event loop
+// runs and while it is stalled. Run with: pio test -e native
+
+#include <unity.h>
+
+#include "native/sim_hw.h"
+#include "native/sim_sensesp.h"
+#include "relay/bank_debouncer.h"
+#include "relay/edge_capture.h"
+#include "relay/relay_bank.h"
+
+using relay_controller::BankDebouncer;
+using relay_controller::ChannelSpec;
+using relay_controller::EdgeCapture;
+using relay_controller::kNoPin;
+using relay_controller::RelayBank;
+
+namespace {
+
+constexpr int kButtonPin = 0;
+constexpr int kRelayPin = 256;
+constexpr uint32_t kDebounceMs = 50;
+
+struct Rig {
+  Rig() {
+    sim::reset();
+    ChannelSpec spec = {{kButtonPin, kNoPin, kRelayPin},
+                        "electrical.switches.test.state"};
+    bank.begin(&spec, false);
+    capture.begin(bank);
+    debouncer.begin(bank, kDebounceMs);
+  }
+
+  // Run the event loop for ms, one tick per millisecond.
+  void run(uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+      sim::advance_clock(1000);
+      capture.drain(&debouncer);
+      debouncer.tick(&bank);
+    }
+  }
+
+  // Let ms pass without a tick, as in a WiFi reconnect or an OTA write.
+  void stall(uint32_t ms) { sim::advance_clock(ms * 1000); }
+
+  RelayBank<1> bank;
+  EdgeCapture<1> capture;
+  BankDebouncer<1> debouncer;
+};
+
+void test_press_while_running_toggles_once() {
+  Rig rig;
+  rig.run(10);
+  sim::drive_input(kButtonPin, false);
+  rig.run(200);
+  sim::drive_input(kButtonPin, true);
+  rig.run(200);
+  TEST_ASSERT_TRUE(rig.bank.state(0));
+  TEST_ASSERT_EQUAL_UINT32(0, rig.debouncer.missed_presses());
+}
+
+void test_press_during_stall_toggles_once() {
+  Rig rig;
+  rig.run(10);
+  sim::drive_input(kButtonPin, false);
+  rig.stall(200);
+  sim::drive_input(kButtonPin, true);
+  rig.stall(200);
+  rig.run(200);
+  TEST_ASSERT_EQUAL_UINT32(0, rig.capture.overflows());
+  TEST_ASSERT_TRUE(rig.bank.state(0));
+  TEST_ASSERT_EQUAL_UINT32(1, rig.debouncer.missed_presses());
+}
+
+void test_bouncy_press_during_stall_toggles_once() {
+  Rig rig;
+  rig.run(10);
+  for (int bounce = 0; bounce < 3; bounce++) {
+    sim::drive_input(kButtonPin, false);
+    rig.stall(1);
+    sim::drive_input(kButtonPin, true);
+    rig.stall(1);
+  }
+  sim::drive_input(kButtonPin, false);
+  rig.stall(200);
+  sim::drive_input(kButtonPin, true);
+  rig.stall(1);
+  sim::drive_input(kButtonPin, false);
+  rig.stall(1);
+  sim::drive_input(kButtonPin, true);
+  rig.run(200);
+  TEST_ASSERT_TRUE(rig.bank.state(0));
+}
+
+void test_two_presses_during_stall_toggle_twice() {
+  Rig rig;
+  rig.run(10);
+  for (int press = 0; press < 2; press++) {
+    sim::drive_input(kButtonPin, false);
+    rig.stall(100);
+    sim::drive_input(kButtonPin, true);
+    rig.stall(100);
+  }
+  rig.run(200);
+  TEST_ASSERT_FALSE(rig.bank.state(0));
+  TEST_ASSERT_EQUAL_UINT32(2, rig.debouncer.missed_presses());
+}
+
+void test_glitch_during_stall_is_ignored() {
+  Rig rig;
+  rig.run(10);
+  sim::drive_input(kButtonPin, false);
+  rig.stall(10);
+  sim::drive_input(kButtonPin, true);
+  rig.stall(200);
+  rig.run(200);
+  TEST_ASSERT_FALSE(rig.bank.state(0));
+}
+
+void test_press_held_past_stall_toggles_once() {
+  Rig rig;
+  rig.run(10);
+  sim::drive_input(kButtonPin, false);
+  rig.stall(200);
+  rig.run(100);
+  sim::drive_input(kButtonPin, true);
+  rig.run(200);
+  TEST_ASSERT_TRUE(rig.bank.state(0));
+  TEST_ASSERT_EQUAL_UINT32(0, rig.debouncer.missed_presses());
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_press_while_running_toggles_once);
+  RUN_TEST(test_press_during_stall_toggles_once);
+  RUN_TEST(test_bouncy_press_during_stall_toggles_once);
+  RUN_TEST(test_two_presses_during_stall_toggle_twice);
+  RUN_TEST(test_glitch_during_stall_is_ignored);
+  RUN_TEST(test_press_held_past_stall_toggles_once);
+  return UNITY_END();
+}
@@ -0,0 +1,66 @@
+// Relay writes to an I2C expander that the chip does not acknowledge are
+// repeated on the next flush. Run with: pio test -e native
+
+#include <unity.h>
+
+#include "native/sim_hw.h"
+#include "native/sim_i2c.h"
+#include "relay/i2c_expander.h"
+
+using relay_controller::I2cExpanderBank;
+
+namespace {
+
+constexpr int kInterruptPin = 760;
+constexpr int kRelayPin = 3;
+
+void check_retry(sim::SimExpander::Model sim_model,
+                 I2cExpanderBank::Model model) {
+  sim::reset_hw();
+  sim::SimI2cBus bus(kInterruptPin);
+  sim::SimExpander chip(sim_model);
+  bus.attach(0x20, &chip);
+  I2cExpanderBank expander(&bus, model, 0x20, 1);
+  TEST_ASSERT_TRUE(expander.begin());
+  expander.configure(kRelayPin);
+  expander.flush();
+
+  bus.set_nak(true);
+  expander.stage(kRelayPin, true);
+  expander.flush();
+  TEST_ASSERT_EQUAL_UINT32(1, expander.bus_errors());
+  uint64_t before = chip.last_output_ns();
+
+  bus.set_nak(false);
+  bus.reset_stats();
+  expander.flush();
+  TEST_ASSERT_EQUAL_UINT32(1, static_cast<uint32_t>(bus.transactions()));
+  TEST_ASSERT_TRUE(chip.last_output_ns() > before);
+
+  // Nothing left to write.
+  bus.reset_stats();
+  expander.flush();
+  TEST_ASSERT_EQUAL_UINT32(0, static_cast<uint32_t>(bus.transactions()));
+}
+
+void test_mcp23017_retries_unacknowledged_write() {
+  check_retry(sim::SimExpander::Model::kMcp23017,
+              I2cExpanderBank::Model::kMcp23017);
+}
+
+void test_pcf8575_retries_unacknowledged_write() {
+  check_retry(sim::SimExpander::Model::kPcf8575,
+              I2cExpanderBank::Model::kPcf8575);
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_mcp23017_retries_unacknowledged_write);
+  RUN_TEST(test_pcf8575_retries_unacknowledged_write);
+  return UNITY_END();
+}
@@ -0,0 +1,59 @@
+// LatencyHistogram past the point where a bucket overflows and the buckets
+// are halved. Run with: pio test -e native
+
+#include <unity.h>
+
+#include "relay/latency_histogram.h"
+
+using relay_controller::LatencyHistogram;
+
+namespace {
+
+void test_count_survives_halving() {
+  LatencyHistogram h;
+  for (uint32_t i = 0; i < 200000; i++) {
+    h.record(100);
+  }
+  TEST_ASSERT_EQUAL_UINT32(200000, h.count());
+  uint32_t in_buckets = 0;
+  for (size_t i = 0; i < LatencyHistogram::kBuckets; i++) {
+    in_buckets += h.bucket_count(i);
+  }
+  TEST_ASSERT_TRUE(in_buckets < 200000);
+  TEST_ASSERT_EQUAL_UINT32(100, h.percentile(50));
+}
+
+void test_percentiles_decay_to_recent_samples() {
+  LatencyHistogram h;
+  for (uint32_t i = 0; i < 70000; i++) {
+    h.record(10);
+  }
+  for (uint32_t i = 0; i < 70000; i++) {
+    h.record(5000);
+  }
+  // 70000 samples each, but the older ones were halved.
+  TEST_ASSERT_EQUAL_UINT32(140000, h.count());
+  TEST_ASSERT_TRUE(h.percentile(50) >= 4096);
+  TEST_ASSERT_EQUAL_UINT32(5000, h.max_us());
+}
+
+void test_clear_resets_count() {
+  LatencyHistogram h;
+  h.record(10);
+  h.clear();
+  TEST_ASSERT_EQUAL_UINT32(0, h.count());
+  TEST_ASSERT_EQUAL_UINT32(0, h.percentile(50));
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_count_survives_halving);
+  RUN_TEST(test_percentiles_decay_to_recent_samples);
+  RUN_TEST(test_clear_resets_count);
+  return UNITY_END();
+}
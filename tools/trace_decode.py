@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Decode a relay controller trace dump into text.
+
+The dump is either the binary body of GET /api/relays/trace, or a serial
+console log containing the "@trace <hex>" lines the device prints when sent
+"t". Event formats are read from RELAY_TRACE_EVENTS in src/relay/trace.h, so
+the decoder always matches the firmware built from the same tree.
+
+    curl -s http://<device>/api/relays/trace | tools/trace_decode.py
+    tools/trace_decode.py monitor.log
+"""
+
+import argparse
+import pathlib
+import re
+import struct
+import sys
+
+HEADER = struct.Struct("<4sBBHII")
+RECORD = struct.Struct("<IHHII")
+MAGIC = b"RTRC"
+VERSION = 1
+
+DEFAULT_HEADER = pathlib.Path(__file__).resolve().parent.parent / "src" / "relay" / "trace.h"
+
+
+def load_formats(header_path):
+    text = pathlib.Path(header_path).read_text()
+    block = re.search(r"#define RELAY_TRACE_EVENTS\(X\)(.*?)\n\n", text, re.S)
+    if block is None:
+        sys.exit(f"{header_path}: RELAY_TRACE_EVENTS not found")
+    return re.findall(r'X\((k\w+),\s*"((?:[^"\\]|\\.)*)"\)', block.group(1))
+
+
+def read_dump(data):
+    """Return the binary dump from raw bytes or from a console log."""
+    if data.startswith(MAGIC):
+        return data
+    lines = re.findall(rb"@trace ([0-9a-f]+)", data)
+    if not lines:
+        sys.exit("no trace dump found in input")
+    # A log may hold several dumps; decode the last one.
+    starts = [i for i, line in enumerate(lines) if bytes.fromhex(line.decode()).startswith(MAGIC)]
+    if not starts:
+        sys.exit("no trace dump header found in input")
+    return b"".join(bytes.fromhex(line.decode()) for line in lines[starts[-1]:])
+
+
+def decode(dump, formats):
+    magic, version, record_size, count, now_us, lost = HEADER.unpack_from(dump)
+    if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+        sys.exit(f"unsupported dump: version {version}, record size {record_size}")
+    available = (len(dump) - HEADER.size) // RECORD.size
+    if available < count:
+        print(f"# dump truncated: {available} of {count} records", file=sys.stderr)
+        count = available
+    print(f"# {count} events, {lost} earlier events not in the dump")
+    for i in range(count):
+        stamp_us, event, arg0, arg1, arg2 = RECORD.unpack_from(dump, HEADER.size + i * RECORD.size)
+        age_ms = ((now_us - stamp_us) & 0xFFFFFFFF) / 1000.0
+        if event < len(formats):
+            name, fmt = formats[event]
+            conversions = fmt.count("%u")
+            text = fmt % (arg0, arg1, arg2)[:conversions]
+        else:
+            name, text = f"event{event}", f"{arg0} {arg1} {arg2}"
+        print(f"{stamp_us:10d} us  -{age_ms:10.3f} ms  {name:<14} {text}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("dump", nargs="?", default="-", help="dump or log file, - for stdin")
+    parser.add_argument("--formats", default=DEFAULT_HEADER, help="path to src/relay/trace.h")
+    args = parser.parse_args()
+    data = sys.stdin.buffer.read() if args.dump == "-" else pathlib.Path(args.dump).read_bytes()
+    decode(read_dump(data), load_formats(args.formats))
+
+
+if __name__ == "__main__":
+    main()